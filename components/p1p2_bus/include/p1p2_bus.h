@@ -36,6 +36,11 @@ typedef struct {
     bool enable_adc;        /* enable bus voltage monitoring */
     bool echo_writes;       /* read-back written bytes for verification (default true) */
     uint8_t allow_pause;    /* max inter-byte pause in bit-times before EOP (default 9) */
+    bool auto_pause;        /* tune allow_pause down from observed gaps (default true) */
+    bool learn_lengths;     /* learn expected packet lengths for early EOP (default true) */
+    p1p2_queue_policy_t rx_policy;  /* default RX queue overflow policy (default drop newest; not block) */
+    p1p2_queue_policy_t tx_policy;  /* write request queue overflow policy (default block) */
+    uint16_t tx_block_ms;   /* wait for P1P2_QUEUE_BLOCK on the TX queue (default 100) */
 } p1p2_bus_config_t;
 
 /* Default configuration macro */
@@ -51,6 +56,11 @@ typedef struct {
     .enable_adc     = true, \
     .echo_writes    = true, \
     .allow_pause    = P1P2_ALLOW_PAUSE_BETWEEN_BYTES, \
+    .auto_pause     = true, \
+    .learn_lengths  = true, \
+    .rx_policy      = P1P2_QUEUE_DROP_NEWEST, \
+    .tx_policy      = P1P2_QUEUE_BLOCK, \
+    .tx_block_ms    = 100, \
 }
 
 /*
@@ -79,6 +89,62 @@ QueueHandle_t p1p2_bus_get_rx_queue(void);
  */
 QueueHandle_t p1p2_bus_get_tx_queue(void);
 
+/*
+ * Subscribe to received packets matching a filter.
+ * Creates a queue of `depth` p1p2_packet_t entries and returns it in
+ * *queue_out. Each packet is matched once against all subscribers and
+ * copied to every matching queue (non-blocking; a full queue drops it).
+ * The default RX queue (p1p2_bus_get_rx_queue) is itself a subscriber
+ * matching everything, so extra consumers never steal its packets.
+ * Returns ESP_ERR_NO_MEM when all P1P2_MAX_SUBSCRIBERS slots are taken.
+ */
+esp_err_t p1p2_bus_subscribe(const p1p2_packet_filter_t *filter, uint8_t depth,
+                             QueueHandle_t *queue_out);
+
+/*
+ * Remove a subscription created by p1p2_bus_subscribe and delete its queue.
+ */
+esp_err_t p1p2_bus_unsubscribe(QueueHandle_t queue);
+
+/*
+ * Set the overflow policy of a subscriber queue (including the default
+ * RX queue) or of the write request queue. block_ms is only used with
+ * P1P2_QUEUE_BLOCK, which only the write request queue takes: subscribers
+ * are fed by the bus I/O task, which must never wait on a slow reader
+ * (ESP_ERR_NOT_SUPPORTED). Returns ESP_ERR_NOT_FOUND for any other queue.
+ */
+esp_err_t p1p2_bus_set_queue_policy(QueueHandle_t queue, p1p2_queue_policy_t policy,
+                                    uint16_t block_ms);
+
+/*
+ * Post item to q according to policy (p1p2_queue_policy.c). With
+ * P1P2_QUEUE_DROP_OLDEST and a full queue, the oldest item is taken out
+ * into evicted (item-sized) and *n_evicted is set to 1. block_ms is only
+ * used with P1P2_QUEUE_BLOCK.
+ * Returns ESP_OK if item was queued, ESP_ERR_TIMEOUT if it was dropped.
+ */
+esp_err_t p1p2_queue_post(QueueHandle_t q, const void *item, p1p2_queue_policy_t policy,
+                          uint16_t block_ms, void *evicted, uint8_t *n_evicted);
+
+/*
+ * Number of received packets of the given type dropped on full subscriber
+ * queues since init (saturates at 0xFFFF).
+ */
+uint16_t p1p2_bus_get_type_drops(uint8_t type);
+
+/*
+ * Reset drop counters and high-water marks.
+ */
+void p1p2_bus_reset_queue_stats(void);
+
+/*
+ * Get the queue handle for transmit confirmations (p1p2_tx_confirm_t).
+ * With echo_writes enabled, every packet we write is read back from the bus
+ * and posted here rather than to the RX queue, so our own responses are not
+ * decoded as bus traffic.
+ */
+QueueHandle_t p1p2_bus_get_tx_confirm_queue(void);
+
 /*
  * Read a complete packet (blocking).
  * Convenience wrapper: blocks until a packet is available or timeout.
@@ -96,6 +162,18 @@ esp_err_t p1p2_bus_write_packet(const uint8_t *data, uint8_t length,
                                  uint16_t delay_ms,
                                  uint8_t crc_gen, uint8_t crc_feed);
 
+/*
+ * Write a packet in the next predicted idle window (p1p2_bus_schedule.h)
+ * long enough for it, instead of after a fixed delay. For writes that are
+ * not answers to a request, such as parameter writes and counter requests.
+ * The packet waits while no window is predicted (no learned schedule
+ * yet); if none opens within P1P2_IDLE_WRITE_MAX_WAIT_MS of it reaching
+ * the head of the queue, it is dropped and counted (tx_idle_expired).
+ * Returns ESP_ERR_TIMEOUT if P1P2_IDLE_WRITE_QUEUE_SIZE writes are waiting.
+ */
+esp_err_t p1p2_bus_write_packet_idle(const uint8_t *data, uint8_t length,
+                                     uint8_t crc_gen, uint8_t crc_feed);
+
 /*
  * Check if a packet is available in the RX queue (non-blocking).
  */
@@ -113,9 +191,20 @@ void p1p2_bus_set_echo(bool echo);
 
 /*
  * Set the max inter-byte pause (in bit times) before end-of-packet detection.
+ * With auto_pause enabled this is the ceiling for the tuned value.
  */
 void p1p2_bus_set_allow_pause(uint8_t bit_times);
 
+/*
+ * Set the expected total length (including CRC) of packets with the given
+ * source address and packet type. The RX ISR then signals end-of-packet as
+ * soon as the final byte's stop bit is sampled, instead of waiting for the
+ * EOP timeout. A fixed length is never overridden by the learner.
+ * length 0 removes the entry (timeout-based EOP only).
+ * Returns ESP_ERR_NO_MEM if the table has no free slot for this key.
+ */
+esp_err_t p1p2_bus_set_expected_length(uint8_t src, uint8_t type, uint8_t length);
+
 /*
  * Get current ADC results and reset min/max.
  */
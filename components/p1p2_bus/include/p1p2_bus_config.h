@@ -27,6 +27,12 @@ extern "C" {
 #define TICKS_PER_SEMIBIT          416      /* 52.08 µs  */
 #define TICKS_PER_BIT_AND_SEMIBIT  1249     /* 156.25 µs */
 
+/* Capture timer ticks per microsecond (for timestamp conversion) */
+#define TICKS_PER_US               (P1P2_TIMER_FREQ_HZ / 1000000)
+
+/* Bits per byte on the wire: start + 8 data + parity + stop */
+#define P1P2_BITS_PER_BYTE         11
+
 /* Suppression zone: ignore edges within 3/4 of a semibit after previous edge */
 #define TICKS_SUPPRESSION          (TICKS_PER_SEMIBIT + TICKS_PER_SEMIBIT / 4)
 
@@ -51,9 +57,45 @@ extern "C" {
 /* Allow pause between bytes (in bit times) before signaling end-of-packet */
 #define P1P2_ALLOW_PAUSE_BETWEEN_BYTES  9
 
+/*
+ * allow_pause auto-tuning: after every window of packets, allow_pause is set
+ * to the largest observed inter-byte gap plus a margin, never below the
+ * minimum and never above the configured value.
+ */
+#define P1P2_ALLOW_PAUSE_MIN            2
+#define P1P2_ALLOW_PAUSE_MARGIN         2
+#define P1P2_ALLOW_PAUSE_WINDOW         64   /* packets per tuning window */
+
+/*
+ * Expected packet lengths per (source, type) for early EOP detection.
+ * Table size must be a power of 2; lookups probe at most
+ * P1P2_EXPECT_MAX_PROBE slots so the ISR cost stays bounded.
+ */
+#define P1P2_EXPECT_TABLE_SIZE          64
+#define P1P2_EXPECT_MAX_PROBE           8
+#define P1P2_EXPECT_LEARN_COUNT         4    /* identical lengths before trusting */
+#define P1P2_EXPECT_HASH(src, type) \
+    (((type) ^ ((src) >> 2)) & (P1P2_EXPECT_TABLE_SIZE - 1))
+
+/* A packet starting within this many ms of the previous EOP was split */
+#define P1P2_SPLIT_PACKET_MS            2
+
 /* Ring buffer for assembled packets passed to protocol task */
 #define P1P2_PACKET_QUEUE_SIZE     8
 
+/* Packet subscribers, including the default RX queue (max 8: bitmap per type) */
+#define P1P2_MAX_SUBSCRIBERS       8
+
+/* Transmit confirmations (echoed packets) passed to the protocol task */
+#define P1P2_TX_CONFIRM_QUEUE_SIZE 4
+
+/*
+ * Writes waiting for a predicted idle window. A write that finds none
+ * within the max wait is dropped, not sent on a silence timeout.
+ */
+#define P1P2_IDLE_WRITE_QUEUE_SIZE      4
+#define P1P2_IDLE_WRITE_MAX_WAIT_MS     5000
+
 /* NO_HEAD2 sentinel — indicates no pending byte in rx_buffer_head2 */
 #define P1P2_NO_HEAD2              0xFF
 
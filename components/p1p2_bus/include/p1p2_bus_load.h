@@ -0,0 +1,58 @@
+/*
+ * P1P2 Bus Load — Bus utilization over rolling 1 s / 1 min / 15 min windows
+ *
+ * Busy time is the span from the first start bit to the last stop bit of
+ * each packet (p1p2_packet_t start_us..eop_us); everything else is idle.
+ * Our own transmissions (echoed packets) are tracked separately so the
+ * share of the bus used by this device is known.
+ *
+ * Constant memory: 60 one-second slots feeding 15 one-minute slots.
+ *
+ * ESP32-C6 port: 2026
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "p1p2_bus_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Load values are in 0.1 % units (0-1000) */
+typedef struct {
+    uint16_t load_1s;           /* last complete second */
+    uint16_t load_1m;           /* last 60 complete seconds */
+    uint16_t load_15m;          /* last 15 complete minutes */
+    uint16_t tx_share_1m;       /* our share of busy time, last minute */
+    uint16_t tx_share_15m;      /* our share of busy time, last 15 minutes */
+    uint16_t packets_1m;        /* packets seen in the last minute */
+} p1p2_bus_load_t;
+
+/* Create the lock and clear the windows. Called by p1p2_bus_init(). */
+esp_err_t p1p2_bus_load_init(void);
+
+/*
+ * Account a completed packet. Called from bus_io_task.
+ * own_tx: the packet is the read-back of our own transmission.
+ */
+void p1p2_bus_load_record(const p1p2_packet_t *pkt, bool own_tx);
+
+/*
+ * Get current bus load. Windows are advanced to the current time first,
+ * so a silent bus reads as 0 % rather than the last busy value.
+ */
+void p1p2_bus_get_load(p1p2_bus_load_t *out);
+
+/*
+ * As p1p2_bus_get_load(), with the windows advanced to now_us on the
+ * packet clock (esp_timer µs) — for replayed traces and tests.
+ */
+void p1p2_bus_get_load_at(int64_t now_us, p1p2_bus_load_t *out);
+
+#ifdef __cplusplus
+}
+#endif
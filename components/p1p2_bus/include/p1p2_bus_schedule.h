@@ -0,0 +1,72 @@
+/*
+ * P1P2 Bus Schedule — Learned packet order and predicted idle windows
+ *
+ * The F-series bus repeats a fixed cycle of request/response exchanges.
+ * For every (source, destination, type) this learns the packet's duration,
+ * the idle time that follows it, and which packet usually comes next. From
+ * the last packet seen, the learned chain is walked forward to predict when
+ * the bus will be quiet long enough for a write of a given length.
+ *
+ * Updated by bus_io_task for every completed packet, including our own
+ * echoed responses (they take bus time like any other packet).
+ *
+ * ESP32-C6 port: 2026
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "p1p2_bus_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Table size (power of 2) and probe limit */
+#define P1P2_SCHED_MAX_ENTRIES     64
+#define P1P2_SCHED_MAX_PROBE       8
+
+/* Observations of a gap, or of the same successor, before it is predicted */
+#define P1P2_SCHED_MIN_HITS        3
+
+/* Kept clear of predicted packets on either side of a window */
+#define P1P2_SCHED_GUARD_US        3000
+
+/* Bus silent for longer than this: the schedule no longer predicts anything */
+#define P1P2_SCHED_STALE_US        2000000
+
+typedef struct {
+    int64_t  start_us;          /* window opens (esp_timer_get_time() timebase) */
+    uint32_t len_us;            /* predicted idle time from start_us, guard excluded */
+    uint8_t  after_src;         /* packet the window follows */
+    uint8_t  after_dst;
+    uint8_t  after_type;
+} p1p2_idle_window_t;
+
+/* Create the lock. Called by p1p2_bus_init(). */
+esp_err_t p1p2_bus_schedule_init(void);
+
+/*
+ * Record a completed packet. Called from bus_io_task.
+ */
+void p1p2_bus_schedule_record(const p1p2_packet_t *pkt);
+
+/*
+ * Predict the next idle window of at least min_len_us, starting no earlier
+ * than now. A window that is already open starts now.
+ * Returns ESP_ERR_INVALID_STATE before the first packet or after
+ * P1P2_SCHED_STALE_US of silence, ESP_ERR_NOT_FOUND if the learned chain
+ * ends (or runs a full cycle) without a long enough window.
+ */
+esp_err_t p1p2_bus_next_idle_window(uint32_t min_len_us, p1p2_idle_window_t *out);
+
+/*
+ * Forget the learned schedule.
+ */
+void p1p2_bus_schedule_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
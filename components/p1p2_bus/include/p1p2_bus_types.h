@@ -26,10 +26,11 @@ extern "C" {
 #define P1P2_ERROR_OR       0x08  /* Read buffer overrun */
 #define P1P2_ERROR_CRC_CS   0x10  /* CRC or checksum error */
 #define P1P2_ERROR_BC       0x20  /* High bit half read-back error (bus collision) */
+#define P1P2_SIGNAL_ECHO    0x40  /* Read-back of our own transmitted byte (not an error) */
 #define P1P2_SIGNAL_EOP     0x80  /* End of packet signal (not an error) */
 
-/* Error mask: all real errors, excluding EOP signal */
-#define P1P2_ERROR_MASK     0x7F
+/* Error mask: all real errors, excluding ECHO and EOP signals */
+#define P1P2_ERROR_MASK     0x3F
 
 typedef uint8_t p1p2_error_t;
 
@@ -95,10 +96,22 @@ typedef enum {
 
 /*
  * Assembled packet — passed from bus I/O task to protocol task via queue.
+ *
+ * Timestamps are in microseconds on the esp_timer_get_time() timebase.
+ * They are derived from the hardware capture timer (8 MHz), so intervals
+ * within a packet are exact to the tick. The offset to esp_timer is
+ * re-anchored at the first start bit of every packet (esp_timer read in
+ * the ISR), so intervals between packets also carry the difference in ISR
+ * latency at the two anchors and are not exact to the tick.
  */
 typedef struct {
     uint8_t  data[P1P2_MAX_PACKET_SIZE];
     p1p2_error_t errors[P1P2_MAX_PACKET_SIZE];
+    int64_t  start_us;          /* falling edge of the first start bit */
+    int64_t  eop_us;            /* end of the last stop bit */
+#ifdef CONFIG_P1P2_BYTE_TIMESTAMPS
+    uint16_t byte_offset_us[P1P2_MAX_PACKET_SIZE]; /* start bit of byte i, relative to start_us */
+#endif
     uint16_t delta;             /* ms since previous byte/packet */
     uint8_t  length;            /* number of bytes in packet */
     bool     has_error;         /* true if any byte has a non-zero error flag */
@@ -115,6 +128,57 @@ typedef struct {
     uint8_t  crc_feed;          /* CRC initial value */
 } p1p2_write_request_t;
 
+/*
+ * Queue overflow policy — what a producer does when a queue is full.
+ */
+typedef enum {
+    P1P2_QUEUE_DROP_NEWEST = 0, /* discard the item being posted */
+    P1P2_QUEUE_DROP_OLDEST,     /* discard the oldest queued item to make room */
+    P1P2_QUEUE_BLOCK,           /* wait up to block_ms, then drop the new item
+                                   (task-side queues only, never bus I/O) */
+} p1p2_queue_policy_t;
+
+/*
+ * Packet subscription filter — a consumer receives a packet when its type
+ * bit is set in type_mask and the optional source/destination match.
+ * Packets shorter than 3 bytes have no type and go only to filters with
+ * short_packets set.
+ */
+typedef struct {
+    uint32_t type_mask[8];      /* 256-bit mask, bit t = packet type t */
+    uint8_t  src;               /* required source address (if match_src) */
+    uint8_t  dst;               /* required destination address (if match_dst) */
+    bool     match_src;
+    bool     match_dst;
+    bool     short_packets;
+} p1p2_packet_filter_t;
+
+/* Filter matching every packet */
+#define P1P2_PACKET_FILTER_ALL() { \
+    .type_mask = { 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, \
+                   0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF }, \
+    .short_packets = true, \
+}
+
+static inline void p1p2_filter_add_type(p1p2_packet_filter_t *f, uint8_t type)
+{
+    f->type_mask[type >> 5] |= (1UL << (type & 31));
+}
+
+/*
+ * Transmit confirmation — the read-back (echo) of a packet we wrote,
+ * delivered by bus I/O task instead of being queued as received traffic.
+ * errors[] holds the per-byte read-back flags (SB/BE/BC/OR).
+ */
+typedef struct {
+    uint8_t  data[P1P2_MAX_PACKET_SIZE];
+    p1p2_error_t errors[P1P2_MAX_PACKET_SIZE];
+    int64_t  start_us;          /* start bit of the first byte sent */
+    int64_t  eop_us;            /* end of the last stop bit */
+    uint8_t  length;            /* number of bytes read back */
+    bool     ok;                /* true if every byte read back without error */
+} p1p2_tx_confirm_t;
+
 /*
  * ADC measurement results — bus voltage monitoring.
  */
@@ -137,6 +201,19 @@ typedef struct {
     uint32_t parity_errors;
     uint32_t collision_errors;
     uint32_t overrun_errors;
+    uint32_t tx_confirmed;      /* echoed packets read back without error */
+    uint32_t tx_readback_errors;/* echoed packets with read-back errors */
+    uint32_t rx_dropped;        /* packets dropped on full subscriber queues */
+    uint32_t tx_dropped;        /* write requests dropped on a full TX queue */
+    uint32_t tx_idle_windows;   /* idle-window writes sent in a predicted window */
+    uint32_t tx_idle_expired;   /* idle-window writes dropped: no window in time */
+    uint8_t  rx_ring_hwm;       /* ISR RX ring peak occupancy (bytes) */
+    uint8_t  tx_ring_hwm;       /* TX byte ring peak occupancy (bytes) */
+    uint8_t  rx_queue_hwm;      /* default RX packet queue peak (packets) */
+    uint8_t  tx_queue_hwm;      /* write request queue peak (requests) */
+    uint32_t early_eop_packets; /* completed on expected length, before EOP timeout */
+    uint32_t early_eop_mispredicts; /* expected length was too short (packet split) */
+    uint8_t  allow_pause;       /* current EOP pause in bit times (auto-tuned) */
     int64_t  uptime_us;         /* from esp_timer_get_time() */
 } p1p2_bus_stats_t;
 
@@ -0,0 +1,25 @@
+/*
+ * P1P2 CRC — Packet CRC as used by Daikin (F-series: generator 0xD9, feed 0x00)
+ *
+ * Original: Copyright (c) 2019-2024 Arnold Niessen — CC BY-NC-ND 4.0
+ * ESP32-C6 port: 2026
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * CRC over length bytes, LSB first. A packet with its CRC byte appended
+ * gives 0.
+ */
+uint8_t p1p2_crc_calc(const uint8_t *data, uint8_t length,
+                      uint8_t crc_gen, uint8_t crc_feed);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,77 @@
+/*
+ * P1P2 Histograms — Fixed-size log2-bucket histograms for timing statistics
+ *
+ * Bucket b holds values in [2^(b-1), 2^b), bucket 0 holds 0. With
+ * P1P2_HIST_BUCKETS = 24 the last bucket collects everything >= ~4.2 s
+ * (for microsecond samples). Counts saturate at 0xFFFF.
+ *
+ * ESP32-C6 port: 2026
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define P1P2_HIST_BUCKETS   24
+
+typedef struct {
+    uint16_t bucket[P1P2_HIST_BUCKETS];
+} p1p2_hist_t;
+
+static inline uint8_t p1p2_hist_bucket(uint32_t value)
+{
+    uint8_t b = value ? (uint8_t)(32 - __builtin_clz(value)) : 0;
+    return (b < P1P2_HIST_BUCKETS) ? b : P1P2_HIST_BUCKETS - 1;
+}
+
+static inline void p1p2_hist_add(p1p2_hist_t *h, uint32_t value)
+{
+    uint16_t *c = &h->bucket[p1p2_hist_bucket(value)];
+    if (*c < 0xFFFF) (*c)++;
+}
+
+static inline void p1p2_hist_reset(p1p2_hist_t *h)
+{
+    memset(h, 0, sizeof(*h));
+}
+
+static inline uint32_t p1p2_hist_count(const p1p2_hist_t *h)
+{
+    uint32_t n = 0;
+    for (int i = 0; i < P1P2_HIST_BUCKETS; i++) n += h->bucket[i];
+    return n;
+}
+
+/* Upper bound of bucket b (largest value it can hold) */
+static inline uint32_t p1p2_hist_bucket_max(uint8_t b)
+{
+    return b ? (uint32_t)((1ULL << b) - 1) : 0;
+}
+
+/*
+ * Approximate percentile (0-100): upper bound of the bucket containing it.
+ * Returns 0 for an empty histogram.
+ */
+static inline uint32_t p1p2_hist_percentile(const p1p2_hist_t *h, uint8_t pct)
+{
+    uint32_t total = p1p2_hist_count(h);
+    if (total == 0) return 0;
+
+    uint32_t rank = (total * pct + 99) / 100;
+    if (rank == 0) rank = 1;
+    uint32_t seen = 0;
+    for (uint8_t b = 0; b < P1P2_HIST_BUCKETS; b++) {
+        seen += h->bucket[b];
+        if (seen >= rank) return p1p2_hist_bucket_max(b);
+    }
+    return p1p2_hist_bucket_max(P1P2_HIST_BUCKETS - 1);
+}
+
+#ifdef __cplusplus
+}
+#endif
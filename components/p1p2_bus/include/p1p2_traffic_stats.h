@@ -0,0 +1,70 @@
+/*
+ * P1P2 Traffic Statistics — Per (source, destination, type) packet counters
+ *
+ * Updated by bus_io_task for every completed packet, including our own
+ * echoed responses. Fixed-size open-addressed table; each update is a
+ * hash, a short probe and a handful of counter increments.
+ *
+ * ESP32-C6 port: 2026
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "p1p2_bus_types.h"
+#include "p1p2_hist.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Table size (power of 2) and probe limit */
+#define P1P2_TRAFFIC_MAX_ENTRIES   64
+#define P1P2_TRAFFIC_MAX_PROBE     8
+
+typedef struct {
+    uint8_t  src;
+    uint8_t  dst;
+    uint8_t  type;
+    uint8_t  len_min;
+    uint8_t  len_max;
+    uint32_t count;
+    uint32_t errors;            /* packets with any byte error flag */
+    uint32_t len_sum;           /* for the average length */
+    int64_t  last_start_us;     /* start of the most recent packet */
+    p1p2_hist_t gap_us;         /* bus idle time before this packet */
+    p1p2_hist_t period_us;      /* time since the previous packet of this key */
+} p1p2_traffic_entry_t;
+
+/*
+ * Create the table lock and clear the table. Called from p1p2_bus_init()
+ * before bus_io_task starts.
+ */
+esp_err_t p1p2_traffic_stats_init(void);
+
+/*
+ * Record a completed packet. Called from bus_io_task.
+ */
+void p1p2_traffic_stats_record(const p1p2_packet_t *pkt);
+
+/*
+ * Copy the index-th used entry (in table order) into *out.
+ * Returns false once index passes the last entry.
+ */
+bool p1p2_traffic_stats_get(int index, p1p2_traffic_entry_t *out);
+
+/*
+ * Packets that found no free slot and were not recorded.
+ */
+uint32_t p1p2_traffic_stats_overflow(void);
+
+/*
+ * Clear all entries.
+ */
+void p1p2_traffic_stats_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
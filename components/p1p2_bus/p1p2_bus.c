@@ -1,5 +1,5 @@
 /*
- * P1P2 Bus — Packet assembly, CRC, ring buffer management, public API
+ * P1P2 Bus — Packet assembly, ring buffer management, public API
  *
  * Ties together p1p2_mcpwm_rx.c and p1p2_mcpwm_tx.c with FreeRTOS queues
  * for inter-task communication.
@@ -15,9 +15,14 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/queue.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
 #include "p1p2_bus.h"
 #include "p1p2_bus_types.h"
 #include "p1p2_bus_config.h"
+#include "p1p2_crc.h"
+#include "p1p2_traffic_stats.h"
+#include "p1p2_bus_load.h"
+#include "p1p2_bus_schedule.h"
 
 static const char *TAG = "p1p2_bus";
 
@@ -26,17 +31,56 @@ static const char *TAG = "p1p2_bus";
 volatile uint8_t     rx_buffer[P1P2_RX_BUFFER_SIZE];
 volatile p1p2_error_t error_buffer[P1P2_RX_BUFFER_SIZE];
 volatile uint16_t    delta_buffer[P1P2_RX_BUFFER_SIZE];
+volatile uint32_t    ts_buffer[P1P2_RX_BUFFER_SIZE];   /* start bit, capture ticks */
 volatile uint8_t     rx_buffer_head  = 0;
 volatile uint8_t     rx_buffer_head2 = P1P2_NO_HEAD2;
 volatile uint8_t     rx_buffer_tail  = 0;
+volatile uint8_t     rx_ring_hwm     = 0;   /* peak occupancy, updated by the ISRs */
 
 /* Shared time_msec counter (ISR ms timer increments, TX checks) */
 volatile uint16_t    time_msec = 0;
 
+/*
+ * Timestamp anchor: capture tick <-> esp_timer_get_time() pair, refreshed
+ * by the capture ISR at the first start bit of every packet.
+ * Guarded by ts_anchor_lock since the 64-bit value cannot be written atomically.
+ */
+uint32_t             ts_anchor_ticks = 0;
+int64_t              ts_anchor_us    = 0;
+portMUX_TYPE         ts_anchor_lock  = portMUX_INITIALIZER_UNLOCKED;
+
 /* Configuration shared with ISRs */
 volatile uint8_t     echo_enabled = 1;
 volatile uint8_t     allow_pause  = P1P2_ALLOW_PAUSE_BETWEEN_BYTES;
 
+/*
+ * Expected packet lengths keyed by (src << 8 | type), read by the RX ISR
+ * for early EOP. Only tasks write these, under expect_lock; a slot is
+ * re-keyed with its length zeroed so the ISR never sees a stale length.
+ * expect_len 0 = not trusted (timeout-based EOP).
+ */
+volatile uint16_t    expect_key[P1P2_EXPECT_TABLE_SIZE];
+volatile uint8_t     expect_len[P1P2_EXPECT_TABLE_SIZE];
+static portMUX_TYPE  expect_lock = portMUX_INITIALIZER_UNLOCKED;
+
+#define EXPECT_USED     0x01    /* slot holds a key */
+#define EXPECT_FIXED    0x02    /* set via API, learner leaves it alone */
+#define EXPECT_BLOCKED  0x04    /* early EOP split a packet, never publish */
+
+/* Learner state per slot (bus_io_task only) */
+static struct {
+    uint8_t flags;
+    uint8_t cand_len;   /* candidate length being confirmed */
+    uint8_t count;      /* consecutive observations of cand_len */
+} expect_learn[P1P2_EXPECT_TABLE_SIZE];
+
+static bool     learn_lengths      = true;
+static bool     auto_pause         = true;
+static uint8_t  allow_pause_max    = P1P2_ALLOW_PAUSE_BETWEEN_BYTES;  /* configured ceiling */
+static uint8_t  allow_pause_floor  = P1P2_ALLOW_PAUSE_MIN;  /* raised after each split */
+static uint8_t  pause_window_max   = 0;     /* largest gap (bit times) in window */
+static uint8_t  pause_window_count = 0;
+
 /* LED GPIO numbers */
 int gpio_led_power;
 int gpio_led_read;
@@ -46,9 +90,39 @@ int gpio_led_error;
 /* FreeRTOS queues */
 static QueueHandle_t rx_packet_queue = NULL;
 static QueueHandle_t tx_request_queue = NULL;
+static QueueHandle_t tx_confirm_queue = NULL;
+static QueueHandle_t tx_idle_queue = NULL;     /* writes waiting for an idle window */
+static int64_t       idle_head_since_us;       /* when the head idle write was first seen */
 
-/* Bus statistics */
+/*
+ * Packet subscribers. type_subs[t] has bit i set when subscriber i wants
+ * packet type t, so matching a packet is one table lookup plus the
+ * src/dst check for the (few) subscribers it selects. Slot 0 is the
+ * default RX queue. sub_mutex is held by bus_io_task while fanning out.
+ */
+static struct {
+    QueueHandle_t queue;        /* NULL = free slot */
+    uint8_t  src, dst;
+    bool     match_src, match_dst;
+    p1p2_queue_policy_t policy; /* drop newest or drop oldest, never block */
+} subscribers[P1P2_MAX_SUBSCRIBERS];
+static uint8_t type_subs[256];
+static uint8_t short_subs;      /* subscribers taking packets without a type */
+static SemaphoreHandle_t sub_mutex = NULL;
+
+/*
+ * Bus statistics. Written by bus_io_task, except the write request queue
+ * counters (tx_dropped, tx_queue_hwm), which the writing tasks update
+ * under stats_lock; readers copy under it.
+ */
 static p1p2_bus_stats_t bus_stats;
+static portMUX_TYPE  stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/* Overflow handling */
+static uint16_t type_drops[256];            /* saturating, per packet type */
+static p1p2_queue_policy_t tx_policy = P1P2_QUEUE_BLOCK;
+static uint16_t tx_block_ms = 100;
+static p1p2_packet_t drop_scratch;          /* evicted packet (bus_io_task only) */
 
 /* External init functions from rx/tx modules */
 extern esp_err_t p1p2_rx_init(int gpio_rx);
@@ -59,6 +133,7 @@ extern void      p1p2_tx_write_byte(uint8_t b, uint16_t delay);
 extern bool      p1p2_tx_is_idle(void);
 extern bool      p1p2_tx_write_ready(void);
 extern void      p1p2_tx_set_delay_timeout(uint16_t timeout_ms);
+extern uint8_t   p1p2_tx_ring_hwm(bool reset);
 
 /* External ADC init */
 extern esp_err_t p1p2_adc_init(int gpio_adc0, int gpio_adc1);
@@ -66,22 +141,142 @@ extern void      p1p2_adc_deinit(void);
 extern void      p1p2_adc_get_results(p1p2_adc_results_t *results);
 
 /*
- * CRC calculation — matches ATmega implementation.
- * Polynomial: crc_gen (typically 0xD9 for Daikin)
- * Feed: crc_feed (typically 0x00)
+ * Convert a capture-timer tick count to esp_timer microseconds.
+ * The signed difference handles 32-bit tick wrap (~536 s at 8 MHz)
+ * as long as the tick is within ±268 s of the anchor.
+ */
+static int64_t ticks_to_us(uint32_t ticks)
+{
+    portENTER_CRITICAL(&ts_anchor_lock);
+    uint32_t anchor_ticks = ts_anchor_ticks;
+    int64_t  anchor_us    = ts_anchor_us;
+    portEXIT_CRITICAL(&ts_anchor_lock);
+
+    return anchor_us + (int32_t)(ticks - anchor_ticks) / TICKS_PER_US;
+}
+
+/*
+ * Find the slot for (src, type), claiming a free one if create is set.
+ * Returns -1 when the key is absent (or no free slot within the probe limit).
+ */
+static int expect_find_slot(uint8_t src, uint8_t type, bool create)
+{
+    uint16_t key = ((uint16_t)src << 8) | type;
+    uint8_t slot = P1P2_EXPECT_HASH(src, type);
+    int free_slot = -1;
+
+    for (uint8_t i = 0; i < P1P2_EXPECT_MAX_PROBE; i++) {
+        if (expect_learn[slot].flags & EXPECT_USED) {
+            if (expect_key[slot] == key) return slot;
+        } else if (free_slot < 0) {
+            free_slot = slot;
+        }
+        slot = (slot + 1) & (P1P2_EXPECT_TABLE_SIZE - 1);
+    }
+    if (!create || free_slot < 0) return -1;
+
+    portENTER_CRITICAL(&expect_lock);
+    expect_len[free_slot] = 0;
+    expect_key[free_slot] = key;
+    portEXIT_CRITICAL(&expect_lock);
+    expect_learn[free_slot].flags    = EXPECT_USED;
+    expect_learn[free_slot].cand_len = 0;
+    expect_learn[free_slot].count    = 0;
+    return free_slot;
+}
+
+/* Publish (or with length 0, withdraw) a slot's length to the RX ISR */
+static void expect_publish(int slot, uint8_t length)
+{
+    portENTER_CRITICAL(&expect_lock);
+    expect_len[slot] = length;
+    portEXIT_CRITICAL(&expect_lock);
+}
+
+/*
+ * Learn packet lengths: a length seen P1P2_EXPECT_LEARN_COUNT times in a row
+ * for the same (src, type) is published to the ISR; any other length
+ * withdraws it again until re-confirmed.
+ */
+static void expect_learn_packet(const p1p2_packet_t *pkt)
+{
+    if (!learn_lengths || pkt->has_error || pkt->length < 3) return;
+
+    int slot = expect_find_slot(pkt->data[0], pkt->data[2], true);
+    if (slot < 0) return;
+    uint8_t flags = expect_learn[slot].flags;
+    if (flags & (EXPECT_FIXED | EXPECT_BLOCKED)) return;
+
+    if (expect_learn[slot].cand_len == pkt->length) {
+        if (expect_learn[slot].count < P1P2_EXPECT_LEARN_COUNT) {
+            if (++expect_learn[slot].count == P1P2_EXPECT_LEARN_COUNT) {
+                expect_publish(slot, pkt->length);
+            }
+        }
+    } else {
+        if (expect_len[slot]) expect_publish(slot, 0);
+        expect_learn[slot].cand_len = pkt->length;
+        expect_learn[slot].count    = 1;
+    }
+}
+
+/* Expected length the ISR used for this packet, 0 if none */
+static uint8_t expect_for_packet(const p1p2_packet_t *pkt)
+{
+    if (pkt->length < 3) return 0;
+    int slot = expect_find_slot(pkt->data[0], pkt->data[2], false);
+    return (slot < 0) ? 0 : expect_len[slot];
+}
+
+/*
+ * allow_pause auto-tuning, called once per packet with the largest
+ * inter-byte gap seen in it. A split packet (caught by the caller) raises
+ * the floor so the tuner cannot settle below a value that broke a packet.
+ */
+static void pause_tune_packet(uint8_t max_gap_bits)
+{
+    if (!auto_pause) return;
+
+    if (max_gap_bits > pause_window_max) pause_window_max = max_gap_bits;
+    if (++pause_window_count < P1P2_ALLOW_PAUSE_WINDOW) return;
+
+    uint16_t tuned = pause_window_max + P1P2_ALLOW_PAUSE_MARGIN;
+    if (tuned < allow_pause_floor) tuned = allow_pause_floor;
+    if (tuned > allow_pause_max)   tuned = allow_pause_max;
+    if (tuned != allow_pause) {
+        ESP_LOGD(TAG, "allow_pause %u -> %u (max gap %u)",
+                 allow_pause, (unsigned)tuned, pause_window_max);
+        allow_pause = (uint8_t)tuned;
+    }
+    pause_window_max   = 0;
+    pause_window_count = 0;
+}
+
+/*
+ * A packet that starts within P1P2_SPLIT_PACKET_MS of the previous EOP is
+ * the tail of a packet that was cut short: either by a wrong expected length
+ * (block early EOP for that key) or by a too-tight tuned allow_pause.
  */
-static uint8_t calc_crc(const uint8_t *data, uint8_t length,
-                         uint8_t crc_gen, uint8_t crc_feed)
-{
-    uint8_t crc = crc_feed;
-    for (uint8_t i = 0; i < length; i++) {
-        uint8_t c = data[i];
-        for (uint8_t j = 0; j < 8; j++) {
-            crc = ((crc ^ c) & 0x01) ? ((crc >> 1) ^ crc_gen) : (crc >> 1);
-            c >>= 1;
+static void handle_split_packet(const p1p2_packet_t *prev, bool prev_early)
+{
+    if (prev_early) {
+        int slot = expect_find_slot(prev->data[0], prev->data[2], false);
+        if (slot >= 0 && !(expect_learn[slot].flags & EXPECT_FIXED)) {
+            expect_publish(slot, 0);
+            expect_learn[slot].flags |= EXPECT_BLOCKED;
         }
+        bus_stats.early_eop_mispredicts++;
+        ESP_LOGW(TAG, "Early EOP split packet %02X/%02X at %u bytes",
+                 prev->data[0], prev->data[2], prev->length);
+    } else if (auto_pause && allow_pause < allow_pause_max) {
+        if (allow_pause_floor < allow_pause_max) {
+            allow_pause_floor = allow_pause + 1;
+        }
+        allow_pause = allow_pause_max;
+        pause_window_max   = 0;
+        pause_window_count = 0;
+        ESP_LOGW(TAG, "Packet split at allow_pause, floor now %u", allow_pause_floor);
     }
-    return crc;
 }
 
 /*
@@ -89,7 +284,7 @@ static uint8_t calc_crc(const uint8_t *data, uint8_t length,
  * Returns true if a byte was available.
  */
 static bool ring_buffer_read(uint8_t *byte_out, p1p2_error_t *error_out,
-                              uint16_t *delta_out)
+                              uint16_t *delta_out, uint32_t *ts_out)
 {
     uint8_t head = rx_buffer_head;
     uint8_t tail = rx_buffer_tail;
@@ -100,6 +295,7 @@ static bool ring_buffer_read(uint8_t *byte_out, p1p2_error_t *error_out,
     *byte_out  = rx_buffer[tail];
     *error_out = error_buffer[tail];
     *delta_out = delta_buffer[tail];
+    *ts_out    = ts_buffer[tail];
     rx_buffer_tail = tail;
     return true;
 }
@@ -118,6 +314,175 @@ static bool ring_buffer_has_packet(void)
     return false;
 }
 
+/*
+ * Install a filter in subscriber slot i. Caller holds sub_mutex.
+ */
+static void sub_install(int i, QueueHandle_t queue, const p1p2_packet_filter_t *filter)
+{
+    uint8_t bit = 1 << i;
+
+    subscribers[i].queue     = queue;
+    subscribers[i].src       = filter->src;
+    subscribers[i].dst       = filter->dst;
+    subscribers[i].match_src = filter->match_src;
+    subscribers[i].match_dst = filter->match_dst;
+    subscribers[i].policy    = P1P2_QUEUE_DROP_NEWEST;
+    for (int t = 0; t < 256; t++) {
+        if (filter->type_mask[t >> 5] & (1UL << (t & 31))) type_subs[t] |= bit;
+    }
+    if (filter->short_packets) short_subs |= bit;
+}
+
+/* Clear subscriber slot i. Caller holds sub_mutex. */
+static void sub_remove(int i)
+{
+    uint8_t keep = ~(1 << i);
+
+    for (int t = 0; t < 256; t++) type_subs[t] &= keep;
+    short_subs &= keep;
+    subscribers[i].queue = NULL;
+}
+
+static void count_type_drop(const p1p2_packet_t *pkt)
+{
+    uint8_t type = (pkt->length >= 3) ? pkt->data[2] : 0;
+    if (type_drops[type] < 0xFFFF) type_drops[type]++;
+    bus_stats.rx_dropped++;
+}
+
+/*
+ * Post a packet to subscriber i according to its overflow policy. Never
+ * waits: a full queue drops a packet instead of stalling the RX ring.
+ */
+static void post_to_subscriber(int i, const p1p2_packet_t *pkt)
+{
+    QueueHandle_t q = subscribers[i].queue;
+    uint8_t evicted;
+
+    if (p1p2_queue_post(q, pkt, subscribers[i].policy, 0, &drop_scratch, &evicted) != ESP_OK) {
+        count_type_drop(pkt);
+    }
+    if (evicted) count_type_drop(&drop_scratch);
+
+    if (i == 0) {
+        UBaseType_t n = uxQueueMessagesWaiting(q);
+        if (n > bus_stats.rx_queue_hwm) bus_stats.rx_queue_hwm = n;
+    }
+}
+
+/*
+ * Deliver a received packet to every matching subscriber.
+ */
+static void publish_packet(const p1p2_packet_t *pkt)
+{
+    xSemaphoreTake(sub_mutex, portMAX_DELAY);
+
+    uint8_t mask = (pkt->length >= 3) ? type_subs[pkt->data[2]] : short_subs;
+    while (mask) {
+        int i = __builtin_ctz(mask);
+        mask &= mask - 1;
+
+        if (subscribers[i].match_src &&
+            (pkt->length < 1 || pkt->data[0] != subscribers[i].src)) continue;
+        if (subscribers[i].match_dst &&
+            (pkt->length < 2 || pkt->data[1] != subscribers[i].dst)) continue;
+
+        post_to_subscriber(i, pkt);
+    }
+
+    xSemaphoreGive(sub_mutex);
+}
+
+/*
+ * Hand an echoed packet to the transmit-confirmation queue.
+ */
+static void post_tx_confirm(const p1p2_packet_t *pkt)
+{
+    p1p2_tx_confirm_t conf;
+
+    memcpy(conf.data, pkt->data, pkt->length);
+    memcpy(conf.errors, pkt->errors, pkt->length);
+    conf.start_us = pkt->start_us;
+    conf.eop_us   = pkt->eop_us;
+    conf.length   = pkt->length;
+    conf.ok       = !pkt->has_error;
+
+    if (conf.ok) {
+        bus_stats.tx_confirmed++;
+    } else {
+        bus_stats.tx_readback_errors++;
+        for (uint8_t i = 0; i < pkt->length; i++) {
+            if (pkt->errors[i] & (P1P2_ERROR_SB | P1P2_ERROR_BE | P1P2_ERROR_BC))
+                bus_stats.collision_errors++;
+            if (pkt->errors[i] & P1P2_ERROR_OR) bus_stats.overrun_errors++;
+        }
+    }
+
+    if (tx_confirm_queue) {
+        /* Non-blocking post — nobody listening is not an error */
+        xQueueSend(tx_confirm_queue, &conf, 0);
+    }
+}
+
+/*
+ * Hand a write request to the TX state machine: CRC, then the bytes, the
+ * first one delayed by delay_ms of bus silence.
+ */
+static void transmit_request(p1p2_write_request_t *req)
+{
+    uint8_t total_len = req->length;
+    if (req->crc_gen) {
+        uint8_t crc = p1p2_crc_calc(req->data, req->length, req->crc_gen, req->crc_feed);
+        req->data[total_len++] = crc;
+    }
+
+    for (uint8_t i = 0; i < total_len; i++) {
+        uint16_t d = (i == 0) ? req->delay_ms : 0;
+        p1p2_tx_write_byte(req->data[i], d);
+    }
+    bus_stats.packets_sent++;
+}
+
+/*
+ * Take the oldest idle-window write if it may go out now: a predicted
+ * window long enough for it has opened. The write stays queued while no
+ * window is predicted; once it has waited P1P2_IDLE_WRITE_MAX_WAIT_MS it
+ * is dropped and counted. It is never handed to the TX engine on a
+ * silence timeout, where it would hold the TX ring ahead of the control
+ * responses on a bus that is never silent that long.
+ */
+static bool idle_write_due(p1p2_write_request_t *req)
+{
+    if (!p1p2_tx_is_idle() || !p1p2_tx_write_ready()) return false;
+    if (xQueuePeek(tx_idle_queue, req, 0) != pdTRUE) return false;
+
+    int64_t now = esp_timer_get_time();
+    if (!idle_head_since_us) idle_head_since_us = now;
+
+    uint8_t bytes = req->length + (req->crc_gen ? 1 : 0);
+    uint32_t len_us = bytes * P1P2_BITS_PER_BYTE * TICKS_PER_BIT / TICKS_PER_US;
+    p1p2_idle_window_t win;
+    esp_err_t ret = p1p2_bus_next_idle_window(len_us, &win);
+
+    if (ret == ESP_OK && win.start_us <= now) {
+        /* Start on the next ms tick, unless bus activity restarts the count */
+        xQueueReceive(tx_idle_queue, req, 0);
+        idle_head_since_us = 0;
+        req->delay_ms = time_msec + 2;
+        bus_stats.tx_idle_windows++;
+        return true;
+    }
+
+    if (now - idle_head_since_us >= P1P2_IDLE_WRITE_MAX_WAIT_MS * 1000LL) {
+        xQueueReceive(tx_idle_queue, req, 0);
+        idle_head_since_us = 0;
+        bus_stats.tx_idle_expired++;
+        ESP_LOGW(TAG, "Idle write 0x%02X dropped: no idle window within %d ms",
+                 req->data[2], P1P2_IDLE_WRITE_MAX_WAIT_MS);
+    }
+    return false;
+}
+
 /*
  * ============================================================
  * Bus I/O Task — Assembles packets from ring buffer
@@ -125,7 +490,8 @@ static bool ring_buffer_has_packet(void)
  * Runs at priority 22 (highest non-ISR).
  * Reads bytes from the ISR ring buffer, assembles them into packets,
  * and posts complete packets to the RX queue for the protocol task.
- * Also picks up write requests from the TX queue and transmits them.
+ * Also picks up write requests from the TX queue and transmits them, and
+ * idle-window writes once their window opens.
  */
 static void bus_io_task(void *pvParameters)
 {
@@ -134,51 +500,104 @@ static void bus_io_task(void *pvParameters)
     uint8_t byte_val;
     p1p2_error_t err;
     uint16_t delta;
+    uint32_t ts_ticks;
+    uint32_t start_ticks = 0;
+    uint32_t prev_ticks = 0;
+    uint8_t  max_gap_bits = 0;
     bool assembling = false;
+    bool echo = false;
+    p1p2_packet_t prev_hdr;     /* header of the previous packet, for split checks */
+    bool prev_early = false;
 
     memset(&pkt, 0, sizeof(pkt));
+    memset(&prev_hdr, 0, sizeof(prev_hdr));
 
     while (1) {
         /* Check for write requests (non-blocking) */
         if (xQueueReceive(tx_request_queue, &wr_req, 0) == pdTRUE) {
-            /* Compute CRC if requested */
-            uint8_t total_len = wr_req.length;
-            if (wr_req.crc_gen) {
-                uint8_t crc = calc_crc(wr_req.data, wr_req.length,
-                                       wr_req.crc_gen, wr_req.crc_feed);
-                wr_req.data[total_len++] = crc;
-            }
-
-            /* Queue bytes for transmission */
-            for (uint8_t i = 0; i < total_len; i++) {
-                uint16_t d = (i == 0) ? wr_req.delay_ms : 0;
-                p1p2_tx_write_byte(wr_req.data[i], d);
-            }
-            bus_stats.packets_sent++;
+            transmit_request(&wr_req);
+        } else if (idle_write_due(&wr_req)) {
+            transmit_request(&wr_req);
         }
 
         /* Read bytes from ISR ring buffer */
-        while (ring_buffer_read(&byte_val, &err, &delta)) {
+        while (ring_buffer_read(&byte_val, &err, &delta, &ts_ticks)) {
             if (!assembling) {
                 memset(&pkt, 0, sizeof(pkt));
                 pkt.delta = delta;
+                pkt.start_us = ticks_to_us(ts_ticks);
+                start_ticks = ts_ticks;
+                max_gap_bits = 0;
                 assembling = true;
+            } else {
+                /* Idle bit times between previous stop bit and this start bit */
+                uint32_t span = ts_ticks - prev_ticks;
+                if (span > P1P2_BITS_PER_BYTE * TICKS_PER_BIT) {
+                    uint32_t gap = (span - P1P2_BITS_PER_BYTE * TICKS_PER_BIT +
+                                    TICKS_PER_SEMIBIT) / TICKS_PER_BIT;
+                    if (gap > max_gap_bits) max_gap_bits = gap > 0xFF ? 0xFF : gap;
+                }
             }
+            prev_ticks = ts_ticks;
 
             if (pkt.length < P1P2_MAX_PACKET_SIZE) {
+#ifdef CONFIG_P1P2_BYTE_TIMESTAMPS
+                pkt.byte_offset_us[pkt.length] =
+                    (uint16_t)((ts_ticks - start_ticks) / TICKS_PER_US);
+#endif
                 pkt.data[pkt.length] = byte_val;
-                pkt.errors[pkt.length] = err & ~P1P2_SIGNAL_EOP;
-                if (err & P1P2_ERROR_MASK & ~P1P2_SIGNAL_EOP) {
+                pkt.errors[pkt.length] = err & P1P2_ERROR_MASK;
+                if (err & P1P2_ERROR_MASK) {
                     pkt.has_error = true;
                 }
                 pkt.length++;
             }
+            if (err & P1P2_SIGNAL_ECHO) echo = true;
 
             if (err & P1P2_SIGNAL_EOP) {
-                /* Packet complete — post to queue */
+                /* Packet complete — EOP is the end of the last stop bit */
+                pkt.eop_us = pkt.start_us +
+                             (ts_ticks - start_ticks +
+                              P1P2_BITS_PER_BYTE * TICKS_PER_BIT) / TICKS_PER_US;
+
                 assembling = false;
+
+                /*
+                 * The tail of a split packet: its "header" bytes are payload
+                 * from mid-frame, so it only counts towards bus load.
+                 */
+                bool split = !echo && pkt.delta <= P1P2_SPLIT_PACKET_MS && prev_hdr.length;
+                if (split) pkt.has_error = true;
+                p1p2_bus_load_record(&pkt, echo);
+                if (!split) {
+                    p1p2_traffic_stats_record(&pkt);
+                    p1p2_bus_schedule_record(&pkt);
+                }
+
+                /* Our own transmission read back: confirm, don't decode */
+                if (echo) {
+                    echo = false;
+                    post_tx_confirm(&pkt);
+                    continue;
+                }
+
+                /* Post to queue */
                 bus_stats.packets_received++;
 
+                if (split) {
+                    handle_split_packet(&prev_hdr, prev_early);
+                    prev_hdr.length = 0;
+                    prev_early = false;
+                } else {
+                    uint8_t expect = expect_for_packet(&pkt);
+                    prev_early = expect && expect == pkt.length;
+                    if (prev_early) bus_stats.early_eop_packets++;
+                    expect_learn_packet(&pkt);
+                    pause_tune_packet(max_gap_bits);
+                    prev_hdr.length = pkt.length;
+                    memcpy(prev_hdr.data, pkt.data, 3);
+                }
+
                 /* Update error counters */
                 for (uint8_t i = 0; i < pkt.length; i++) {
                     if (pkt.errors[i] & P1P2_ERROR_CRC_CS) bus_stats.crc_errors++;
@@ -188,10 +607,7 @@ static void bus_io_task(void *pvParameters)
                     if (pkt.errors[i] & P1P2_ERROR_OR)     bus_stats.overrun_errors++;
                 }
 
-                if (rx_packet_queue) {
-                    /* Non-blocking post — drop packet if queue full */
-                    xQueueSend(rx_packet_queue, &pkt, 0);
-                }
+                publish_packet(&pkt);
             }
         }
 
@@ -219,6 +635,12 @@ esp_err_t p1p2_bus_init(const p1p2_bus_config_t *config)
     gpio_led_error = config->gpio_led_error;
     echo_enabled   = config->echo_writes ? 1 : 0;
     allow_pause    = config->allow_pause;
+    allow_pause_max   = config->allow_pause;
+    allow_pause_floor = P1P2_ALLOW_PAUSE_MIN;
+    auto_pause     = config->auto_pause;
+    learn_lengths  = config->learn_lengths;
+    pause_window_max   = 0;
+    pause_window_count = 0;
 
     /* Configure LED GPIOs */
     uint64_t led_mask = (1ULL << config->gpio_led_power) |
@@ -246,15 +668,45 @@ esp_err_t p1p2_bus_init(const p1p2_bus_config_t *config)
     rx_buffer_tail  = 0;
     time_msec = 0;
     memset(&bus_stats, 0, sizeof(bus_stats));
+    memset((void *)expect_len, 0, sizeof(expect_len));
+    memset((void *)expect_key, 0, sizeof(expect_key));
+    memset(expect_learn, 0, sizeof(expect_learn));
 
     /* Create FreeRTOS queues */
     rx_packet_queue  = xQueueCreate(P1P2_PACKET_QUEUE_SIZE, sizeof(p1p2_packet_t));
     tx_request_queue = xQueueCreate(P1P2_PACKET_QUEUE_SIZE, sizeof(p1p2_write_request_t));
-    if (!rx_packet_queue || !tx_request_queue) {
+    tx_confirm_queue = xQueueCreate(P1P2_TX_CONFIRM_QUEUE_SIZE, sizeof(p1p2_tx_confirm_t));
+    tx_idle_queue    = xQueueCreate(P1P2_IDLE_WRITE_QUEUE_SIZE, sizeof(p1p2_write_request_t));
+    sub_mutex        = xSemaphoreCreateMutex();
+    if (!rx_packet_queue || !tx_request_queue || !tx_confirm_queue || !tx_idle_queue || !sub_mutex) {
         ESP_LOGE(TAG, "Failed to create packet queues");
         return ESP_ERR_NO_MEM;
     }
 
+    /* Default RX queue is subscriber 0, taking every packet */
+    p1p2_packet_filter_t all = P1P2_PACKET_FILTER_ALL();
+    memset(subscribers, 0, sizeof(subscribers));
+    memset(type_subs, 0, sizeof(type_subs));
+    short_subs = 0;
+    sub_install(0, rx_packet_queue, &all);
+    subscribers[0].policy = config->rx_policy;
+    if (config->rx_policy == P1P2_QUEUE_BLOCK) {
+        ESP_LOGW(TAG, "RX queue cannot block the bus I/O task, dropping newest instead");
+        subscribers[0].policy = P1P2_QUEUE_DROP_NEWEST;
+    }
+    tx_policy   = config->tx_policy;
+    tx_block_ms = config->tx_block_ms;
+    memset(type_drops, 0, sizeof(type_drops));
+    rx_ring_hwm = 0;
+
+    ret = p1p2_traffic_stats_init();
+    if (ret != ESP_OK) return ret;
+    ret = p1p2_bus_load_init();
+    if (ret != ESP_OK) return ret;
+    ret = p1p2_bus_schedule_init();
+    if (ret != ESP_OK) return ret;
+    idle_head_since_us = 0;
+
     /* Initialize RX (MCPWM capture + GPTimers) */
     ret = p1p2_rx_init(config->gpio_rx);
     if (ret != ESP_OK) return ret;
@@ -293,8 +745,17 @@ void p1p2_bus_deinit(void)
     p1p2_tx_deinit();
     p1p2_adc_deinit();
 
+    for (int i = 1; i < P1P2_MAX_SUBSCRIBERS; i++) {
+        if (subscribers[i].queue) vQueueDelete(subscribers[i].queue);
+    }
+    memset(subscribers, 0, sizeof(subscribers));
+    memset(type_subs, 0, sizeof(type_subs));
+    short_subs = 0;
+    if (sub_mutex)        { vSemaphoreDelete(sub_mutex);        sub_mutex = NULL; }
     if (rx_packet_queue)  { vQueueDelete(rx_packet_queue);  rx_packet_queue = NULL; }
     if (tx_request_queue) { vQueueDelete(tx_request_queue); tx_request_queue = NULL; }
+    if (tx_confirm_queue) { vQueueDelete(tx_confirm_queue); tx_confirm_queue = NULL; }
+    if (tx_idle_queue)    { vQueueDelete(tx_idle_queue);    tx_idle_queue = NULL; }
 }
 
 QueueHandle_t p1p2_bus_get_rx_queue(void)
@@ -307,6 +768,100 @@ QueueHandle_t p1p2_bus_get_tx_queue(void)
     return tx_request_queue;
 }
 
+esp_err_t p1p2_bus_subscribe(const p1p2_packet_filter_t *filter, uint8_t depth,
+                             QueueHandle_t *queue_out)
+{
+    if (!filter || !queue_out || depth == 0) return ESP_ERR_INVALID_ARG;
+    if (!sub_mutex) return ESP_ERR_INVALID_STATE;
+
+    QueueHandle_t q = xQueueCreate(depth, sizeof(p1p2_packet_t));
+    if (!q) return ESP_ERR_NO_MEM;
+
+    xSemaphoreTake(sub_mutex, portMAX_DELAY);
+    int slot = -1;
+    for (int i = 1; i < P1P2_MAX_SUBSCRIBERS; i++) {
+        if (!subscribers[i].queue) { slot = i; break; }
+    }
+    if (slot >= 0) sub_install(slot, q, filter);
+    xSemaphoreGive(sub_mutex);
+
+    if (slot < 0) {
+        vQueueDelete(q);
+        ESP_LOGW(TAG, "No free subscriber slot");
+        return ESP_ERR_NO_MEM;
+    }
+    *queue_out = q;
+    return ESP_OK;
+}
+
+esp_err_t p1p2_bus_unsubscribe(QueueHandle_t queue)
+{
+    if (!queue || queue == rx_packet_queue || !sub_mutex) return ESP_ERR_INVALID_ARG;
+
+    xSemaphoreTake(sub_mutex, portMAX_DELAY);
+    int slot = -1;
+    for (int i = 1; i < P1P2_MAX_SUBSCRIBERS; i++) {
+        if (subscribers[i].queue == queue) { slot = i; break; }
+    }
+    if (slot >= 0) sub_remove(slot);
+    xSemaphoreGive(sub_mutex);
+
+    if (slot < 0) return ESP_ERR_NOT_FOUND;
+    vQueueDelete(queue);
+    return ESP_OK;
+}
+
+esp_err_t p1p2_bus_set_queue_policy(QueueHandle_t queue, p1p2_queue_policy_t policy,
+                                    uint16_t block_ms)
+{
+    if (!queue) return ESP_ERR_INVALID_ARG;
+
+    if (queue == tx_request_queue) {
+        tx_policy   = policy;
+        tx_block_ms = block_ms;
+        return ESP_OK;
+    }
+
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    xSemaphoreTake(sub_mutex, portMAX_DELAY);
+    for (int i = 0; i < P1P2_MAX_SUBSCRIBERS; i++) {
+        if (subscribers[i].queue == queue) {
+            if (policy == P1P2_QUEUE_BLOCK) {
+                ret = ESP_ERR_NOT_SUPPORTED;
+            } else {
+                subscribers[i].policy = policy;
+                ret = ESP_OK;
+            }
+            break;
+        }
+    }
+    xSemaphoreGive(sub_mutex);
+    return ret;
+}
+
+uint16_t p1p2_bus_get_type_drops(uint8_t type)
+{
+    return type_drops[type];
+}
+
+void p1p2_bus_reset_queue_stats(void)
+{
+    memset(type_drops, 0, sizeof(type_drops));
+    portENTER_CRITICAL(&stats_lock);
+    bus_stats.rx_dropped   = 0;
+    bus_stats.tx_dropped   = 0;
+    bus_stats.rx_queue_hwm = 0;
+    bus_stats.tx_queue_hwm = 0;
+    portEXIT_CRITICAL(&stats_lock);
+    rx_ring_hwm = 0;
+    p1p2_tx_ring_hwm(true);
+}
+
+QueueHandle_t p1p2_bus_get_tx_confirm_queue(void)
+{
+    return tx_confirm_queue;
+}
+
 uint8_t p1p2_bus_read_packet(p1p2_packet_t *pkt, uint32_t timeout_ms)
 {
     if (xQueueReceive(rx_packet_queue, pkt, pdMS_TO_TICKS(timeout_ms)) == pdTRUE) {
@@ -328,7 +883,40 @@ esp_err_t p1p2_bus_write_packet(const uint8_t *data, uint8_t length,
     req.crc_gen  = crc_gen;
     req.crc_feed = crc_feed;
 
-    if (xQueueSend(tx_request_queue, &req, pdMS_TO_TICKS(100)) != pdTRUE) {
+    p1p2_write_request_t old;
+    uint8_t evicted;
+    esp_err_t ret = p1p2_queue_post(tx_request_queue, &req, tx_policy, tx_block_ms,
+                                    &old, &evicted);
+    UBaseType_t n = uxQueueMessagesWaiting(tx_request_queue);
+
+    portENTER_CRITICAL(&stats_lock);
+    if (evicted) bus_stats.tx_dropped++;
+    if (ret != ESP_OK) {
+        bus_stats.tx_dropped++;
+    } else if (n > bus_stats.tx_queue_hwm) {
+        bus_stats.tx_queue_hwm = n;
+    }
+    portEXIT_CRITICAL(&stats_lock);
+    return ret;
+}
+
+esp_err_t p1p2_bus_write_packet_idle(const uint8_t *data, uint8_t length,
+                                     uint8_t crc_gen, uint8_t crc_feed)
+{
+    if (length > P1P2_MAX_PACKET_SIZE - 1) return ESP_ERR_INVALID_SIZE;
+    if (!tx_idle_queue) return ESP_ERR_INVALID_STATE;
+
+    p1p2_write_request_t req;
+    memcpy(req.data, data, length);
+    req.length   = length;
+    req.delay_ms = 0;                   /* set when the window opens */
+    req.crc_gen  = crc_gen;
+    req.crc_feed = crc_feed;
+
+    if (xQueueSend(tx_idle_queue, &req, 0) != pdTRUE) {
+        portENTER_CRITICAL(&stats_lock);
+        bus_stats.tx_dropped++;
+        portEXIT_CRITICAL(&stats_lock);
         return ESP_ERR_TIMEOUT;
     }
     return ESP_OK;
@@ -351,7 +939,25 @@ void p1p2_bus_set_echo(bool echo)
 
 void p1p2_bus_set_allow_pause(uint8_t bit_times)
 {
-    allow_pause = bit_times;
+    allow_pause       = bit_times;
+    allow_pause_max   = bit_times;
+    allow_pause_floor = P1P2_ALLOW_PAUSE_MIN;
+    pause_window_max   = 0;
+    pause_window_count = 0;
+}
+
+esp_err_t p1p2_bus_set_expected_length(uint8_t src, uint8_t type, uint8_t length)
+{
+    if (length > P1P2_MAX_PACKET_SIZE) return ESP_ERR_INVALID_ARG;
+
+    int slot = expect_find_slot(src, type, length != 0);
+    if (slot < 0) return length ? ESP_ERR_NO_MEM : ESP_OK;
+
+    expect_learn[slot].flags    = EXPECT_USED | (length ? EXPECT_FIXED : 0);
+    expect_learn[slot].cand_len = 0;
+    expect_learn[slot].count    = 0;
+    expect_publish(slot, length);
+    return ESP_OK;
 }
 
 void p1p2_bus_get_adc(p1p2_adc_results_t *results)
@@ -361,7 +967,12 @@ void p1p2_bus_get_adc(p1p2_adc_results_t *results)
 
 void p1p2_bus_get_stats(p1p2_bus_stats_t *stats)
 {
+    portENTER_CRITICAL(&stats_lock);
     *stats = bus_stats;
+    portEXIT_CRITICAL(&stats_lock);
+    stats->allow_pause = allow_pause;
+    stats->rx_ring_hwm = rx_ring_hwm;
+    stats->tx_ring_hwm = p1p2_tx_ring_hwm(false);
     stats->uptime_us = esp_timer_get_time();
 }
 
@@ -0,0 +1,182 @@
+/*
+ * P1P2 Bus Load — Bus utilization over rolling 1 s / 1 min / 15 min windows
+ *
+ * Each packet's busy time is added to the slot of the second it started
+ * in. When time moves past a second, the slot is closed into the
+ * 60-entry seconds ring; every 60 closed seconds are summed into the
+ * 15-entry minutes ring. Skipped (silent) seconds close as zero.
+ *
+ * ESP32-C6 port: 2026
+ */
+
+#include <string.h>
+#include "esp_err.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "p1p2_bus_load.h"
+
+#define SEC_SLOTS   60
+#define MIN_SLOTS   15
+#define US_PER_SEC  1000000LL
+
+typedef struct {
+    uint32_t busy_us;
+    uint32_t tx_us;
+    uint16_t packets;
+} load_slot_t;
+
+typedef struct {
+    uint32_t busy_ms;           /* minute totals kept in ms to stay in 32 bits */
+    uint32_t tx_ms;
+    uint32_t packets;
+} load_min_t;
+
+static load_slot_t cur;                 /* second in progress */
+static int64_t     cur_sec;             /* index of the second in progress */
+static bool        started;             /* cur_sec is set */
+static load_slot_t secs[SEC_SLOTS];
+static uint8_t     sec_head;            /* next slot to write */
+static uint8_t     sec_filled;
+static load_min_t  mins[MIN_SLOTS];
+static uint8_t     min_head;
+static uint8_t     min_filled;
+static load_min_t  min_acc;             /* minute being accumulated */
+static uint8_t     min_acc_secs;
+static SemaphoreHandle_t load_mutex;
+
+/* Called from p1p2_bus_init() before bus_io_task starts; clears the windows */
+esp_err_t p1p2_bus_load_init(void)
+{
+    if (!load_mutex) load_mutex = xSemaphoreCreateMutex();
+    if (!load_mutex) return ESP_ERR_NO_MEM;
+
+    xSemaphoreTake(load_mutex, portMAX_DELAY);
+    memset(&cur, 0, sizeof(cur));
+    memset(secs, 0, sizeof(secs));
+    memset(mins, 0, sizeof(mins));
+    memset(&min_acc, 0, sizeof(min_acc));
+    sec_head = sec_filled = min_head = min_filled = min_acc_secs = 0;
+    cur_sec = 0;
+    started = false;
+    xSemaphoreGive(load_mutex);
+    return ESP_OK;
+}
+
+/* Close the second in progress into the rings. Caller holds load_mutex. */
+static void close_second(void)
+{
+    secs[sec_head] = cur;
+    sec_head = (sec_head + 1) % SEC_SLOTS;
+    if (sec_filled < SEC_SLOTS) sec_filled++;
+
+    min_acc.busy_ms += cur.busy_us / 1000;
+    min_acc.tx_ms   += cur.tx_us / 1000;
+    min_acc.packets += cur.packets;
+    if (++min_acc_secs == 60) {
+        mins[min_head] = min_acc;
+        min_head = (min_head + 1) % MIN_SLOTS;
+        if (min_filled < MIN_SLOTS) min_filled++;
+        memset(&min_acc, 0, sizeof(min_acc));
+        min_acc_secs = 0;
+    }
+    memset(&cur, 0, sizeof(cur));
+}
+
+/* Move the windows forward to second `sec`. Caller holds load_mutex. */
+static void advance_to(int64_t sec)
+{
+    if (!started) {
+        cur_sec = sec;
+        started = true;
+        return;
+    }
+    int64_t steps = sec - cur_sec;
+    if (steps > 2 * SEC_SLOTS) {
+        /*
+         * Long silence: close the second in progress and finish its minute
+         * (at most 60 steps), then skip the rest of the per-second walk,
+         * the windows after it are all zero.
+         */
+        do {
+            close_second();
+            steps--;
+        } while (min_acc_secs != 0);
+        int64_t idle_min = steps / 60;
+        memset(secs, 0, sizeof(secs));
+        sec_head = 0;
+        sec_filled = SEC_SLOTS;
+        min_acc_secs = (uint8_t)(steps % 60);
+        for (int64_t i = 0; i < idle_min && i < MIN_SLOTS; i++) {
+            memset(&mins[min_head], 0, sizeof(mins[0]));
+            min_head = (min_head + 1) % MIN_SLOTS;
+            if (min_filled < MIN_SLOTS) min_filled++;
+        }
+    } else {
+        while (steps-- > 0) close_second();
+    }
+    if (sec > cur_sec) cur_sec = sec;
+}
+
+void p1p2_bus_load_record(const p1p2_packet_t *pkt, bool own_tx)
+{
+    int64_t busy = pkt->eop_us - pkt->start_us;
+    if (busy < 0 || busy > US_PER_SEC) return;
+
+    if (!load_mutex) return;
+
+    xSemaphoreTake(load_mutex, portMAX_DELAY);
+    advance_to(pkt->start_us / US_PER_SEC);
+    cur.busy_us += (uint32_t)busy;
+    if (own_tx) cur.tx_us += (uint32_t)busy;
+    if (cur.packets < 0xFFFF) cur.packets++;
+    xSemaphoreGive(load_mutex);
+}
+
+/* part / whole in 0.1 % units, clamped to 1000 */
+static uint16_t permille(uint64_t part, uint64_t whole)
+{
+    if (whole == 0) return 0;
+    uint64_t v = part * 1000 / whole;
+    return (v > 1000) ? 1000 : (uint16_t)v;
+}
+
+void p1p2_bus_get_load(p1p2_bus_load_t *out)
+{
+    p1p2_bus_get_load_at(esp_timer_get_time(), out);
+}
+
+void p1p2_bus_get_load_at(int64_t now_us, p1p2_bus_load_t *out)
+{
+    uint64_t busy_1m = 0, tx_1m = 0, busy_15m = 0, tx_15m = 0;
+    uint32_t pkts_1m = 0;
+
+    memset(out, 0, sizeof(*out));
+    if (!load_mutex) return;
+
+    xSemaphoreTake(load_mutex, portMAX_DELAY);
+    advance_to(now_us / US_PER_SEC);
+
+    if (sec_filled) {
+        const load_slot_t *last = &secs[(sec_head + SEC_SLOTS - 1) % SEC_SLOTS];
+        out->load_1s = permille(last->busy_us, US_PER_SEC);
+    }
+    for (uint8_t i = 0; i < sec_filled; i++) {
+        busy_1m += secs[i].busy_us;
+        tx_1m   += secs[i].tx_us;
+        pkts_1m += secs[i].packets;
+    }
+    for (uint8_t i = 0; i < min_filled; i++) {
+        busy_15m += mins[i].busy_ms;
+        tx_15m   += mins[i].tx_ms;
+    }
+    uint8_t n_sec = sec_filled;
+    uint8_t n_min = min_filled;
+    xSemaphoreGive(load_mutex);
+
+    out->load_1m      = permille(busy_1m, (uint64_t)n_sec * US_PER_SEC);
+    out->tx_share_1m  = permille(tx_1m, busy_1m);
+    out->packets_1m   = (pkts_1m > 0xFFFF) ? 0xFFFF : (uint16_t)pkts_1m;
+    out->load_15m     = permille(busy_15m, (uint64_t)n_min * 60000);
+    out->tx_share_15m = permille(tx_15m, busy_15m);
+}
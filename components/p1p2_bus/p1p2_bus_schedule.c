@@ -0,0 +1,204 @@
+/*
+ * P1P2 Bus Schedule — Learned packet order and predicted idle windows
+ *
+ * Per (source, destination, type), learned from consecutive packets:
+ *   - duration, start bit to EOP (running average)
+ *   - idle time before the next packet, whatever it is: a low estimate
+ *     that drops at once to a shorter gap and creeps back up slowly, and
+ *     a running average
+ *   - the usual successor, with a confidence count: confirmations raise
+ *     it, a different successor lowers it, and the successor is replaced
+ *     once the count reaches zero
+ *
+ * A prediction starts at the EOP of the last packet seen. While the gap
+ * after the current packet is known, the window it offers (low estimate,
+ * minus a guard on both sides) is checked; the walk then moves on to the
+ * usual successor at the average gap, until the successor is uncertain or
+ * a full table's worth of steps has passed.
+ *
+ * ESP32-C6 port: 2026
+ */
+
+#include <string.h>
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "p1p2_bus_schedule.h"
+
+static const char *TAG = "p1p2_sched";
+
+#define SCHED_HITS_MAX   15
+
+typedef struct {
+    bool     used;
+    uint8_t  src;
+    uint8_t  dst;
+    uint8_t  type;
+    uint8_t  gaps_seen;         /* saturating at SCHED_HITS_MAX */
+    uint8_t  hits;              /* confidence in next */
+    int8_t   next;              /* slot of the usual successor, -1 if none yet */
+    uint32_t dur_us;
+    uint32_t gap_min_us;
+    uint32_t gap_avg_us;
+} sched_entry_t;
+
+static sched_entry_t entries[P1P2_SCHED_MAX_ENTRIES];
+static int8_t   last_slot = -1;         /* packet the prediction starts from */
+static int64_t  last_eop_us;
+static uint32_t overflow_count;
+static SemaphoreHandle_t sched_mutex;
+
+_Static_assert(P1P2_SCHED_MAX_ENTRIES <= 128, "slot index must fit in int8_t");
+
+/* Called from p1p2_bus_init() before bus_io_task starts */
+esp_err_t p1p2_bus_schedule_init(void)
+{
+    if (!sched_mutex) sched_mutex = xSemaphoreCreateMutex();
+    if (!sched_mutex) return ESP_ERR_NO_MEM;
+
+    memset(entries, 0, sizeof(entries));
+    last_slot = -1;
+    last_eop_us = 0;
+    overflow_count = 0;
+    return ESP_OK;
+}
+
+static inline uint8_t key_hash(uint8_t src, uint8_t dst, uint8_t type)
+{
+    return (type ^ (src >> 2) ^ (dst >> 1)) & (P1P2_SCHED_MAX_ENTRIES - 1);
+}
+
+/* Slot of (src, dst, type), claimed if new. -1 if the probe window is full. */
+static int find_slot(uint8_t src, uint8_t dst, uint8_t type)
+{
+    uint8_t slot = key_hash(src, dst, type);
+
+    for (uint8_t i = 0; i < P1P2_SCHED_MAX_PROBE; i++) {
+        sched_entry_t *e = &entries[slot];
+        if (!e->used) {
+            memset(e, 0, sizeof(*e));
+            e->used = true;
+            e->src = src;
+            e->dst = dst;
+            e->type = type;
+            e->next = -1;
+            return slot;
+        }
+        if (e->src == src && e->dst == dst && e->type == type) return slot;
+        slot = (slot + 1) & (P1P2_SCHED_MAX_ENTRIES - 1);
+    }
+    return -1;
+}
+
+/* Learn that `slot` followed `prev` after `gap` µs of idle bus */
+static void learn_transition(sched_entry_t *prev, int slot, uint32_t gap)
+{
+    if (prev->gaps_seen == 0) {
+        prev->gap_min_us = gap;
+        prev->gap_avg_us = gap;
+    } else {
+        if (gap < prev->gap_min_us) {
+            prev->gap_min_us = gap;
+        } else {
+            prev->gap_min_us += (gap - prev->gap_min_us) >> 4;
+        }
+        prev->gap_avg_us = (uint32_t)((int64_t)prev->gap_avg_us +
+                                      ((int64_t)gap - prev->gap_avg_us) / 8);
+    }
+    if (prev->gaps_seen < SCHED_HITS_MAX) prev->gaps_seen++;
+
+    if (prev->next == slot) {
+        if (prev->hits < SCHED_HITS_MAX) prev->hits++;
+    } else if (prev->hits > 0) {
+        prev->hits--;
+    } else {
+        prev->next = (int8_t)slot;
+        prev->hits = 1;
+    }
+}
+
+void p1p2_bus_schedule_record(const p1p2_packet_t *pkt)
+{
+    if (!sched_mutex) return;
+
+    xSemaphoreTake(sched_mutex, portMAX_DELAY);
+
+    /* Packets without a full header break the chain but still take bus time */
+    int slot = (pkt->length >= 3) ? find_slot(pkt->data[0], pkt->data[1], pkt->data[2]) : -1;
+    if (slot < 0 && pkt->length >= 3 && overflow_count++ == 0) {
+        ESP_LOGW(TAG, "Schedule table full, %02X/%02X/%02X not learned",
+                 pkt->data[0], pkt->data[1], pkt->data[2]);
+    }
+
+    if (slot >= 0) {
+        sched_entry_t *e = &entries[slot];
+        uint32_t dur = (uint32_t)(pkt->eop_us - pkt->start_us);
+        e->dur_us = e->dur_us ? (uint32_t)((int64_t)e->dur_us + ((int64_t)dur - e->dur_us) / 4) : dur;
+
+        if (last_slot >= 0 && pkt->start_us >= last_eop_us) {
+            learn_transition(&entries[last_slot], slot, (uint32_t)(pkt->start_us - last_eop_us));
+        }
+    }
+    last_slot = (int8_t)slot;
+    last_eop_us = pkt->eop_us;
+
+    xSemaphoreGive(sched_mutex);
+}
+
+esp_err_t p1p2_bus_next_idle_window(uint32_t min_len_us, p1p2_idle_window_t *out)
+{
+    if (!out) return ESP_ERR_INVALID_ARG;
+    if (!sched_mutex) return ESP_ERR_INVALID_STATE;
+
+    int64_t now = esp_timer_get_time();
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+
+    xSemaphoreTake(sched_mutex, portMAX_DELAY);
+
+    if (last_slot < 0 || now - last_eop_us > P1P2_SCHED_STALE_US) {
+        xSemaphoreGive(sched_mutex);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    int slot = last_slot;
+    int64_t t = last_eop_us;            /* predicted EOP of the packet at slot */
+
+    for (int step = 0; step < P1P2_SCHED_MAX_ENTRIES; step++) {
+        const sched_entry_t *e = &entries[slot];
+        if (e->gaps_seen < P1P2_SCHED_MIN_HITS) break;
+
+        int64_t start = t + P1P2_SCHED_GUARD_US;
+        int64_t end = t + (int64_t)e->gap_min_us - P1P2_SCHED_GUARD_US;
+        if (start < now) start = now;
+        if (end - start >= (int64_t)min_len_us) {
+            out->start_us = start;
+            out->len_us = (uint32_t)(end - start);
+            out->after_src = e->src;
+            out->after_dst = e->dst;
+            out->after_type = e->type;
+            ret = ESP_OK;
+            break;
+        }
+
+        if (e->next < 0 || e->hits < P1P2_SCHED_MIN_HITS) break;
+        slot = e->next;
+        t += (int64_t)e->gap_avg_us + entries[slot].dur_us;
+    }
+
+    xSemaphoreGive(sched_mutex);
+    return ret;
+}
+
+void p1p2_bus_schedule_reset(void)
+{
+    if (!sched_mutex) return;
+
+    xSemaphoreTake(sched_mutex, portMAX_DELAY);
+    memset(entries, 0, sizeof(entries));
+    last_slot = -1;
+    last_eop_us = 0;
+    overflow_count = 0;
+    xSemaphoreGive(sched_mutex);
+}
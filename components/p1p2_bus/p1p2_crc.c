@@ -0,0 +1,30 @@
+/*
+ * P1P2 CRC — Packet CRC as used by Daikin
+ *
+ * Kept apart from p1p2_bus.c so it builds without the bus hardware, for
+ * the host benchmarks in test/host.
+ *
+ * Original: Copyright (c) 2019-2024 Arnold Niessen — CC BY-NC-ND 4.0
+ * ESP32-C6 port: 2026
+ */
+
+#include "p1p2_crc.h"
+
+/*
+ * CRC calculation — matches ATmega implementation.
+ * Polynomial: crc_gen (typically 0xD9 for Daikin)
+ * Feed: crc_feed (typically 0x00)
+ */
+uint8_t p1p2_crc_calc(const uint8_t *data, uint8_t length,
+                      uint8_t crc_gen, uint8_t crc_feed)
+{
+    uint8_t crc = crc_feed;
+    for (uint8_t i = 0; i < length; i++) {
+        uint8_t c = data[i];
+        for (uint8_t j = 0; j < 8; j++) {
+            crc = ((crc ^ c) & 0x01) ? ((crc >> 1) ^ crc_gen) : (crc >> 1);
+            c >>= 1;
+        }
+    }
+    return crc;
+}
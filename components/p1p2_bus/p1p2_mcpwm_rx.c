@@ -15,6 +15,7 @@
 #include <string.h>
 #include "esp_attr.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "driver/mcpwm_cap.h"
 #include "driver/gpio.h"
 #include "driver/gptimer.h"
@@ -30,13 +31,20 @@ static const char *TAG = "p1p2_rx";
 extern volatile uint8_t  rx_buffer[P1P2_RX_BUFFER_SIZE];
 extern volatile p1p2_error_t error_buffer[P1P2_RX_BUFFER_SIZE];
 extern volatile uint16_t delta_buffer[P1P2_RX_BUFFER_SIZE];
+extern volatile uint32_t ts_buffer[P1P2_RX_BUFFER_SIZE];
 extern volatile uint8_t  rx_buffer_head;
 extern volatile uint8_t  rx_buffer_head2;
 extern volatile uint8_t  rx_buffer_tail;
+extern volatile uint8_t  rx_ring_hwm;
 
 /* Time tracking: millisecond counter since last start bit */
 extern volatile uint16_t time_msec;
 
+/* Timestamp anchor: capture tick <-> esp_timer pair */
+extern uint32_t     ts_anchor_ticks;
+extern int64_t      ts_anchor_us;
+extern portMUX_TYPE ts_anchor_lock;
+
 /* LED GPIO pins (set during init) */
 extern int gpio_led_read;
 extern int gpio_led_error;
@@ -45,6 +53,10 @@ extern int gpio_led_error;
 extern volatile uint8_t  echo_enabled;
 extern volatile uint8_t  allow_pause;
 
+/* Expected packet lengths for early EOP (maintained by p1p2_bus.c) */
+extern volatile uint16_t expect_key[P1P2_EXPECT_TABLE_SIZE];
+extern volatile uint8_t  expect_len[P1P2_EXPECT_TABLE_SIZE];
+
 /* ---- RX-private state ---- */
 
 static volatile uint8_t  rx_state;
@@ -53,6 +65,10 @@ static volatile uint8_t  rx_paritycheck;
 static volatile uint32_t rx_target;      /* target timestamp for next mid-bit sample */
 static volatile uint32_t prev_edge_capture;
 static volatile uint16_t startbit_delta; /* time_msec at start of current byte */
+static volatile uint32_t startbit_ticks; /* capture tick of current byte's start bit */
+static volatile uint8_t  rx_pkt_index;   /* bytes stored in the current packet */
+static volatile uint8_t  rx_pkt_src;     /* first byte of the current packet */
+static volatile uint8_t  rx_pkt_expect;  /* expected packet length, 0 = unknown */
 
 /* MCPWM capture handle */
 static mcpwm_cap_channel_handle_t cap_channel = NULL;
@@ -107,8 +123,54 @@ static inline void IRAM_ATTR disable_midbit_alarm(void)
     gptimer_set_alarm_action(gptimer_midbit, &alarm_cfg);
 }
 
+/*
+ * Current time expressed in capture-timer ticks.
+ * Used by the TX ISR to timestamp echoed bytes, which have no capture edge.
+ * Re-anchors at the returned value so long TX-only periods cannot drift
+ * outside the ±268 s window that ticks_to_us() can resolve.
+ */
+uint32_t IRAM_ATTR p1p2_rx_ticks_now(void)
+{
+    int64_t now_us = esp_timer_get_time();
+
+    portENTER_CRITICAL_ISR(&ts_anchor_lock);
+    uint32_t ticks = ts_anchor_ticks +
+                     (uint32_t)((now_us - ts_anchor_us) * TICKS_PER_US);
+    ts_anchor_ticks = ticks;
+    ts_anchor_us    = now_us;
+    portEXIT_CRITICAL_ISR(&ts_anchor_lock);
+
+    return ticks;
+}
+
+/*
+ * Look up the expected length for (src, type). Bounded linear probe,
+ * returns 0 when the key is unknown or not yet trusted.
+ */
+static inline uint8_t IRAM_ATTR expect_lookup(uint8_t src, uint8_t type)
+{
+    uint16_t key = ((uint16_t)src << 8) | type;
+    uint8_t slot = P1P2_EXPECT_HASH(src, type);
+    for (uint8_t i = 0; i < P1P2_EXPECT_MAX_PROBE; i++) {
+        if (expect_key[slot] == key) return expect_len[slot];
+        slot = (slot + 1) & (P1P2_EXPECT_TABLE_SIZE - 1);
+    }
+    return 0;
+}
+
+/* Commit the pending byte and mark it as the last byte of the packet */
+static inline void IRAM_ATTR signal_eop(void)
+{
+    if (rx_buffer_head2 != P1P2_NO_HEAD2) {
+        rx_buffer_head = rx_buffer_head2;
+        error_buffer[rx_buffer_head] |= P1P2_SIGNAL_EOP;
+        rx_buffer_head2 = P1P2_NO_HEAD2;
+    }
+}
+
 /* Store a received byte into the ring buffer */
 static inline void IRAM_ATTR store_rx_byte(uint8_t byte_val, uint16_t delta,
+                                            uint32_t ticks,
                                             p1p2_error_t error_flags)
 {
     uint8_t head = rx_buffer_head + 1;
@@ -116,8 +178,13 @@ static inline void IRAM_ATTR store_rx_byte(uint8_t byte_val, uint16_t delta,
     if (head != rx_buffer_tail) {
         rx_buffer[head] = byte_val;
         delta_buffer[head] = delta;
+        ts_buffer[head] = ticks;
         error_buffer[head] = error_flags;
         rx_buffer_head2 = head;
+
+        uint8_t used = (head >= rx_buffer_tail) ? head - rx_buffer_tail
+                                                : head + P1P2_RX_BUFFER_SIZE - rx_buffer_tail;
+        if (used > rx_ring_hwm) rx_ring_hwm = used;
     } else {
         /* Buffer overrun — flag on previous byte */
         error_buffer[rx_buffer_head] |= P1P2_ERROR_OR;
@@ -165,8 +232,19 @@ static bool IRAM_ATTR capture_callback(mcpwm_cap_channel_handle_t cap_ch,
         if (state == 0) {
             gpio_set_level(gpio_led_read, 1);
             gpio_set_level(gpio_led_error, 0);
+
+            /* Re-anchor capture ticks to esp_timer at each packet start */
+            int64_t now_us = esp_timer_get_time();
+            portENTER_CRITICAL_ISR(&ts_anchor_lock);
+            ts_anchor_ticks = capture;
+            ts_anchor_us    = now_us;
+            portEXIT_CRITICAL_ISR(&ts_anchor_lock);
+
+            rx_pkt_index  = 0;
+            rx_pkt_expect = 0;
         }
 
+        startbit_ticks = capture;
         startbit_delta = time_msec;
         time_msec = 0;
 
@@ -229,11 +307,7 @@ static bool IRAM_ATTR midbit_alarm_callback(gptimer_handle_t timer,
     switch (state) {
     case 1: /* EOP timeout: no new start bit detected */
         rx_state = 0;
-        if (rx_buffer_head2 != P1P2_NO_HEAD2) {
-            rx_buffer_head = rx_buffer_head2;
-            error_buffer[rx_buffer_head] |= P1P2_SIGNAL_EOP;
-            rx_buffer_head2 = P1P2_NO_HEAD2;
-        }
+        signal_eop();
         gpio_set_level(gpio_led_read, 0);
         return false;
 
@@ -268,15 +342,34 @@ static bool IRAM_ATTR midbit_alarm_callback(gptimer_handle_t timer,
             err |= P1P2_ERROR_PE;
         }
 
-        store_rx_byte(rx_byte, startbit_delta, err);
+        store_rx_byte(rx_byte, startbit_delta, startbit_ticks, err);
+
+        /* Re-enable ms timer for TX scheduling */
+        time_msec = 1; /* preset to 1ms since we're at the parity/stop bit boundary */
+
+        /*
+         * Early EOP: once the type byte is in, the expected length (if known)
+         * tells us which stop bit ends the packet — no need to wait out the
+         * allow_pause timeout. A split (too-short) prediction is detected and
+         * evicted by bus_io_task.
+         */
+        if (rx_pkt_index < 0xFF) rx_pkt_index++;
+        if (rx_pkt_index == 1) {
+            rx_pkt_src = rx_byte;
+        } else if (rx_pkt_index == 3) {
+            rx_pkt_expect = expect_lookup(rx_pkt_src, rx_byte);
+        }
+        if (rx_pkt_expect && rx_pkt_index == rx_pkt_expect) {
+            rx_state = 0;
+            signal_eop();
+            gpio_set_level(gpio_led_read, 0);
+            break;
+        }
 
         /* Schedule EOP timeout: if no start bit within (1 + allow_pause) bit times */
         rx_state = 1;
         rx_target += TICKS_PER_BIT * (1 + allow_pause);
         schedule_midbit_alarm(rx_target);
-
-        /* Re-enable ms timer for TX scheduling */
-        time_msec = 1; /* preset to 1ms since we're at the parity/stop bit boundary */
         break;
     }
 
@@ -330,6 +423,10 @@ esp_err_t p1p2_rx_init(int gpio_rx)
     rx_target = 0;
     prev_edge_capture = 0;
     startbit_delta = 0;
+    startbit_ticks = 0;
+    rx_pkt_index = 0;
+    rx_pkt_src = 0;
+    rx_pkt_expect = 0;
 
     /* ---- MCPWM Capture Timer (8 MHz free-running) ---- */
     mcpwm_capture_timer_config_t cap_timer_cfg = {
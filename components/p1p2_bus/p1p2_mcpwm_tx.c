@@ -33,14 +33,17 @@ static const char *TAG = "p1p2_tx";
 extern volatile uint8_t  rx_buffer[P1P2_RX_BUFFER_SIZE];
 extern volatile p1p2_error_t error_buffer[P1P2_RX_BUFFER_SIZE];
 extern volatile uint16_t delta_buffer[P1P2_RX_BUFFER_SIZE];
+extern volatile uint32_t ts_buffer[P1P2_RX_BUFFER_SIZE];
 extern volatile uint8_t  rx_buffer_head;
 extern volatile uint8_t  rx_buffer_head2;
 extern volatile uint8_t  rx_buffer_tail;
+extern volatile uint8_t  rx_ring_hwm;
 extern volatile uint16_t time_msec;
 extern int gpio_led_read;
 extern int gpio_led_write;
 extern int gpio_led_error;
 extern volatile uint8_t echo_enabled;
+extern uint32_t p1p2_rx_ticks_now(void);
 
 /* ---- TX-private state ---- */
 static volatile uint32_t tx_next_compare; /* tracks the next comparator value */
@@ -52,6 +55,7 @@ static volatile uint8_t  tx_paritybit;
 static volatile uint8_t  tx_rx_readbackerror;
 static volatile uint16_t tx_wait;
 static volatile uint16_t startbit_delta_tx;
+static volatile uint32_t startbit_ticks_tx; /* start bit of byte being sent, capture ticks */
 
 /* TX ring buffer */
 static volatile uint8_t  tx_buffer_head;
@@ -60,6 +64,7 @@ static volatile uint8_t  tx_buffer[P1P2_TX_BUFFER_SIZE];
 static volatile uint16_t tx_buffer_delay[P1P2_TX_BUFFER_SIZE];
 static volatile uint16_t tx_setdelay;
 static volatile uint16_t tx_setdelaytimeout = 2500;
+static uint8_t           tx_buffer_hwm;   /* peak occupancy of tx_buffer */
 
 /* MCPWM handles */
 static mcpwm_timer_handle_t     mcpwm_tx_timer    = NULL;
@@ -173,6 +178,9 @@ static bool IRAM_ATTR tx_compare_callback(mcpwm_cmpr_handle_t cmpr,
 
             if (state == 1) {
                 /* Start bit: first half should read 0 */
+                if (echo_enabled) {
+                    startbit_ticks_tx = p1p2_rx_ticks_now() - TICKS_PER_SEMIBIT;
+                }
                 startbit_delta_tx = time_msec;
                 time_msec = 0;
                 tx_rx_readbackerror = 0;
@@ -235,8 +243,13 @@ static bool IRAM_ATTR tx_compare_callback(mcpwm_cmpr_handle_t cmpr,
         if (head != rx_buffer_tail) {
             rx_buffer[head] = tx_byte_verify;
             delta_buffer[head] = startbit_delta_tx;
-            error_buffer[head] = tx_rx_readbackerror;
+            ts_buffer[head] = startbit_ticks_tx;
+            error_buffer[head] = tx_rx_readbackerror | P1P2_SIGNAL_ECHO;
             rx_buffer_head = head;
+
+            uint8_t used = (head >= rx_buffer_tail) ? head - rx_buffer_tail
+                                                    : head + P1P2_RX_BUFFER_SIZE - rx_buffer_tail;
+            if (used > rx_ring_hwm) rx_ring_hwm = used;
         } else {
             error_buffer[rx_buffer_head] |= P1P2_ERROR_OR;
             gpio_set_level(gpio_led_error, 1);
@@ -302,6 +315,10 @@ void p1p2_tx_write_byte(uint8_t b, uint16_t delay)
         tx_buffer[head] = b;
         tx_buffer_delay[head] = delay;
         tx_buffer_head = head;
+
+        uint8_t tail = tx_buffer_tail;
+        uint8_t used = (head >= tail) ? head - tail : head + P1P2_TX_BUFFER_SIZE - tail;
+        if (used > tx_buffer_hwm) tx_buffer_hwm = used;
     } else {
         /* Not writing — schedule transmission */
         tx_byte = b;
@@ -314,6 +331,13 @@ void p1p2_tx_write_byte(uint8_t b, uint16_t delay)
     }
 }
 
+uint8_t p1p2_tx_ring_hwm(bool reset)
+{
+    uint8_t hwm = tx_buffer_hwm;
+    if (reset) tx_buffer_hwm = 0;
+    return hwm;
+}
+
 bool p1p2_tx_is_idle(void)
 {
     return (tx_state == TX_STATE_IDLE);
@@ -350,8 +374,10 @@ esp_err_t p1p2_tx_init(int gpio_tx, int gpio_rx)
     tx_wait = 0;
     tx_buffer_head = 0;
     tx_buffer_tail = 0;
+    tx_buffer_hwm = 0;
     tx_setdelay = 0;
     startbit_delta_tx = 0;
+    startbit_ticks_tx = 0;
 
     /* Set TX pin HIGH initially (idle bus state) */
     gpio_config_t tx_pin_cfg = {
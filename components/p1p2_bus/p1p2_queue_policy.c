@@ -0,0 +1,31 @@
+/*
+ * P1P2 Queue Policy — Post to a FreeRTOS queue under an overflow policy
+ *
+ * Shared by the subscriber queues and the write request queue
+ * (p1p2_bus.c) and the protocol command queue. Kept apart from p1p2_bus.c
+ * so it builds without the bus hardware, for the unit tests.
+ *
+ * ESP32-C6 port: 2026
+ */
+
+#include "p1p2_bus.h"
+
+esp_err_t p1p2_queue_post(QueueHandle_t q, const void *item, p1p2_queue_policy_t policy,
+                          uint16_t block_ms, void *evicted, uint8_t *n_evicted)
+{
+    *n_evicted = 0;
+
+    switch (policy) {
+    case P1P2_QUEUE_BLOCK:
+        return xQueueSend(q, item, pdMS_TO_TICKS(block_ms)) == pdTRUE ? ESP_OK : ESP_ERR_TIMEOUT;
+
+    case P1P2_QUEUE_DROP_OLDEST:
+        if (xQueueSend(q, item, 0) == pdTRUE) return ESP_OK;
+        if (xQueueReceive(q, evicted, 0) == pdTRUE) *n_evicted = 1;
+        return xQueueSend(q, item, 0) == pdTRUE ? ESP_OK : ESP_ERR_TIMEOUT;
+
+    case P1P2_QUEUE_DROP_NEWEST:
+    default:
+        return xQueueSend(q, item, 0) == pdTRUE ? ESP_OK : ESP_ERR_TIMEOUT;
+    }
+}
@@ -0,0 +1,139 @@
+/*
+ * P1P2 Traffic Statistics — Per (source, destination, type) packet counters
+ *
+ * Memory: P1P2_TRAFFIC_MAX_ENTRIES entries of ~120 bytes (two 24-bucket
+ * histograms each), allocated statically.
+ *
+ * ESP32-C6 port: 2026
+ */
+
+#include <string.h>
+#include "esp_err.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "p1p2_traffic_stats.h"
+
+static const char *TAG = "p1p2_traffic";
+
+static p1p2_traffic_entry_t entries[P1P2_TRAFFIC_MAX_ENTRIES];
+static bool     entry_used[P1P2_TRAFFIC_MAX_ENTRIES];
+static uint32_t overflow_count;
+static int64_t  prev_eop_us;            /* end of the previous packet on the bus */
+static SemaphoreHandle_t stats_mutex;
+
+/* Called from p1p2_bus_init() before bus_io_task starts */
+esp_err_t p1p2_traffic_stats_init(void)
+{
+    if (!stats_mutex) stats_mutex = xSemaphoreCreateMutex();
+    if (!stats_mutex) return ESP_ERR_NO_MEM;
+
+    memset(entry_used, 0, sizeof(entry_used));
+    overflow_count = 0;
+    prev_eop_us = 0;
+    return ESP_OK;
+}
+
+static inline uint8_t key_hash(uint8_t src, uint8_t dst, uint8_t type)
+{
+    return (type ^ (src >> 2) ^ (dst >> 1)) & (P1P2_TRAFFIC_MAX_ENTRIES - 1);
+}
+
+/*
+ * Find or claim the entry for (src, dst, type). NULL if the probe window is full.
+ */
+static p1p2_traffic_entry_t *find_entry(uint8_t src, uint8_t dst, uint8_t type)
+{
+    uint8_t slot = key_hash(src, dst, type);
+
+    for (uint8_t i = 0; i < P1P2_TRAFFIC_MAX_PROBE; i++) {
+        p1p2_traffic_entry_t *e = &entries[slot];
+        if (!entry_used[slot]) {
+            memset(e, 0, sizeof(*e));
+            e->src = src;
+            e->dst = dst;
+            e->type = type;
+            e->len_min = 0xFF;
+            entry_used[slot] = true;
+            return e;
+        }
+        if (e->src == src && e->dst == dst && e->type == type) return e;
+        slot = (slot + 1) & (P1P2_TRAFFIC_MAX_ENTRIES - 1);
+    }
+    return NULL;
+}
+
+void p1p2_traffic_stats_record(const p1p2_packet_t *pkt)
+{
+    if (!stats_mutex) return;
+
+    int64_t gap = prev_eop_us ? pkt->start_us - prev_eop_us : -1;
+    prev_eop_us = pkt->eop_us;
+
+    /* Packets without a full header are not attributable */
+    if (pkt->length < 3) return;
+
+    xSemaphoreTake(stats_mutex, portMAX_DELAY);
+
+    p1p2_traffic_entry_t *e = find_entry(pkt->data[0], pkt->data[1], pkt->data[2]);
+    if (!e) {
+        if (overflow_count++ == 0) {
+            ESP_LOGW(TAG, "Traffic table full, %02X/%02X/%02X not tracked",
+                     pkt->data[0], pkt->data[1], pkt->data[2]);
+        }
+        xSemaphoreGive(stats_mutex);
+        return;
+    }
+
+    e->count++;
+    if (pkt->has_error) e->errors++;
+    e->len_sum += pkt->length;
+    if (pkt->length < e->len_min) e->len_min = pkt->length;
+    if (pkt->length > e->len_max) e->len_max = pkt->length;
+
+    if (gap >= 0) {
+        p1p2_hist_add(&e->gap_us, gap > UINT32_MAX ? UINT32_MAX : (uint32_t)gap);
+    }
+    if (e->last_start_us) {
+        int64_t period = pkt->start_us - e->last_start_us;
+        if (period >= 0) {
+            p1p2_hist_add(&e->period_us, period > UINT32_MAX ? UINT32_MAX : (uint32_t)period);
+        }
+    }
+    e->last_start_us = pkt->start_us;
+
+    xSemaphoreGive(stats_mutex);
+}
+
+bool p1p2_traffic_stats_get(int index, p1p2_traffic_entry_t *out)
+{
+    if (!stats_mutex || index < 0) return false;
+
+    bool found = false;
+    xSemaphoreTake(stats_mutex, portMAX_DELAY);
+    for (int i = 0; i < P1P2_TRAFFIC_MAX_ENTRIES; i++) {
+        if (!entry_used[i]) continue;
+        if (index-- == 0) {
+            *out = entries[i];
+            found = true;
+            break;
+        }
+    }
+    xSemaphoreGive(stats_mutex);
+    return found;
+}
+
+uint32_t p1p2_traffic_stats_overflow(void)
+{
+    return overflow_count;
+}
+
+void p1p2_traffic_stats_reset(void)
+{
+    if (!stats_mutex) return;
+
+    xSemaphoreTake(stats_mutex, portMAX_DELAY);
+    memset(entry_used, 0, sizeof(entry_used));
+    overflow_count = 0;
+    xSemaphoreGive(stats_mutex);
+}
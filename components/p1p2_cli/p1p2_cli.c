@@ -17,13 +17,18 @@
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <time.h>
 #include "esp_log.h"
 #include "esp_console.h"
 #include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
 #include "p1p2_bus.h"
+#include "p1p2_traffic_stats.h"
+#include "p1p2_bus_load.h"
 #include "p1p2_protocol.h"
+#include "p1p2_fixed.h"
 #include "p1p2_network.h"
 
 static const char *TAG = "p1p2_cli";
@@ -55,17 +60,17 @@ static int cmd_control_level(int argc, char **argv)
 static int cmd_status(int argc, char **argv)
 {
     p1p2_hvac_state_t state;
-    p1p2_protocol_get_state_copy(&state);
+    p1p2_protocol_read_state(&state);  /* leaves change tracking to Matter */
 
     printf("=== P1P2MQTT ESP32-C6 Status ===\n");
     printf("Data valid:   %s\n", state.data_valid ? "YES" : "NO");
     printf("Power:        %s\n", state.power ? "ON" : "OFF");
     printf("Mode:         %d\n", state.mode);
     printf("Running:      %d\n", state.running);
-    printf("Cool target:  %.1f C\n", state.target_temp_cool / 10.0);
-    printf("Heat target:  %.1f C\n", state.target_temp_heat / 10.0);
-    printf("Room temp:    %.1f C\n", state.room_temp / 10.0);
-    printf("Outdoor temp: %.1f C\n", state.outdoor_temp / 10.0);
+    printf("Cool target:  " P1P2_FMT_X10 " C\n", P1P2_X10(state.target_temp_cool));
+    printf("Heat target:  " P1P2_FMT_X10 " C\n", P1P2_X10(state.target_temp_heat));
+    printf("Room temp:    " P1P2_FMT_X10 " C\n", P1P2_X10(state.room_temp));
+    printf("Outdoor temp: " P1P2_FMT_X10 " C\n", P1P2_X10(state.outdoor_temp));
     printf("Fan cool:     %d\n", state.fan_mode_cool);
     printf("Fan heat:     %d\n", state.fan_mode_heat);
     printf("Comp freq:    %d Hz\n", state.compressor_freq);
@@ -73,18 +78,48 @@ static int cmd_status(int argc, char **argv)
     printf("Op hours:     %lu\n", (unsigned long)state.operation_hours);
     printf("Packets:      %lu\n", (unsigned long)state.packet_count);
 
+    uint32_t skipped, decoded;
+    p1p2_protocol_get_decode_stats(&skipped, &decoded);
+    printf("Decoded:      %lu (%lu repeats skipped)\n",
+           (unsigned long)decoded, (unsigned long)skipped);
+
     p1p2_bus_stats_t bus_stats;
     p1p2_bus_get_stats(&bus_stats);
     printf("\n=== Bus Statistics ===\n");
     printf("RX packets:   %lu\n", (unsigned long)bus_stats.packets_received);
     printf("TX packets:   %lu\n", (unsigned long)bus_stats.packets_sent);
+    printf("TX confirmed: %lu (read-back errors %lu)\n",
+           (unsigned long)bus_stats.tx_confirmed,
+           (unsigned long)bus_stats.tx_readback_errors);
+    printf("TX idle:      %lu in window, %lu dropped without one\n",
+           (unsigned long)bus_stats.tx_idle_windows,
+           (unsigned long)bus_stats.tx_idle_expired);
     printf("CRC errors:   %lu\n", (unsigned long)bus_stats.crc_errors);
     printf("Parity err:   %lu\n", (unsigned long)bus_stats.parity_errors);
     printf("Collisions:   %lu\n", (unsigned long)bus_stats.collision_errors);
     printf("Overruns:     %lu\n", (unsigned long)bus_stats.overrun_errors);
     printf("Uptime:       %lld s\n", bus_stats.uptime_us / 1000000LL);
 
+    p1p2_clock_info_t clock;
+    int64_t now_us;
+    p1p2_protocol_get_clock_info(&clock);
+    if (p1p2_protocol_clock_now(&now_us) == ESP_OK) {
+        time_t secs = (time_t)(now_us / 1000000);
+        struct tm tm;
+        gmtime_r(&secs, &tm);
+        printf("Bus clock:    %04d-%02d-%02d %02d:%02d:%02d (%s, ±%lu ms, last adjust %ld ms, %lu jumps)\n",
+               tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec,
+               clock.sync == P1P2_CLOCK_SYNCED ? "synced" : "coarse",
+               (unsigned long)(clock.error_us / 1000), (long)(clock.last_adjust_us / 1000),
+               (unsigned long)clock.jumps);
+    } else {
+        printf("Bus clock:    not received\n");
+    }
+
     printf("\nControl level: %d\n", p1p2_protocol_get_control_level());
+    int model = p1p2_protocol_get_model();
+    if (model) printf("F model: %d\n", model);
+    else printf("F model: detecting\n");
     printf("Matter: %s\n", "pending SDK integration");
 
     return 0;
@@ -104,6 +139,387 @@ static int cmd_voltage(int argc, char **argv)
     return 0;
 }
 
+/*
+ * Command: M — Monitor bus packets (hex dump)
+ *   M [seconds] [type ...]   e.g. "M 10 38 3B" dumps 0x38/0x3B for 10 s
+ * Uses its own bus subscription, so the protocol task is unaffected.
+ */
+static int cmd_monitor(int argc, char **argv)
+{
+    int seconds = (argc > 1) ? atoi(argv[1]) : 10;
+    if (seconds <= 0) seconds = 10;
+
+    p1p2_packet_filter_t filter = P1P2_PACKET_FILTER_ALL();
+    if (argc > 2) {
+        memset(&filter, 0, sizeof(filter));
+        for (int i = 2; i < argc; i++) {
+            p1p2_filter_add_type(&filter, (uint8_t)strtoul(argv[i], NULL, 16));
+        }
+    }
+
+    QueueHandle_t q;
+    esp_err_t ret = p1p2_bus_subscribe(&filter, 8, &q);
+    if (ret != ESP_OK) {
+        printf("Subscribe failed: %s\n", esp_err_to_name(ret));
+        return 1;
+    }
+
+    p1p2_packet_t pkt;
+    int64_t end_us = esp_timer_get_time() + (int64_t)seconds * 1000000;
+    while (esp_timer_get_time() < end_us) {
+        if (xQueueReceive(q, &pkt, pdMS_TO_TICKS(100)) != pdTRUE) continue;
+        printf("R %5u ", pkt.delta);
+        for (uint8_t i = 0; i < pkt.length; i++) printf("%02X", pkt.data[i]);
+        printf("%s\n", pkt.has_error ? " ERR" : "");
+    }
+
+    p1p2_bus_unsubscribe(q);
+    return 0;
+}
+
+/*
+ * Command: Q — Queue and ring buffer statistics
+ *   Q     show high-water marks and drops
+ *   Q r   show, then reset
+ */
+static int cmd_queues(int argc, char **argv)
+{
+    bool reset = (argc > 1 && argv[1][0] == 'r');
+    p1p2_bus_stats_t bus_stats;
+    p1p2_bus_get_stats(&bus_stats);
+    uint8_t cmd_hwm;
+    uint32_t cmd_dropped;
+    p1p2_protocol_get_cmd_queue_stats(&cmd_hwm, &cmd_dropped, reset);
+
+    printf("=== Queue high-water marks ===\n");
+    printf("RX ring:      %u / %d bytes\n", bus_stats.rx_ring_hwm, P1P2_RX_BUFFER_SIZE - 1);
+    printf("TX ring:      %u / %d bytes\n", bus_stats.tx_ring_hwm, P1P2_TX_BUFFER_SIZE - 1);
+    printf("RX queue:     %u / %d packets\n", bus_stats.rx_queue_hwm, P1P2_PACKET_QUEUE_SIZE);
+    printf("TX queue:     %u / %d requests\n", bus_stats.tx_queue_hwm, P1P2_PACKET_QUEUE_SIZE);
+    printf("Cmd queue:    %u / %d commands\n", cmd_hwm, P1P2_CMD_QUEUE_SIZE);
+
+    printf("\n=== Drops ===\n");
+    printf("RX packets:   %lu\n", (unsigned long)bus_stats.rx_dropped);
+    printf("TX requests:  %lu\n", (unsigned long)bus_stats.tx_dropped);
+    printf("Commands:     %lu\n", (unsigned long)cmd_dropped);
+    for (int t = 0; t < 256; t++) {
+        uint16_t n = p1p2_bus_get_type_drops(t);
+        if (n) printf("  type 0x%02X: %u\n", t, n);
+    }
+
+    if (reset) {
+        p1p2_bus_reset_queue_stats();
+        printf("\nCounters reset\n");
+    }
+    return 0;
+}
+
+/*
+ * Command: P — Per-packet-type traffic statistics
+ *   P     table of (src, dst, type) counters with gap/period percentiles (ms)
+ *   P h   also print the non-empty histogram buckets
+ *   P r   reset
+ */
+static int cmd_traffic(int argc, char **argv)
+{
+    if (argc > 1 && argv[1][0] == 'r') {
+        p1p2_traffic_stats_reset();
+        printf("Traffic statistics reset\n");
+        return 0;
+    }
+    bool show_hist = (argc > 1 && argv[1][0] == 'h');
+
+    p1p2_traffic_entry_t e;
+    printf("SRC DST TYP     COUNT   ERR LEN min/avg/max  gap p50/p90 ms  period p50/p90 ms\n");
+    for (int i = 0; p1p2_traffic_stats_get(i, &e); i++) {
+        printf(" %02X  %02X  %02X %9lu %5lu     %3u/%3lu/%3u   %6lu/%6lu     %7lu/%7lu\n",
+               e.src, e.dst, e.type,
+               (unsigned long)e.count, (unsigned long)e.errors,
+               e.len_min, (unsigned long)(e.len_sum / e.count), e.len_max,
+               (unsigned long)(p1p2_hist_percentile(&e.gap_us, 50) / 1000),
+               (unsigned long)(p1p2_hist_percentile(&e.gap_us, 90) / 1000),
+               (unsigned long)(p1p2_hist_percentile(&e.period_us, 50) / 1000),
+               (unsigned long)(p1p2_hist_percentile(&e.period_us, 90) / 1000));
+        if (show_hist) {
+            for (int b = 0; b < P1P2_HIST_BUCKETS; b++) {
+                if (e.gap_us.bucket[b] || e.period_us.bucket[b]) {
+                    printf("      <%8lu us: gap %5u  period %5u\n",
+                           (unsigned long)p1p2_hist_bucket_max(b) + 1,
+                           e.gap_us.bucket[b], e.period_us.bucket[b]);
+                }
+            }
+        }
+    }
+    uint32_t overflow = p1p2_traffic_stats_overflow();
+    if (overflow) printf("Untracked (table full): %lu\n", (unsigned long)overflow);
+    return 0;
+}
+
+/*
+ * Command: B — Bus load (busy time vs idle, our TX share of busy time)
+ */
+static int cmd_bus_load(int argc, char **argv)
+{
+    p1p2_bus_load_t load;
+    p1p2_bus_get_load(&load);
+
+    printf("Bus load 1s:   %3u.%u %%\n", load.load_1s / 10, load.load_1s % 10);
+    printf("Bus load 1m:   %3u.%u %% (%u packets)\n",
+           load.load_1m / 10, load.load_1m % 10, load.packets_1m);
+    printf("Bus load 15m:  %3u.%u %%\n", load.load_15m / 10, load.load_15m % 10);
+    printf("Our TX share:  %3u.%u %% (1m)  %3u.%u %% (15m)\n",
+           load.tx_share_1m / 10, load.tx_share_1m % 10,
+           load.tx_share_15m / 10, load.tx_share_15m % 10);
+    return 0;
+}
+
+/*
+ * Command: G — Get bus parameters, decoded on demand
+ *   G          lists every parameter with its current value
+ *   G <name>   shows parameters with that name (e.g. "G error_code")
+ * Parameters changed since the previous G are marked with '*'.
+ */
+static int cmd_get_param(int argc, char **argv)
+{
+    const char *name;
+    uint8_t type;
+    int shown = 0;
+
+    for (uint16_t id = 0; (name = p1p2_protocol_get_param_name(id, &type)) != NULL; id++) {
+        if (argc > 1 && strcmp(name, argv[1]) != 0) continue;
+
+        int64_t value;
+        esp_err_t ret = p1p2_protocol_get_param(id, &value);
+        char mark = p1p2_protocol_param_changed(id, true) ? '*' : ' ';
+        if (ret == ESP_OK) {
+            printf("%3u  %02X %c%-20s %lld\n", id, type, mark, name, (long long)value);
+        } else {
+            printf("%3u  %02X %c%-20s -\n", id, type, mark, name);
+        }
+        shown++;
+    }
+    if (!shown) printf("No parameter named %s\n", argv[1]);
+    return 0;
+}
+
+/*
+ * Command: U — Units on the bus, each with its own decoded state
+ */
+static int cmd_units(int argc, char **argv)
+{
+    p1p2_unit_info_t units[P1P2_MAX_UNITS + 1];
+    int n = p1p2_protocol_get_units(units, P1P2_MAX_UNITS + 1);
+
+    if (n == 0) {
+        printf("No units seen yet\n");
+        return 0;
+    }
+    printf("Addr  Pkts      Age(s)  Power Mode  Cool   Heat   Room\n");
+    for (int i = 0; i < n; i++) {
+        p1p2_hvac_state_t state;
+        if (p1p2_protocol_get_unit_state(units[i].addr, &state) != ESP_OK) continue;
+        char cool[P1P2_FMT_X10_LEN], heat[P1P2_FMT_X10_LEN], room[P1P2_FMT_X10_LEN];
+        printf("%02X%c   %-9lu %-7lu %-5s %-5d %5s  %5s  %5s\n",
+               units[i].addr, units[i].primary ? '*' : ' ',
+               (unsigned long)units[i].packets, (unsigned long)(units[i].age_ms / 1000),
+               state.power ? "ON" : "OFF", state.mode,
+               p1p2_fmt_x10(cool, state.target_temp_cool), p1p2_fmt_x10(heat, state.target_temp_heat),
+               p1p2_fmt_x10(room, state.room_temp));
+    }
+    uint32_t dropped = p1p2_protocol_get_units_dropped();
+    if (dropped) printf("Not decoded (unit table full): %lu\n", (unsigned long)dropped);
+    return 0;
+}
+
+/*
+ * Command: T — Response latency per request stream and bus cycle period
+ *   T     table of (src, dst, type) requests with responder and latency (us)
+ *   T r   reset
+ */
+static int cmd_timing(int argc, char **argv)
+{
+    if (argc > 1 && argv[1][0] == 'r') {
+        p1p2_protocol_reset_pair_stats();
+        printf("Pair statistics reset\n");
+        return 0;
+    }
+
+    p1p2_pair_stats_t ps;
+    printf("SRC DST TYP RSP  REQUESTS  NO-REPLY  latency p50/p90/p99 us\n");
+    for (int i = 0; p1p2_protocol_get_pair_stats(i, &ps); i++) {
+        if (ps.answered) {
+            printf(" %02X  %02X  %02X  %02X %9lu %9lu  %6lu/%6lu/%6lu\n",
+                   ps.src, ps.dst, ps.type, ps.responder,
+                   (unsigned long)ps.requests, (unsigned long)ps.unanswered,
+                   (unsigned long)p1p2_hist_percentile(&ps.latency_us, 50),
+                   (unsigned long)p1p2_hist_percentile(&ps.latency_us, 90),
+                   (unsigned long)p1p2_hist_percentile(&ps.latency_us, 99));
+        } else {
+            printf(" %02X  %02X  %02X   - %9lu %9lu       -\n",
+                   ps.src, ps.dst, ps.type,
+                   (unsigned long)ps.requests, (unsigned long)ps.unanswered);
+        }
+    }
+
+    p1p2_hist_t cycle;
+    uint8_t anchor;
+    uint32_t cycles = p1p2_protocol_get_cycle_stats(&cycle, &anchor);
+    if (cycles) {
+        printf("Bus cycle (type %02X): %lu cycles, period p50/p90/p99 %lu/%lu/%lu ms\n",
+               anchor, (unsigned long)cycles,
+               (unsigned long)(p1p2_hist_percentile(&cycle, 50) / 1000),
+               (unsigned long)(p1p2_hist_percentile(&cycle, 90) / 1000),
+               (unsigned long)(p1p2_hist_percentile(&cycle, 99) / 1000));
+    }
+    uint32_t overflow = p1p2_protocol_get_pair_overflow();
+    if (overflow) printf("Untracked (table full): %lu\n", (unsigned long)overflow);
+    return 0;
+}
+
+/*
+ * Command: C — Counter (0xA3) polling
+ *   C                        show polling statistics
+ *   C <interval_s> [load]    poll every interval_s (0 = off) while the bus
+ *                            load is below load (0.1 % units)
+ */
+static int cmd_counters(int argc, char **argv)
+{
+    p1p2_counter_poll_stats_t cs;
+    p1p2_protocol_get_counter_poll_stats(&cs);
+
+    if (argc > 1) {
+        uint32_t interval = strtoul(argv[1], NULL, 10);
+        uint16_t load = (argc > 2) ? (uint16_t)strtoul(argv[2], NULL, 10) : cs.max_load;
+        if (load > 1000) {
+            printf("Load budget is in 0.1 %% units (0-1000)\n");
+            return 1;
+        }
+        p1p2_protocol_set_counter_poll(interval, load);
+        p1p2_protocol_get_counter_poll_stats(&cs);
+    }
+
+    if (cs.interval_s) {
+        printf("Counter poll: every %lu s, below %u.%u %% bus load\n",
+               (unsigned long)cs.interval_s, cs.max_load / 10, cs.max_load % 10);
+    } else {
+        printf("Counter poll: off\n");
+    }
+    if (p1p2_protocol_get_control_level() != P1P2_CONTROL_AUX) {
+        printf("(requests are only sent at control level 1)\n");
+    }
+    printf("Requests:     %lu, replies %lu, timeouts %lu, unsent %lu, read-back errors %lu\n",
+           (unsigned long)cs.requests, (unsigned long)cs.replies, (unsigned long)cs.timeouts,
+           (unsigned long)cs.unsent, (unsigned long)cs.readback_errors);
+    printf("Held back:    %lu by load/queue, %lu after collisions; retry every %lu cycles\n",
+           (unsigned long)cs.deferred, (unsigned long)cs.collision_backoffs,
+           (unsigned long)(1UL << cs.backoff));
+    if (cs.replies) {
+        printf("Last reply:   %lld s ago\n",
+               (long long)((esp_timer_get_time() - cs.last_reply_us) / 1000000));
+    }
+    return 0;
+}
+
+/*
+ * Command: D — Byte changes of packet types the decoder does not know
+ *   D                 tracked types
+ *   D <type>          per-byte changes and most frequent values (hex type)
+ *   D w [seconds]     print byte change events as they happen (default 60 s)
+ *   D r               reset
+ */
+static void print_diff_event(const p1p2_diff_event_t *e)
+{
+    printf("%6lu.%03lu %02X>%02X %02X ", (unsigned long)(e->time_ms / 1000),
+           (unsigned long)(e->time_ms % 1000), e->src, e->dst, e->type);
+    if (e->offset == P1P2_DIFF_NEW_TYPE) {
+        printf("new type, %u bytes\n", e->to);
+    } else if (e->offset == P1P2_DIFF_LENGTH) {
+        printf("length %u -> %u\n", e->from, e->to);
+    } else if (e->changes > 1) {
+        printf("byte %2u: %02X -> %02X (%u changes)\n", e->offset, e->from, e->to, e->changes);
+    } else {
+        printf("byte %2u: %02X -> %02X\n", e->offset, e->from, e->to);
+    }
+}
+
+static int cmd_diff(int argc, char **argv)
+{
+    if (argc > 1 && argv[1][0] == 'r') {
+        p1p2_protocol_diff_reset();
+        printf("Byte diff reset\n");
+        return 0;
+    }
+
+    if (argc > 1 && argv[1][0] == 'w') {
+        int seconds = (argc > 2) ? atoi(argv[2]) : 60;
+        if (seconds <= 0) seconds = 60;
+
+        uint32_t cursor = p1p2_protocol_diff_seq();
+        uint32_t lost = 0;
+        p1p2_diff_event_t ev[16];
+        int64_t end_us = esp_timer_get_time() + (int64_t)seconds * 1000000;
+        while (esp_timer_get_time() < end_us) {
+            int n = p1p2_protocol_diff_read(&cursor, ev, 16, &lost);
+            for (int i = 0; i < n; i++) print_diff_event(&ev[i]);
+            if (n < 16) vTaskDelay(pdMS_TO_TICKS(100));
+        }
+        if (lost) printf("(%lu events lost)\n", (unsigned long)lost);
+        return 0;
+    }
+
+    p1p2_diff_type_info_t types[32];
+    int n = p1p2_protocol_diff_types(types, 32);
+    uint32_t now_ms = (uint32_t)(esp_timer_get_time() / 1000);
+
+    if (argc > 1) {
+        uint8_t type = (uint8_t)strtoul(argv[1], NULL, 16);
+        bool shown = false;
+        for (int i = 0; i < n; i++) {
+            if (types[i].type != type) continue;
+            p1p2_diff_byte_t bytes[P1P2_MAX_PACKET_SIZE];
+            uint8_t len;
+            if (p1p2_protocol_diff_bytes(types[i].src, types[i].dst, type, bytes,
+                                         P1P2_MAX_PACKET_SIZE, &len) != ESP_OK) continue;
+            shown = true;
+            printf("%02X>%02X type %02X: %u bytes, %lu packets\n", types[i].src, types[i].dst,
+                   type, len, (unsigned long)types[i].packets);
+            printf("Byte Now Changes Age(s)  Values (packets)\n");
+            for (int b = 0; b < len; b++) {
+                if (bytes[b].changes) {
+                    printf("%4d  %02X %7u %6lu ", b, bytes[b].value, bytes[b].changes,
+                           (unsigned long)((now_ms - bytes[b].last_change_ms) / 1000));
+                } else {
+                    printf("%4d  %02X       0      - ", b, bytes[b].value);
+                }
+                for (int k = 0; k < P1P2_DIFF_TOP && bytes[b].top_count[k]; k++) {
+                    printf(" %02X:%u", bytes[b].top_value[k], bytes[b].top_count[k]);
+                }
+                printf("\n");
+            }
+        }
+        if (!shown) printf("Type %02X not tracked\n", type);
+        return 0;
+    }
+
+    if (n == 0) {
+        printf("No unknown packet types seen yet\n");
+        return 0;
+    }
+    printf("SRC DST TYP LEN   PACKETS   CHANGES  last change (s ago)\n");
+    for (int i = 0; i < n; i++) {
+        printf(" %02X  %02X  %02X %3u %9lu %9lu", types[i].src, types[i].dst, types[i].type,
+               types[i].length, (unsigned long)types[i].packets, (unsigned long)types[i].changes);
+        if (types[i].changes) {
+            printf("  %lu\n", (unsigned long)((now_ms - types[i].last_change_ms) / 1000));
+        } else {
+            printf("  -\n");
+        }
+    }
+    uint32_t untracked = p1p2_protocol_diff_untracked();
+    if (untracked) printf("Untracked (table full): %lu\n", (unsigned long)untracked);
+    return 0;
+}
+
 /*
  * Command: R — Factory reset
  */
@@ -140,6 +556,60 @@ static void register_commands(void)
             .hint = NULL,
             .func = cmd_voltage,
         },
+        {
+            .command = "M",
+            .help = "Monitor bus packets (default 10 s, all types)",
+            .hint = "[seconds] [type ...]",
+            .func = cmd_monitor,
+        },
+        {
+            .command = "Q",
+            .help = "Show queue high-water marks and drops (Q r to reset)",
+            .hint = "[r]",
+            .func = cmd_queues,
+        },
+        {
+            .command = "P",
+            .help = "Per-packet-type traffic statistics (P h = histograms, P r = reset)",
+            .hint = "[h|r]",
+            .func = cmd_traffic,
+        },
+        {
+            .command = "B",
+            .help = "Show bus load (1 s / 1 min / 15 min) and our TX share",
+            .hint = NULL,
+            .func = cmd_bus_load,
+        },
+        {
+            .command = "G",
+            .help = "Get bus parameters by name (all if none given)",
+            .hint = "[name]",
+            .func = cmd_get_param,
+        },
+        {
+            .command = "U",
+            .help = "List units on the bus (* = primary, reported to Matter)",
+            .hint = NULL,
+            .func = cmd_units,
+        },
+        {
+            .command = "T",
+            .help = "Response latency per request and bus cycle period (T r to reset)",
+            .hint = "[r]",
+            .func = cmd_timing,
+        },
+        {
+            .command = "C",
+            .help = "Counter (0xA3) polling: show, or set interval in s (0 = off) and load budget in 0.1 %",
+            .hint = "[interval_s] [load]",
+            .func = cmd_counters,
+        },
+        {
+            .command = "D",
+            .help = "Byte changes of unknown packet types (D <type> = per byte, D w = watch, D r = reset)",
+            .hint = "[type|w [seconds]|r]",
+            .func = cmd_diff,
+        },
         {
             .command = "R",
             .help = "Factory reset (erases all config)",
@@ -80,6 +80,14 @@ extern "C" {
 #define ATTR_VRV_BUS_VOLTAGE_P1     0x0005  /* uint16_t, mV */
 #define ATTR_VRV_BUS_VOLTAGE_P2     0x0006  /* uint16_t, mV */
 #define ATTR_VRV_PACKET_COUNT       0x0007  /* uint32_t */
+#define ATTR_VRV_BUS_LOAD_1M        0x0008  /* uint16_t, 0.1 % of bus time busy */
+#define ATTR_VRV_BUS_LOAD_15M       0x0009  /* uint16_t, 0.1 % */
+#define ATTR_VRV_BUS_TX_SHARE       0x000A  /* uint16_t, 0.1 % of busy time ours (15 min) */
+#define ATTR_VRV_AUX_LATENCY_P50    0x000B  /* uint32_t, µs, responses from 0x40 (us in aux mode) */
+#define ATTR_VRV_AUX_LATENCY_P99    0x000C  /* uint32_t, µs */
+#define ATTR_VRV_PEER_LATENCY_P99   0x000D  /* uint32_t, µs, responses from other devices */
+#define ATTR_VRV_CYCLE_P50          0x000E  /* uint32_t, µs, bus cycle period */
+#define ATTR_VRV_CYCLE_P99          0x000F  /* uint32_t, µs */
 
 /* ---- On/Off Cluster Attributes (0x0006) ---- */
 #define ATTR_ON_OFF                 0x0000  /* bool */
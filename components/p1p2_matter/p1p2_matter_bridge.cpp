@@ -219,6 +219,24 @@ esp_err_t p1p2_matter_bridge_create_device(p1p2_matter_write_cb_t write_cb)
             /* Packet count (u32) */
             attribute::create(custom_cluster, ATTR_VRV_PACKET_COUNT,
                             ATTRIBUTE_FLAG_NONE, esp_matter_uint32(0));
+            /* Bus load 1 min / 15 min and our TX share (u16, 0.1 %) */
+            attribute::create(custom_cluster, ATTR_VRV_BUS_LOAD_1M,
+                            ATTRIBUTE_FLAG_NONE, esp_matter_uint16(0));
+            attribute::create(custom_cluster, ATTR_VRV_BUS_LOAD_15M,
+                            ATTRIBUTE_FLAG_NONE, esp_matter_uint16(0));
+            attribute::create(custom_cluster, ATTR_VRV_BUS_TX_SHARE,
+                            ATTRIBUTE_FLAG_NONE, esp_matter_uint16(0));
+            /* Response latency and bus cycle percentiles (u32, µs) */
+            attribute::create(custom_cluster, ATTR_VRV_AUX_LATENCY_P50,
+                            ATTRIBUTE_FLAG_NONE, esp_matter_uint32(0));
+            attribute::create(custom_cluster, ATTR_VRV_AUX_LATENCY_P99,
+                            ATTRIBUTE_FLAG_NONE, esp_matter_uint32(0));
+            attribute::create(custom_cluster, ATTR_VRV_PEER_LATENCY_P99,
+                            ATTRIBUTE_FLAG_NONE, esp_matter_uint32(0));
+            attribute::create(custom_cluster, ATTR_VRV_CYCLE_P50,
+                            ATTRIBUTE_FLAG_NONE, esp_matter_uint32(0));
+            attribute::create(custom_cluster, ATTR_VRV_CYCLE_P99,
+                            ATTRIBUTE_FLAG_NONE, esp_matter_uint32(0));
         }
         ESP_LOGI(TAG, "Custom VRV endpoint created: %d", endpoint::get_id(ep));
     }
@@ -9,6 +9,8 @@
  *   - Operation hours / compressor starts
  *   - Bus voltage monitoring
  *   - Packet statistics
+ *   - Bus load (utilization and our TX share)
+ *   - Response latency and bus cycle period percentiles
  *
  * ESP32-C6 port: 2026
  */
@@ -17,7 +19,10 @@
 #include "p1p2_matter.h"
 #include "p1p2_matter_clusters.h"
 #include "p1p2_protocol.h"
+#include "p1p2_fixed.h"
+#include "p1p2_fseries.h"
 #include "p1p2_bus.h"
+#include "p1p2_bus_load.h"
 
 #ifdef P1P2_MATTER_SDK_AVAILABLE
 #include "p1p2_matter_bridge.h"
@@ -35,6 +40,25 @@ static uint32_t prev_op_hours = 0xFFFFFFFF;
 static uint32_t prev_comp_starts = 0xFFFFFFFF;
 static uint32_t prev_packet_count = 0xFFFFFFFF;
 
+/*
+ * Merge the latency histograms of all request streams: those answered
+ * from the auxiliary controller address and those answered by others.
+ */
+static void merge_latency(p1p2_hist_t *aux, p1p2_hist_t *peer)
+{
+    p1p2_pair_stats_t ps;
+
+    p1p2_hist_reset(aux);
+    p1p2_hist_reset(peer);
+    for (int i = 0; p1p2_protocol_get_pair_stats(i, &ps); i++) {
+        p1p2_hist_t *h = (ps.responder == P1P2_ADDR_AUX_CTRL) ? aux : peer;
+        for (int b = 0; b < P1P2_HIST_BUCKETS; b++) {
+            uint32_t n = (uint32_t)h->bucket[b] + ps.latency_us.bucket[b];
+            h->bucket[b] = (n > 0xFFFF) ? 0xFFFF : (uint16_t)n;
+        }
+    }
+}
+
 void p1p2_matter_custom_update(const p1p2_hvac_state_t *state)
 {
     /* Compressor frequency */
@@ -51,7 +75,7 @@ void p1p2_matter_custom_update(const p1p2_hvac_state_t *state)
     /* Flow rate */
     if ((state->changed & CHANGED_FLOW_RATE) &&
         state->flow_rate != prev_flow_rate) {
-        ESP_LOGD(TAG, "Flow rate: %d (%.1f L/min)", state->flow_rate, state->flow_rate / 10.0);
+        ESP_LOGD(TAG, "Flow rate: %d (" P1P2_FMT_X10 " L/min)", state->flow_rate, P1P2_X10(state->flow_rate));
 #ifdef P1P2_MATTER_SDK_AVAILABLE
         p1p2_matter_bridge_update_u16(EP_CUSTOM_VRV, CLUSTER_CUSTOM_VRV,
                                        ATTR_VRV_FLOW_RATE, state->flow_rate);
@@ -121,5 +145,42 @@ void p1p2_matter_custom_update(const p1p2_hvac_state_t *state)
         p1p2_matter_bridge_update_u16(EP_CUSTOM_VRV, CLUSTER_CUSTOM_VRV,
                                        ATTR_VRV_BUS_VOLTAGE_P2, v_p2);
 #endif
+
+        /* Bus load — same cadence, the 1 min window moves slowly enough */
+        p1p2_bus_load_t load;
+        p1p2_bus_get_load(&load);
+        ESP_LOGD(TAG, "Bus load: 1m=%u.%u%% 15m=%u.%u%% tx=%u.%u%%",
+                 load.load_1m / 10, load.load_1m % 10,
+                 load.load_15m / 10, load.load_15m % 10,
+                 load.tx_share_15m / 10, load.tx_share_15m % 10);
+#ifdef P1P2_MATTER_SDK_AVAILABLE
+        p1p2_matter_bridge_update_u16(EP_CUSTOM_VRV, CLUSTER_CUSTOM_VRV,
+                                       ATTR_VRV_BUS_LOAD_1M, load.load_1m);
+        p1p2_matter_bridge_update_u16(EP_CUSTOM_VRV, CLUSTER_CUSTOM_VRV,
+                                       ATTR_VRV_BUS_LOAD_15M, load.load_15m);
+        p1p2_matter_bridge_update_u16(EP_CUSTOM_VRV, CLUSTER_CUSTOM_VRV,
+                                       ATTR_VRV_BUS_TX_SHARE, load.tx_share_15m);
+#endif
+
+        /* Response latency and bus cycle period */
+        p1p2_hist_t aux, peer, cycle;
+        merge_latency(&aux, &peer);
+        p1p2_protocol_get_cycle_stats(&cycle, NULL);
+        ESP_LOGD(TAG, "Latency p99: aux=%lu us peer=%lu us, cycle p50=%lu us",
+                 (unsigned long)p1p2_hist_percentile(&aux, 99),
+                 (unsigned long)p1p2_hist_percentile(&peer, 99),
+                 (unsigned long)p1p2_hist_percentile(&cycle, 50));
+#ifdef P1P2_MATTER_SDK_AVAILABLE
+        p1p2_matter_bridge_update_u32(EP_CUSTOM_VRV, CLUSTER_CUSTOM_VRV,
+                                       ATTR_VRV_AUX_LATENCY_P50, p1p2_hist_percentile(&aux, 50));
+        p1p2_matter_bridge_update_u32(EP_CUSTOM_VRV, CLUSTER_CUSTOM_VRV,
+                                       ATTR_VRV_AUX_LATENCY_P99, p1p2_hist_percentile(&aux, 99));
+        p1p2_matter_bridge_update_u32(EP_CUSTOM_VRV, CLUSTER_CUSTOM_VRV,
+                                       ATTR_VRV_PEER_LATENCY_P99, p1p2_hist_percentile(&peer, 99));
+        p1p2_matter_bridge_update_u32(EP_CUSTOM_VRV, CLUSTER_CUSTOM_VRV,
+                                       ATTR_VRV_CYCLE_P50, p1p2_hist_percentile(&cycle, 50));
+        p1p2_matter_bridge_update_u32(EP_CUSTOM_VRV, CLUSTER_CUSTOM_VRV,
+                                       ATTR_VRV_CYCLE_P99, p1p2_hist_percentile(&cycle, 99));
+#endif
     }
 }
@@ -120,13 +120,16 @@ static void matter_attribute_update_cb(uint16_t endpoint_id, uint32_t cluster_id
 static void matter_task(void *pvParameters)
 {
     p1p2_hvac_state_t state;
+    p1p2_change_cursor_t cursor, next;
     int64_t last_update = 0;
 
     ESP_LOGI(TAG, "Matter task started");
+    p1p2_protocol_cursor_init(&cursor, false);
 
     while (1) {
-        /* Get latest HVAC state */
-        p1p2_protocol_get_state_copy(&state);
+        /* Get latest HVAC state and the fields changed since our last push */
+        next = cursor;
+        p1p2_protocol_read_changes(&next, &state);
 
         /* Only update if state has changed since last push */
         if (state.last_update_us > last_update && state.data_valid) {
@@ -135,6 +138,7 @@ static void matter_task(void *pvParameters)
             p1p2_matter_sensors_update(&state);
             p1p2_matter_custom_update(&state);
             last_update = state.last_update_us;
+            cursor = next;  /* changes before data_valid are kept for the first push */
         }
 
         /* Update every 2 seconds (bus cycle is 0.8-2s) */
@@ -15,6 +15,7 @@
 #include "p1p2_matter.h"
 #include "p1p2_matter_clusters.h"
 #include "p1p2_protocol.h"
+#include "p1p2_fixed.h"
 
 #ifdef P1P2_MATTER_SDK_AVAILABLE
 #include "p1p2_matter_bridge.h"
@@ -34,7 +35,7 @@ void p1p2_matter_sensors_update(const p1p2_hvac_state_t *state)
     if (state->changed & CHANGED_OUTDOOR_TEMP) {
         int16_t outdoor = state->outdoor_temp * 10;  /* ×10 → ×100 */
         if (outdoor != prev_outdoor) {
-            ESP_LOGD(TAG, "Outdoor temp: %d (%.1f°C)", outdoor, outdoor / 100.0);
+            ESP_LOGD(TAG, "Outdoor temp: %d (" P1P2_FMT_X100 "°C)", outdoor, P1P2_X100(outdoor));
 #ifdef P1P2_MATTER_SDK_AVAILABLE
             p1p2_matter_bridge_update_i16(EP_TEMP_OUTDOOR, CLUSTER_TEMP_MEASUREMENT,
                                            ATTR_MEASURED_VALUE, outdoor);
@@ -46,7 +47,7 @@ void p1p2_matter_sensors_update(const p1p2_hvac_state_t *state)
     if (state->changed & CHANGED_ROOM_TEMP) {
         int16_t room = state->room_temp * 10;
         if (room != prev_room) {
-            ESP_LOGD(TAG, "Room temp: %d (%.1f°C)", room, room / 100.0);
+            ESP_LOGD(TAG, "Room temp: %d (" P1P2_FMT_X100 "°C)", room, P1P2_X100(room));
 #ifdef P1P2_MATTER_SDK_AVAILABLE
             p1p2_matter_bridge_update_i16(EP_TEMP_ROOM, CLUSTER_TEMP_MEASUREMENT,
                                            ATTR_MEASURED_VALUE, room);
@@ -58,7 +59,7 @@ void p1p2_matter_sensors_update(const p1p2_hvac_state_t *state)
     if (state->changed & CHANGED_WATER_TEMPS) {
         int16_t leaving = state->leaving_water_temp * 10;
         if (leaving != prev_leaving_water) {
-            ESP_LOGD(TAG, "Leaving water temp: %d (%.1f°C)", leaving, leaving / 100.0);
+            ESP_LOGD(TAG, "Leaving water temp: %d (" P1P2_FMT_X100 "°C)", leaving, P1P2_X100(leaving));
 #ifdef P1P2_MATTER_SDK_AVAILABLE
             p1p2_matter_bridge_update_i16(EP_TEMP_LEAVING, CLUSTER_TEMP_MEASUREMENT,
                                            ATTR_MEASURED_VALUE, leaving);
@@ -68,7 +69,7 @@ void p1p2_matter_sensors_update(const p1p2_hvac_state_t *state)
 
         int16_t ret_water = state->return_water_temp * 10;
         if (ret_water != prev_return_water) {
-            ESP_LOGD(TAG, "Return water temp: %d (%.1f°C)", ret_water, ret_water / 100.0);
+            ESP_LOGD(TAG, "Return water temp: %d (" P1P2_FMT_X100 "°C)", ret_water, P1P2_X100(ret_water));
 #ifdef P1P2_MATTER_SDK_AVAILABLE
             p1p2_matter_bridge_update_i16(EP_TEMP_RETURN, CLUSTER_TEMP_MEASUREMENT,
                                            ATTR_MEASURED_VALUE, ret_water);
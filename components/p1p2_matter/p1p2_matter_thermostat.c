@@ -12,6 +12,7 @@
 #include "p1p2_matter.h"
 #include "p1p2_matter_clusters.h"
 #include "p1p2_protocol.h"
+#include "p1p2_fixed.h"
 
 #ifdef P1P2_MATTER_SDK_AVAILABLE
 #include "p1p2_matter_bridge.h"
@@ -70,7 +71,7 @@ void p1p2_matter_thermostat_update(const p1p2_hvac_state_t *state)
     uint16_t running = running_to_matter(state->running);
 
     if (local_temp != prev_local_temp) {
-        ESP_LOGD(TAG, "LocalTemperature: %d (%.1f°C)", local_temp, local_temp / 100.0);
+        ESP_LOGD(TAG, "LocalTemperature: %d (" P1P2_FMT_X100 "°C)", local_temp, P1P2_X100(local_temp));
 #ifdef P1P2_MATTER_SDK_AVAILABLE
         p1p2_matter_bridge_update_i16(EP_THERMOSTAT, CLUSTER_THERMOSTAT,
                                        ATTR_LOCAL_TEMPERATURE, local_temp);
@@ -79,7 +80,7 @@ void p1p2_matter_thermostat_update(const p1p2_hvac_state_t *state)
     }
 
     if (cool_sp != prev_cool_sp) {
-        ESP_LOGD(TAG, "OccupiedCoolingSetpoint: %d (%.1f°C)", cool_sp, cool_sp / 100.0);
+        ESP_LOGD(TAG, "OccupiedCoolingSetpoint: %d (" P1P2_FMT_X100 "°C)", cool_sp, P1P2_X100(cool_sp));
 #ifdef P1P2_MATTER_SDK_AVAILABLE
         p1p2_matter_bridge_update_i16(EP_THERMOSTAT, CLUSTER_THERMOSTAT,
                                        ATTR_OCCUPIED_COOLING_SETPOINT, cool_sp);
@@ -88,7 +89,7 @@ void p1p2_matter_thermostat_update(const p1p2_hvac_state_t *state)
     }
 
     if (heat_sp != prev_heat_sp) {
-        ESP_LOGD(TAG, "OccupiedHeatingSetpoint: %d (%.1f°C)", heat_sp, heat_sp / 100.0);
+        ESP_LOGD(TAG, "OccupiedHeatingSetpoint: %d (" P1P2_FMT_X100 "°C)", heat_sp, P1P2_X100(heat_sp));
 #ifdef P1P2_MATTER_SDK_AVAILABLE
         p1p2_matter_bridge_update_i16(EP_THERMOSTAT, CLUSTER_THERMOSTAT,
                                        ATTR_OCCUPIED_HEATING_SETPOINT, heat_sp);
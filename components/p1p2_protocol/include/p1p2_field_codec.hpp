@@ -0,0 +1,139 @@
+/*
+ * P1P2 Field Codec — Compile-time packet field layouts (C++17, header-only)
+ *
+ * Each field is a type: Field<T, Offset, Len, Endian, Scale> knows where it
+ * lives in a payload and how to convert it, so get()/put() compile down to
+ * a few loads/stores and shifts with no table interpretation. A Layout lists
+ * the fields of one packet and its size; a field outside the layout fails
+ * to compile. ResponseMap builds a response payload from a request payload
+ * through Copy/Set rules, with a single runtime length check per packet
+ * against the size the rules actually need.
+ *
+ * Offsets are payload offsets (byte 0 = first byte after src/dst/type).
+ *
+ * ESP32-C6 port: 2026
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+namespace p1p2 {
+
+enum class Endian { Big, Little };
+
+/*
+ * A 1, 2 or 4 byte integer field. get() returns the raw value (sign-extended
+ * when T is signed) multiplied by Scale; put() stores value / Scale.
+ */
+template <typename T, uint8_t Offset, uint8_t Len, Endian E = Endian::Big, int Scale = 1>
+struct Field {
+    static_assert(std::is_integral<T>::value, "field type must be integral");
+    static_assert(Len == 1 || Len == 2 || Len == 4, "field length must be 1, 2 or 4");
+    static_assert(Scale != 0, "field scale must be non-zero");
+
+    static constexpr uint8_t offset = Offset;
+    static constexpr uint8_t length = Len;
+    static constexpr uint8_t end = Offset + Len;
+
+    static uint32_t get_raw(const uint8_t *p)
+    {
+        uint32_t raw = 0;
+        for (uint8_t i = 0; i < Len; i++) {
+            if (E == Endian::Big) raw = (raw << 8) | p[Offset + i];
+            else raw |= (uint32_t)p[Offset + i] << (8 * i);
+        }
+        return raw;
+    }
+
+    static void put_raw(uint8_t *p, uint32_t raw)
+    {
+        for (uint8_t i = 0; i < Len; i++) {
+            uint8_t shift = (E == Endian::Big) ? 8 * (Len - 1 - i) : 8 * i;
+            p[Offset + i] = (uint8_t)(raw >> shift);
+        }
+    }
+
+    static T get(const uint8_t *p)
+    {
+        uint32_t raw = get_raw(p);
+        if (std::is_signed<T>::value && Len < 4) {
+            constexpr int pad = 32 - 8 * Len;
+            return (T)(((int32_t)(raw << pad) >> pad) * Scale);
+        }
+        return (T)(raw * Scale);
+    }
+
+    static void put(uint8_t *p, T value)
+    {
+        put_raw(p, (uint32_t)(value / Scale));
+    }
+};
+
+/* Single raw byte — the common case for F-series status/control bytes */
+template <uint8_t Offset>
+using Byte = Field<uint8_t, Offset, 1>;
+
+/*
+ * The fixed-size payload of one packet. Size is the number of payload bytes
+ * the fields require; every listed field must fit.
+ */
+template <uint8_t Size, typename... Fields>
+struct Layout {
+    static constexpr uint8_t size = Size;
+    static_assert(((Fields::end <= Size) && ...), "field outside packet layout");
+
+    template <typename F>
+    static constexpr bool fits() { return F::end <= Size; }
+};
+
+/* Response rule: Dst = (Src & And) | Or */
+template <typename Dst, typename Src, uint8_t And = 0xFF, uint8_t Or = 0x00>
+struct Copy {
+    static constexpr uint8_t dst_end = Dst::end;
+    static constexpr uint8_t src_end = Src::end;
+
+    static void apply(const uint8_t *req, uint8_t *rsp)
+    {
+        Dst::put_raw(rsp, (Src::get_raw(req) & And) | Or);
+    }
+};
+
+/* Response rule: Dst = constant (bytes not covered by any rule are 0) */
+template <typename Dst, uint32_t Value>
+struct Set {
+    static constexpr uint8_t dst_end = Dst::end;
+    static constexpr uint8_t src_end = 0;
+
+    static void apply(const uint8_t *, uint8_t *rsp)
+    {
+        Dst::put_raw(rsp, Value);
+    }
+};
+
+/*
+ * Request-to-response mapping. req_size is derived from the rules: the
+ * shortest request payload every Copy rule can read. Rsp is the response
+ * Layout; all rule destinations must lie inside it.
+ */
+template <typename Rsp, typename... Rules>
+struct ResponseMap {
+    static constexpr uint8_t req_size = [] {
+        uint8_t n = 0;
+        ((n = Rules::src_end > n ? Rules::src_end : n), ...);
+        return n;
+    }();
+    static constexpr uint8_t rsp_size = Rsp::size;
+    static_assert(((Rules::dst_end <= Rsp::size) && ...), "response rule outside layout");
+
+    /* Caller guarantees req has req_size bytes and rsp has rsp_size bytes */
+    static void encode(const uint8_t *req, uint8_t *rsp)
+    {
+        memset(rsp, 0, Rsp::size);
+        (Rules::apply(req, rsp), ...);
+    }
+};
+
+} // namespace p1p2
@@ -0,0 +1,60 @@
+/*
+ * P1P2 Fixed Point — Integer scaling and formatting helpers
+ *
+ * The ESP32-C6 has no FPU: every float operation is a soft-float library
+ * call. Values are kept as scaled integers throughout (temperatures × 10,
+ * Matter temperatures × 100, flow L/min × 10, bus voltage in mV), scaled
+ * by integer ratios and printed with integer-only format helpers:
+ *
+ *   printf("Room: " P1P2_FMT_X10 " C\n", P1P2_X10(state.room_temp));
+ *
+ * The argument macros evaluate their value more than once; pass a plain
+ * variable, not an expression with side effects. p1p2_fmt_x10() formats
+ * into a buffer, for padded table columns.
+ *
+ * ESP32-C6 port: 2026
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * v * num / den, rounded half away from zero. den must be non-zero.
+ */
+static inline int64_t p1p2_scale_round(int64_t v, int32_t num, uint32_t den)
+{
+    int64_t n = v * num;
+    if (den == 1) return n;
+    return (n >= 0) ? (n + den / 2) / (int64_t)den : -((-n + den / 2) / (int64_t)den);
+}
+
+/* Value × 10 as "-12.3" */
+#define P1P2_FMT_X10        "%s%d.%d"
+#define P1P2_X10(v) \
+    ((v) < 0 ? "-" : ""), (int)(((v) < 0 ? -(int32_t)(v) : (int32_t)(v)) / 10), \
+    (int)(((v) < 0 ? -(int32_t)(v) : (int32_t)(v)) % 10)
+
+/* Value × 100 as "-12.34" */
+#define P1P2_FMT_X100       "%s%d.%02d"
+#define P1P2_X100(v) \
+    ((v) < 0 ? "-" : ""), (int)(((v) < 0 ? -(int32_t)(v) : (int32_t)(v)) / 100), \
+    (int)(((v) < 0 ? -(int32_t)(v) : (int32_t)(v)) % 100)
+
+/* Buffer for p1p2_fmt_x10(): "-3276.8" */
+#define P1P2_FMT_X10_LEN    8
+
+static inline const char *p1p2_fmt_x10(char *buf, int16_t v)
+{
+    snprintf(buf, P1P2_FMT_X10_LEN, P1P2_FMT_X10, P1P2_X10(v));
+    return buf;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -24,6 +24,7 @@ extern "C" {
 #endif
 
 /* F-series model IDs */
+#define F_MODEL_AUTO  0    /* detect from bus traffic */
 #define F_MODEL_BCL   10   /* FDY/FBQ — models A, B, C, L, LA */
 #define F_MODEL_P     11   /* FXMQ — models P, PA */
 #define F_MODEL_M     12   /* FDYQ — model M */
@@ -67,6 +68,10 @@ extern "C" {
 
 #define PKT_TYPE_COUNTER_A3     0xA3  /* Counter request/response */
 
+/* 0xA3 counter request (00 00 A3 00) and the shortest reply (8-byte payload) */
+#define F_COUNTER_REQ_LEN       4
+#define F_COUNTER_RSP_MIN_LEN   11
+
 /*
  * Control packet (0x38/0x3B) payload byte offsets.
  * These are relative to payload start (byte 3 of packet).
@@ -1,9 +1,11 @@
 /*
- * P1P2 Parameter Tables — Packet field definitions for F-series decode
+ * P1P2 Parameter Tables — Packet field definitions for F- and E-series decode
  *
  * These tables define the byte offset, length, and meaning of each
- * field within F-series P1/P2 packets. They replace the large switch
- * statements in P1P2_ParameterConversion.h with data-driven lookup.
+ * field within F-series (VRV/Sky Air) and E-series (Altherma) P1/P2
+ * packets. They replace the large switch statements in
+ * P1P2_ParameterConversion.h with data-driven lookup. One family's tables
+ * are selected at init (p1p2_decode_select_family).
  *
  * Original: Copyright (c) 2019-2024 Arnold Niessen — CC BY-NC-ND 4.0
  * ESP32-C6 port: 2026
@@ -13,6 +15,8 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include "p1p2_protocol.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -33,6 +37,7 @@ typedef enum {
     PARAM_TYPE_TEMP16,    /* 16-bit temperature (°C × 10, signed) */
     PARAM_TYPE_FAN,       /* fan speed encoded value */
     PARAM_TYPE_MODE,      /* operating mode encoded value */
+    PARAM_TYPE_F88,       /* E-series f8.8: signed 8.8 fixed point, big-endian, °C */
 } p1p2_param_type_t;
 
 /*
@@ -47,8 +52,22 @@ typedef enum {
     PARAM_CAT_SETTING,
 } p1p2_param_cat_t;
 
+/*
+ * Parameter flags
+ */
+#define PARAM_F_ALT           0x01  /* fallback for the previous entry: used only
+                                       when that entry did not fit the payload */
+#define PARAM_F_AUX_SRC       0x02  /* E-series: field of the packet sent from the
+                                       auxiliary address (the heat pump's reply),
+                                       which has its own layout */
+
 /*
  * A single parameter field definition.
+ *
+ * state_offset/state_size bind the field to a member of p1p2_hvac_state_t
+ * (use PARAM_STATE(member)); the decoder stores the converted value there
+ * and sets changed_bit in state->changed when it differs. Fields with
+ * state_size 0 (PARAM_NO_STATE) are described but not stored.
  */
 typedef struct {
     uint8_t          packet_type;   /* P1/P2 packet type (0x10, 0x38, etc.) */
@@ -57,43 +76,190 @@ typedef struct {
     p1p2_param_type_t value_type;
     p1p2_param_cat_t  category;
     const char       *name;         /* human-readable name */
-    float             scale;        /* multiply raw value by this to get real value */
-    float             offset;       /* add this after scaling */
+    int16_t           scale_num;    /* real value = raw * scale_num / scale_den + offset, */
+    uint16_t          scale_den;    /* rounded half away from zero (PARAM_SCALE) */
+    int32_t           offset;       /* in the state member's units */
+    uint8_t           bit_mask;     /* PARAM_TYPE_FLAG8: bit(s) to test */
+    uint8_t           flags;        /* PARAM_F_* */
+    uint16_t          state_offset; /* offsetof(p1p2_hvac_state_t, member) */
+    uint8_t           state_size;   /* sizeof member: 1, 2 or 4; 0 = not stored */
+    uint32_t          changed_bit;  /* CHANGED_* bit set when the value changes */
 } p1p2_param_def_t;
 
+/* Integer scale ratio, resolved at compile time; the decoder skips 1/1 */
+#define PARAM_SCALE(num, den) (num), (den)
+#define PARAM_X1              PARAM_SCALE(1, 1)
+
+#define PARAM_STATE(member) \
+    offsetof(p1p2_hvac_state_t, member), sizeof(((p1p2_hvac_state_t *)0)->member)
+#define PARAM_NO_STATE      0, 0
+
+/*
+ * Per-packet-type decode rules, applied after the type's fields.
+ */
+#define PKT_DEF_DATA_VALID    0x01  /* packet carries a full status: set data_valid */
+#define PKT_DEF_RUNNING       0x02  /* derive running state from power and mode */
+#define PKT_DEF_AUX_SRC       0x04  /* E-series: rules for the reply (see PARAM_F_AUX_SRC) */
+
+typedef struct {
+    uint8_t packet_type;
+    uint8_t min_payload;            /* shorter payloads are not decoded */
+    uint8_t flags;                  /* PKT_DEF_* */
+} p1p2_packet_def_t;
+
+/*
+ * Status fields shared by 0x10 (indoor unit status) and the 0x38/0x3B
+ * control requests, which carry the same layout in their first 11 bytes.
+ */
+#define F_SERIES_STATUS_FIELDS(t) \
+    { t, 0, 1, PARAM_TYPE_FLAG8,  PARAM_CAT_THERMOSTAT, "power",            PARAM_X1, 0, 0x01, 0, PARAM_STATE(power),            CHANGED_POWER }, \
+    { t, 2, 1, PARAM_TYPE_MODE,   PARAM_CAT_THERMOSTAT, "operating_mode",   PARAM_X1, 0, 0,    0, PARAM_STATE(mode),             CHANGED_MODE }, \
+    { t, 4, 1, PARAM_TYPE_TEMP8,  PARAM_CAT_THERMOSTAT, "target_temp_cool", PARAM_X1, 0, 0,    0, PARAM_STATE(target_temp_cool), CHANGED_TEMP_COOL }, \
+    { t, 6, 1, PARAM_TYPE_FAN,    PARAM_CAT_FAN,        "fan_speed_cool",   PARAM_X1, 0, 0,    0, PARAM_STATE(fan_mode_cool),    CHANGED_FAN_COOL }, \
+    { t, 8, 1, PARAM_TYPE_TEMP8,  PARAM_CAT_THERMOSTAT, "target_temp_heat", PARAM_X1, 0, 0,    0, PARAM_STATE(target_temp_heat), CHANGED_TEMP_HEAT }, \
+    { t, 10, 1, PARAM_TYPE_FAN,   PARAM_CAT_FAN,        "fan_speed_heat",   PARAM_X1, 0, 0,    0, PARAM_STATE(fan_mode_heat),    CHANGED_FAN_HEAT }
+
 /*
  * F-series parameter table.
  * This is a subset of the most important fields; the full P1P2_ParameterConversion.h
  * has thousands of parameters across all models. We start with the ones needed
- * for Matter cluster attributes.
+ * for Matter cluster attributes. Entries need not be grouped by packet type:
+ * the decoder builds a per-type index at init. Entries of one type are
+ * decoded in table order, so a later entry for the same state member wins.
+ *
+ * Temperatures are stored × 10: TEMP8 converts whole °C, TEMP16 is already
+ * × 10 on the wire, and plain integer types use scale 10 where needed.
  */
 static const p1p2_param_def_t f_series_params[] = {
     /* ---- Packet 0x10: Main status ---- */
-    { 0x10, 0, 1, PARAM_TYPE_FLAG8,  PARAM_CAT_THERMOSTAT, "power",              1.0, 0 },
-    { 0x10, 2, 1, PARAM_TYPE_MODE,   PARAM_CAT_THERMOSTAT, "operating_mode",     1.0, 0 },
-    { 0x10, 4, 1, PARAM_TYPE_TEMP8,  PARAM_CAT_THERMOSTAT, "target_temp_cool",   1.0, 0 },
-    { 0x10, 6, 1, PARAM_TYPE_FAN,    PARAM_CAT_FAN,        "fan_speed_cool",     1.0, 0 },
-    { 0x10, 8, 1, PARAM_TYPE_TEMP8,  PARAM_CAT_THERMOSTAT, "target_temp_heat",   1.0, 0 },
-    { 0x10, 10, 1, PARAM_TYPE_FAN,   PARAM_CAT_FAN,        "fan_speed_heat",     1.0, 0 },
+    F_SERIES_STATUS_FIELDS(0x10),
 
     /* ---- Packet 0x11: Temperature readings ---- */
-    { 0x11, 0, 1, PARAM_TYPE_TEMP8,  PARAM_CAT_TEMP_SENSOR, "room_temp",         1.0, 0 },
-    { 0x11, 2, 1, PARAM_TYPE_S8,     PARAM_CAT_TEMP_SENSOR, "outdoor_temp",      1.0, 0 },
+    { 0x11, 0, 1, PARAM_TYPE_TEMP8,  PARAM_CAT_TEMP_SENSOR, "room_temp",         PARAM_X1, 0, 0, 0, PARAM_STATE(room_temp),    CHANGED_ROOM_TEMP },
+    { 0x11, 2, 1, PARAM_TYPE_S8,     PARAM_CAT_TEMP_SENSOR, "outdoor_temp",     PARAM_SCALE(10, 1), 0, 0, 0, PARAM_STATE(outdoor_temp), CHANGED_OUTDOOR_TEMP },
+
+    /* ---- Packet 0x13: Extended status — 16-bit error code, 8-bit on short packets ---- */
+    { 0x13, 1, 2, PARAM_TYPE_U16,    PARAM_CAT_DIAGNOSTIC,  "error_code",        PARAM_X1, 0, 0, 0,           PARAM_STATE(error_code), CHANGED_ERROR_CODE },
+    { 0x13, 0, 1, PARAM_TYPE_U8,     PARAM_CAT_DIAGNOSTIC,  "error_code",        PARAM_X1, 0, 0, PARAM_F_ALT, PARAM_STATE(error_code), CHANGED_ERROR_CODE },
 
     /* ---- Packet 0x14: Compressor/flow data ---- */
-    { 0x14, 0, 2, PARAM_TYPE_U16,    PARAM_CAT_DIAGNOSTIC,  "compressor_freq",   1.0, 0 },
-    { 0x14, 2, 2, PARAM_TYPE_U16,    PARAM_CAT_DIAGNOSTIC,  "flow_rate",         0.1, 0 },
+    { 0x14, 0, 2, PARAM_TYPE_U16,    PARAM_CAT_DIAGNOSTIC,  "compressor_freq",   PARAM_X1, 0, 0, 0, PARAM_STATE(compressor_freq), CHANGED_COMPRESSOR },
+    { 0x14, 2, 2, PARAM_TYPE_U16,    PARAM_CAT_DIAGNOSTIC,  "flow_rate",         PARAM_X1, 0, 0, 0, PARAM_STATE(flow_rate),       CHANGED_FLOW_RATE },  /* L/min × 10 */
+
+    /* ---- Packet 0x15: DHW and water temperatures ---- */
+    { 0x15, 0, 1, PARAM_TYPE_FLAG8,  PARAM_CAT_THERMOSTAT,  "dhw_active",        PARAM_X1, 0, 0x01, 0, PARAM_STATE(dhw_active),         CHANGED_DHW },
+    { 0x15, 1, 1, PARAM_TYPE_TEMP8,  PARAM_CAT_THERMOSTAT,  "dhw_target",        PARAM_X1, 0, 0,    0, PARAM_STATE(dhw_target),         CHANGED_DHW },
+    { 0x15, 2, 1, PARAM_TYPE_TEMP8,  PARAM_CAT_TEMP_SENSOR, "dhw_temp",          PARAM_X1, 0, 0,    0, PARAM_STATE(dhw_temp),           CHANGED_DHW },
+    { 0x15, 3, 2, PARAM_TYPE_TEMP16, PARAM_CAT_TEMP_SENSOR, "leaving_water_temp", PARAM_X1, 0, 0,    0, PARAM_STATE(leaving_water_temp), CHANGED_WATER_TEMPS },
+    { 0x15, 5, 2, PARAM_TYPE_TEMP16, PARAM_CAT_TEMP_SENSOR, "return_water_temp", PARAM_X1, 0, 0,    0, PARAM_STATE(return_water_temp),  CHANGED_WATER_TEMPS },
+
+    /* ---- Packet 0x16: Additional status ---- */
+    { 0x16, 0, 2, PARAM_TYPE_U16,    PARAM_CAT_DIAGNOSTIC,  "error_code",        PARAM_X1, 0, 0, 0, PARAM_STATE(error_code), CHANGED_ERROR_CODE },
+
+    /* ---- Packet 0x38: Control request (models BCL, P) ---- */
+    F_SERIES_STATUS_FIELDS(0x38),
+
+    /* ---- Packet 0x3B: Control request (model M), with zones ---- */
+    F_SERIES_STATUS_FIELDS(0x3B),
+    { 0x3B, 17, 1, PARAM_TYPE_U8,    PARAM_CAT_SETTING,     "active_zones",      PARAM_X1, 0, 0, 0, PARAM_STATE(active_zones), CHANGED_ZONES },
 
     /* ---- Packet 0xA3: Counter data ---- */
-    { 0xA3, 0, 4, PARAM_TYPE_U32,    PARAM_CAT_COUNTER,     "operation_hours",   1.0, 0 },
-    { 0xA3, 4, 4, PARAM_TYPE_U32,    PARAM_CAT_COUNTER,     "compressor_starts", 1.0, 0 },
+    { 0xA3, 0, 4, PARAM_TYPE_U32,    PARAM_CAT_COUNTER,     "operation_hours",   PARAM_X1, 0, 0, 0, PARAM_STATE(operation_hours),   CHANGED_OP_HOURS },
+    { 0xA3, 4, 4, PARAM_TYPE_U32,    PARAM_CAT_COUNTER,     "compressor_starts", PARAM_X1, 0, 0, 0, PARAM_STATE(compressor_starts), CHANGED_COMP_STARTS },
 
     /* Sentinel */
-    { 0, 0, 0, 0, 0, NULL, 0, 0 },
+    { 0, 0, 0, 0, 0, NULL, 0, 0, 0, 0, 0, PARAM_NO_STATE, 0 },
 };
 
 #define F_SERIES_PARAM_COUNT  (sizeof(f_series_params) / sizeof(f_series_params[0]) - 1)
 
+/*
+ * F-series packet types with decode rules. Types listed here but without
+ * parameters (0x12, read by the bus clock) are known and skipped silently.
+ */
+static const p1p2_packet_def_t f_series_packets[] = {
+    { 0x10, 0, PKT_DEF_DATA_VALID | PKT_DEF_RUNNING },
+    { 0x12, 0, 0 },
+    { 0x38, 0, PKT_DEF_DATA_VALID },
+    { 0x3B, 0, PKT_DEF_DATA_VALID },
+    { 0xA3, 8, 0 },                 /* shorter A3 packets are requests */
+};
+
+#define F_SERIES_PACKET_COUNT (sizeof(f_series_packets) / sizeof(f_series_packets[0]))
+
+/*
+ * E-series (Altherma) parameter table.
+ *
+ * Every E-series packet type is sent twice per cycle: a request from the
+ * main controller (00 00 tt) and a reply from the heat pump (40 00 tt),
+ * with different layouts. Reply fields carry PARAM_F_AUX_SRC; the decoder
+ * indexes the two directions separately. Temperatures are f8.8 (°C with
+ * 1/256 resolution), stored × 10 like F-series.
+ *
+ * As for F-series, a subset of P1P2_ParameterConversion.h: the fields
+ * behind the state members, plus some diagnostics readable through
+ * p1p2_protocol_get_param(). Types with no fields here are known and
+ * skipped.
+ */
+#define E_AUX PARAM_F_AUX_SRC
+
+static const p1p2_param_def_t e_series_params[] = {
+    /* ---- 0x10 reply: operation status ---- */
+    { 0x10, 0, 1, PARAM_TYPE_FLAG8,  PARAM_CAT_THERMOSTAT,  "heating_cooling",    PARAM_X1, 0, 0x01, E_AUX, PARAM_STATE(power),      CHANGED_POWER },
+    { 0x10, 2, 1, PARAM_TYPE_FLAG8,  PARAM_CAT_THERMOSTAT,  "dhw_power",          PARAM_X1, 0, 0x02, E_AUX, PARAM_STATE(dhw_active), CHANGED_DHW },
+
+    /* ---- 0x11 request: temperature measured by the main controller ---- */
+    { 0x11, 0, 2, PARAM_TYPE_F88,    PARAM_CAT_TEMP_SENSOR, "room_temp_controller", PARAM_X1, 0, 0, 0,   PARAM_NO_STATE, 0 },
+
+    /* ---- 0x11 reply: temperatures (the low-res outside temperature only for replies too short for outside_temp) ---- */
+    { 0x11, 0, 2, PARAM_TYPE_F88,    PARAM_CAT_TEMP_SENSOR, "leaving_water_temp", PARAM_X1, 0, 0, E_AUX, PARAM_STATE(leaving_water_temp), CHANGED_WATER_TEMPS },
+    { 0x11, 2, 2, PARAM_TYPE_F88,    PARAM_CAT_TEMP_SENSOR, "dhw_temp",           PARAM_X1, 0, 0, E_AUX, PARAM_STATE(dhw_temp),           CHANGED_DHW },
+    { 0x11, 6, 2, PARAM_TYPE_F88,    PARAM_CAT_TEMP_SENSOR, "return_water_temp",  PARAM_X1, 0, 0, E_AUX, PARAM_STATE(return_water_temp),  CHANGED_WATER_TEMPS },
+    { 0x11, 8, 2, PARAM_TYPE_F88,    PARAM_CAT_TEMP_SENSOR, "mid_water_temp",     PARAM_X1, 0, 0, E_AUX, PARAM_NO_STATE, 0 },
+    { 0x11, 10, 2, PARAM_TYPE_F88,   PARAM_CAT_TEMP_SENSOR, "refrigerant_temp",   PARAM_X1, 0, 0, E_AUX, PARAM_NO_STATE, 0 },
+    { 0x11, 12, 2, PARAM_TYPE_F88,   PARAM_CAT_TEMP_SENSOR, "room_temp",          PARAM_X1, 0, 0, E_AUX, PARAM_STATE(room_temp),          CHANGED_ROOM_TEMP },
+    { 0x11, 14, 2, PARAM_TYPE_F88,   PARAM_CAT_TEMP_SENSOR, "outside_temp",       PARAM_X1, 0, 0, E_AUX, PARAM_STATE(outdoor_temp),       CHANGED_OUTDOOR_TEMP },
+    { 0x11, 4, 2, PARAM_TYPE_F88,    PARAM_CAT_TEMP_SENSOR, "outside_temp_lowres", PARAM_X1, 0, 0, PARAM_F_ALT | E_AUX, PARAM_STATE(outdoor_temp), CHANGED_OUTDOOR_TEMP },
+
+    /* ---- 0x13 reply: water flow ---- */
+    { 0x13, 9, 2, PARAM_TYPE_U16,    PARAM_CAT_DIAGNOSTIC,  "flow_rate",          PARAM_X1, 0, 0, E_AUX, PARAM_STATE(flow_rate), CHANGED_FLOW_RATE },  /* L/min × 10 */
+
+    /* ---- 0x14 request: leaving water targets ---- */
+    { 0x14, 0, 2, PARAM_TYPE_F88,    PARAM_CAT_SETTING,     "lwt_target_heat",    PARAM_X1, 0, 0, 0,     PARAM_NO_STATE, 0 },
+    { 0x14, 2, 2, PARAM_TYPE_F88,    PARAM_CAT_SETTING,     "lwt_target_cool",    PARAM_X1, 0, 0, 0,     PARAM_NO_STATE, 0 },
+
+    /* Sentinel */
+    { 0, 0, 0, 0, 0, NULL, 0, 0, 0, 0, 0, PARAM_NO_STATE, 0 },
+};
+
+#undef E_AUX
+
+#define E_SERIES_PARAM_COUNT  (sizeof(e_series_params) / sizeof(e_series_params[0]) - 1)
+
+static const p1p2_packet_def_t e_series_packets[] = {
+    { 0x10, 0, PKT_DEF_DATA_VALID | PKT_DEF_AUX_SRC },
+    { 0x10, 0, 0 },
+    { 0x12, 0, 0 },                 /* date/time */
+    { 0x12, 0, PKT_DEF_AUX_SRC },
+    { 0x13, 0, 0 },
+    { 0x14, 0, PKT_DEF_AUX_SRC },
+    { 0x15, 0, 0 },
+    { 0x15, 0, PKT_DEF_AUX_SRC },
+    { 0x16, 0, 0 },
+    { 0x16, 0, PKT_DEF_AUX_SRC },
+    { 0xB8, 0, 0 },                 /* counters, selected by payload byte 0 */
+    { 0xB8, 0, PKT_DEF_AUX_SRC },
+};
+
+#define E_SERIES_PACKET_COUNT (sizeof(e_series_packets) / sizeof(e_series_packets[0]))
+
+/* Parameter ids run up to the larger of the two tables */
+#define P1P2_PARAM_MAX \
+    (F_SERIES_PARAM_COUNT > E_SERIES_PARAM_COUNT ? F_SERIES_PARAM_COUNT : E_SERIES_PARAM_COUNT)
+
+/* Index key of a packet type and direction: type, + 256 for auxiliary replies */
+#define P1P2_PACKET_KEYS      512
+
 #ifdef __cplusplus
 }
 #endif
@@ -12,9 +12,11 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "esp_err.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/queue.h"
 #include "p1p2_bus_types.h"
+#include "p1p2_hist.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -115,8 +117,8 @@ typedef struct {
     uint8_t  active_zones;         /* bitmask of active zones */
 
     /* Bus diagnostics */
-    float    bus_voltage_p1;
-    float    bus_voltage_p2;
+    uint16_t bus_voltage_p1;       /* mV */
+    uint16_t bus_voltage_p2;       /* mV */
 
     /* Timestamps (for change detection) */
     int64_t  last_update_us;       /* esp_timer_get_time() of last decode */
@@ -144,6 +146,17 @@ typedef struct {
     int32_t         value;
 } p1p2_control_cmd_t;
 
+/* Depth of the Matter/CLI command queue */
+#define P1P2_CMD_QUEUE_SIZE      16
+
+/* Protocol families (decode tables selected at init from Kconfig) */
+#define P1P2_FAMILY_F            0  /* VRV / Sky Air */
+#define P1P2_FAMILY_E            1  /* Altherma */
+
+/* Units tracked besides the primary unit (power of 2), and silence before one is dropped */
+#define P1P2_MAX_UNITS           8
+#define P1P2_UNIT_TIMEOUT_MS     120000
+
 /* Control level */
 #define P1P2_CONTROL_OFF         0  /* No control, read-only */
 #define P1P2_CONTROL_AUX         1  /* Auxiliary controller active */
@@ -157,17 +170,48 @@ typedef struct {
 esp_err_t p1p2_protocol_init(QueueHandle_t rx_queue, QueueHandle_t tx_queue);
 
 /*
- * Get pointer to the current HVAC state (read-only from other tasks).
- * The protocol task updates this structure; other tasks may read it.
- * For thread safety, reading is done via copy or with the protocol mutex.
+ * F-series model in use (F_MODEL_*), or F_MODEL_AUTO (0) while it is
+ * still being detected from bus traffic.
+ */
+int p1p2_protocol_get_model(void);
+
+/*
+ * Consistent snapshot of the HVAC state without consuming change bits
+ * (out->changed is 0). Lock-free: retries if the protocol task publishes
+ * during the copy, never blocks it.
  */
-const p1p2_hvac_state_t *p1p2_protocol_get_state(void);
+void p1p2_protocol_read_state(p1p2_hvac_state_t *out);
 
 /*
- * Copy current HVAC state (thread-safe snapshot).
+ * Snapshot of the HVAC state with the changed bits accumulated since the
+ * previous call (which this call consumes). Lock-free like read_state.
+ * The bits are shared by all callers; a consumer that needs its own view
+ * of changes should use a change cursor instead.
  */
 void p1p2_protocol_get_state_copy(p1p2_hvac_state_t *out);
 
+/*
+ * Per-consumer change cursor: each consumer keeps one and sees the fields
+ * changed since its own previous read, without affecting anyone else.
+ * Copying a cursor is allowed (e.g. to only advance after a successful push).
+ */
+typedef struct {
+    uint32_t gen;               /* state generation last seen */
+} p1p2_change_cursor_t;
+
+/*
+ * Initialize a cursor. With from_now false, the first read reports every
+ * field that has ever been set; with true, only later changes.
+ */
+void p1p2_protocol_cursor_init(p1p2_change_cursor_t *cursor, bool from_now);
+
+/*
+ * Consistent snapshot of the HVAC state with out->changed set to the
+ * CHANGED_* bits of fields changed since the cursor's previous read, and
+ * advance the cursor. Returns the same bits. Lock-free.
+ */
+uint32_t p1p2_protocol_read_changes(p1p2_change_cursor_t *cursor, p1p2_hvac_state_t *out);
+
 /*
  * Get the command queue handle for sending control commands to protocol task.
  */
@@ -178,6 +222,284 @@ QueueHandle_t p1p2_protocol_get_cmd_queue(void);
  */
 esp_err_t p1p2_protocol_send_cmd(p1p2_cmd_type_t type, int32_t value);
 
+/*
+ * Overflow policy of the command queue (default: block up to 100 ms, then
+ * drop the new command). P1P2_QUEUE_DROP_OLDEST keeps the latest commands
+ * when senders outpace the protocol task; block_ms is only used with
+ * P1P2_QUEUE_BLOCK.
+ */
+void p1p2_protocol_set_cmd_queue_policy(p1p2_queue_policy_t policy, uint16_t block_ms);
+
+/*
+ * Command queue peak occupancy and number of commands dropped on a full
+ * queue (new or, with drop oldest, evicted). reset clears both afterwards.
+ */
+void p1p2_protocol_get_cmd_queue_stats(uint8_t *hwm, uint32_t *dropped, bool reset);
+
+/*
+ * Packets decoded since init, and packets skipped because their payload
+ * was identical to the previous one from the same source, destination and type.
+ */
+void p1p2_protocol_get_decode_stats(uint32_t *skipped, uint32_t *decoded);
+
+/*
+ * Units seen on the bus. Each packet is decoded into the state of its unit
+ * (the sender, or the destination of packets from the auxiliary controller
+ * address). The primary unit — the first one heard — is the state returned
+ * by read_state() and friends.
+ */
+typedef struct {
+    uint8_t  addr;
+    bool     primary;
+    uint32_t packets;
+    uint32_t age_ms;            /* since last packet */
+} p1p2_unit_info_t;
+
+/*
+ * List up to max units, primary first. Returns the number listed.
+ */
+int p1p2_protocol_get_units(p1p2_unit_info_t *out, int max);
+
+/*
+ * Consistent snapshot of one unit's state (out->changed is 0).
+ * Returns ESP_ERR_NOT_FOUND if no unit has that address.
+ */
+esp_err_t p1p2_protocol_get_unit_state(uint8_t addr, p1p2_hvac_state_t *out);
+
+/*
+ * Packets not decoded because the unit table was full.
+ */
+uint32_t p1p2_protocol_get_units_dropped(void);
+
+/*
+ * Request/response pairing: per request stream (src, dst, type), the
+ * response latency from request end to response start, and requests that
+ * got no response. The first stream seen anchors the bus cycle period.
+ */
+#define P1P2_PAIR_MAX_ENTRIES    32     /* power of 2 */
+#define P1P2_PAIR_MAX_PROBE      8
+
+typedef struct {
+    uint8_t  src;               /* requester */
+    uint8_t  dst;
+    uint8_t  type;
+    uint8_t  responder;         /* source of the last response */
+    uint32_t requests;
+    uint32_t answered;
+    uint32_t unanswered;
+    p1p2_hist_t latency_us;
+} p1p2_pair_stats_t;
+
+/*
+ * Copy the index-th request stream into *out. Returns false once index
+ * passes the last one.
+ */
+bool p1p2_protocol_get_pair_stats(int index, p1p2_pair_stats_t *out);
+
+/*
+ * Bus cycle period histogram (µs) and the anchor packet type. Returns the
+ * number of cycles measured.
+ */
+uint32_t p1p2_protocol_get_cycle_stats(p1p2_hist_t *period_us, uint8_t *anchor_type);
+
+/*
+ * Requests not tracked because the stream table was full.
+ */
+uint32_t p1p2_protocol_get_pair_overflow(void);
+
+/*
+ * Clear pairing and cycle statistics; the next request re-anchors the cycle.
+ */
+void p1p2_protocol_reset_pair_stats(void);
+
+/*
+ * Counter polling (auxiliary controller, F-series): 0xA3 requests every
+ * interval_s, the first one interval after start, held back while the bus
+ * load is at or above max_load and spaced further apart after missed
+ * replies, requests that found no idle window, read-back errors or new
+ * bus collisions.
+ */
+typedef struct {
+    uint32_t interval_s;        /* 0 = polling off */
+    uint16_t max_load;          /* bus load budget, 0.1 % units */
+    uint8_t  backoff;           /* retry spacing is 2^backoff bus cycles */
+    uint32_t requests;          /* queued for an idle window */
+    uint32_t replies;
+    uint32_t timeouts;          /* no reply within a few cycles */
+    uint32_t unsent;            /* found no idle window, dropped by the bus */
+    uint32_t readback_errors;   /* our request collided */
+    uint32_t collision_backoffs;/* held back after new bus collisions */
+    uint32_t deferred;          /* held back by the load budget or a full queue */
+    int64_t  last_reply_us;     /* esp_timer time of the last reply */
+} p1p2_counter_poll_stats_t;
+
+void p1p2_protocol_get_counter_poll_stats(p1p2_counter_poll_stats_t *out);
+
+/*
+ * Change the poll interval (0 = off) and load budget at runtime; once
+ * polling has started, the next request is due at once (after the one in
+ * flight, if any).
+ */
+void p1p2_protocol_set_counter_poll(uint32_t interval_s, uint16_t max_load);
+
+/*
+ * Bus clock: the main controller's date/time (packet 0x12) mapped onto
+ * esp_timer_get_time(), as controller local time in µs since 1970. Coarse
+ * (within 30 s) from the first packet, synced to within a bus cycle once
+ * the controller's minute has rolled over.
+ */
+typedef enum {
+    P1P2_CLOCK_NONE,            /* no 0x12 packet seen */
+    P1P2_CLOCK_COARSE,          /* minute known, seconds estimated */
+    P1P2_CLOCK_SYNCED,          /* anchored on a minute rollover */
+} p1p2_clock_sync_t;
+
+typedef struct {
+    p1p2_clock_sync_t sync;
+    uint8_t  day_of_week;       /* as sent, 0 = Monday */
+    uint32_t error_us;          /* bound on the mapping error */
+    int32_t  last_adjust_us;    /* correction at the last rollover (drift) */
+    int64_t  last_packet_us;    /* esp_timer time of the last 0x12 */
+    uint32_t packets;
+    uint32_t rollovers;         /* minute rollovers anchored */
+    uint32_t jumps;             /* controller clock set: mapping restarted */
+    uint32_t invalid;           /* packets with out-of-range fields */
+} p1p2_clock_info_t;
+
+/*
+ * Wall-clock time of an esp_timer_get_time() timestamp (e.g. a packet's
+ * start_us). Returns ESP_ERR_INVALID_STATE before the first 0x12 packet.
+ */
+esp_err_t p1p2_protocol_clock_to_unix(int64_t mono_us, int64_t *unix_us);
+
+/*
+ * Current wall-clock time, as p1p2_protocol_clock_to_unix(now).
+ */
+esp_err_t p1p2_protocol_clock_now(int64_t *unix_us);
+
+void p1p2_protocol_get_clock_info(p1p2_clock_info_t *out);
+
+/*
+ * Forget the mapping; the next 0x12 packet starts it again.
+ */
+void p1p2_protocol_reset_clock(void);
+
+/*
+ * Byte diff of packet types the decoder does not know (p1p2_byte_diff.c):
+ * per (src, dst, type), the last payload and per byte its changes and most
+ * frequent values, and a stream of change events. Bytes are payload
+ * offsets (data[3] is byte 0); times are esp_timer ms, 32 bits (wrap).
+ */
+#define P1P2_DIFF_TOP       4       /* values kept per byte */
+#define P1P2_DIFF_NEW_TYPE  0xFF    /* event offset: first packet, to = payload length */
+#define P1P2_DIFF_LENGTH    0xFE    /* event offset: payload length changed from -> to */
+
+typedef struct {
+    uint32_t time_ms;
+    uint8_t  src;
+    uint8_t  dst;
+    uint8_t  type;
+    uint8_t  offset;            /* payload byte, or P1P2_DIFF_NEW_TYPE / _LENGTH */
+    uint8_t  from;
+    uint8_t  to;
+    uint8_t  changes;           /* changes covered, >1 when folded by the holdoff */
+} p1p2_diff_event_t;
+
+typedef struct {
+    uint8_t  src;
+    uint8_t  dst;
+    uint8_t  type;
+    uint8_t  length;            /* payload length of the last packet */
+    uint32_t packets;
+    uint32_t changes;           /* byte changes, all bytes */
+    uint32_t first_ms;
+    uint32_t last_change_ms;    /* valid if changes */
+} p1p2_diff_type_info_t;
+
+typedef struct {
+    uint8_t  value;             /* in the last packet */
+    uint16_t changes;           /* saturates at 65535 */
+    uint32_t last_change_ms;    /* valid if changes */
+    uint8_t  top_value[P1P2_DIFF_TOP];
+    uint16_t top_count[P1P2_DIFF_TOP];  /* packets, most frequent first; 0 = unused */
+} p1p2_diff_byte_t;
+
+/*
+ * Sequence number of the next event: a cursor that starts reading from now.
+ */
+uint32_t p1p2_protocol_diff_seq(void);
+
+/*
+ * Read up to max events from *cursor on and advance it. Events overwritten
+ * before they were read are skipped and added to *lost (may be NULL).
+ * Returns the number read.
+ */
+int p1p2_protocol_diff_read(uint32_t *cursor, p1p2_diff_event_t *out, int max, uint32_t *lost);
+
+/*
+ * List up to max tracked types. Returns the number listed.
+ */
+int p1p2_protocol_diff_types(p1p2_diff_type_info_t *out, int max);
+
+/*
+ * Per-byte statistics of one type, up to max bytes; *length receives the
+ * payload length. Returns ESP_ERR_NOT_FOUND if the type is not tracked.
+ */
+esp_err_t p1p2_protocol_diff_bytes(uint8_t src, uint8_t dst, uint8_t type,
+                                   p1p2_diff_byte_t *out, int max, uint8_t *length);
+
+/*
+ * Packets of unknown types not tracked because the table was full.
+ */
+uint32_t p1p2_protocol_diff_untracked(void);
+
+/*
+ * Forget all tracked types and pending events; cursors skip to the next event.
+ */
+void p1p2_protocol_diff_reset(void);
+
+/*
+ * Read a bus parameter by id (index into the F-series parameter table).
+ * Values are kept as compact raw bits, extracted when their payload bytes
+ * change, and converted to final units on read. Covers parameters with no
+ * p1p2_hvac_state_t member. Returns ESP_ERR_INVALID_ARG for an unknown id,
+ * ESP_ERR_INVALID_STATE if the parameter has not been received yet and
+ * ESP_ERR_INVALID_SIZE if the last payload did not contain the field.
+ */
+esp_err_t p1p2_protocol_get_param(uint16_t id, int64_t *value);
+
+/*
+ * Current parameter generation; advances by one per parameter value change.
+ */
+uint32_t p1p2_protocol_get_param_generation(void);
+
+/*
+ * Ids of parameters whose value changed after generation `since`, each
+ * once. Writes up to max_ids ids and returns the total number changed
+ * (more than max_ids means some were left out). *gen_out receives the
+ * generation to pass next time. Costs time proportional to the number of
+ * changes while the change journal reaches back to `since`.
+ */
+int p1p2_protocol_params_changed_since(uint32_t since, uint16_t *ids, int max_ids,
+                                       uint32_t *gen_out);
+
+/*
+ * True if the parameter changed since it was last cleared; clear resets it.
+ * For a single consumer; use the generation API when there are several.
+ */
+bool p1p2_protocol_param_changed(uint16_t id, bool clear);
+
+/*
+ * Parameter name and packet type by id; NULL past the last parameter.
+ */
+const char *p1p2_protocol_get_param_name(uint16_t id, uint8_t *packet_type);
+
+/*
+ * Find a parameter id by name, optionally restricted to a packet type
+ * (0 = any). Returns -1 if not found.
+ */
+int p1p2_protocol_find_param(uint8_t packet_type, const char *name);
+
 /*
  * Set control level.
  */
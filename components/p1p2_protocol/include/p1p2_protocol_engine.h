@@ -0,0 +1,220 @@
+/*
+ * P1P2 Protocol Engine — Per-bus protocol context
+ *
+ * Everything one bus needs to turn received packets into HVAC state and
+ * auxiliary controller responses lives in a p1p2_protocol_t: the decoded
+ * state, the decode memo, the F-series control state (model, pending
+ * writes) and, for the firmware's engine, the published snapshot and the
+ * task queues. The firmware runs one engine, owned by the protocol task
+ * (p1p2_param_conversion.c); a multi-bus gateway or a host service can
+ * run several side by side, each driven by one thread at a time:
+ *
+ *   p1p2_decode_select_family(P1P2_FAMILY_F);   // once, before any engine runs
+ *   p1p2_engine_init(&eng, F_MODEL_BCL, P1P2_CONTROL_AUX, true);
+ *   ...
+ *   uint8_t n = p1p2_engine_process(&eng, &pkt, wb, sizeof(wb));
+ *   if (n) send wb[0..n) after P1P2_RESPONSE_DELAY_MS
+ *
+ * Shared by all engines and not part of the context: the decode tables
+ * (read-only once selected) and the device-wide services the protocol
+ * task feeds — unit map, payload store, pair statistics, bus clock and
+ * counter polling.
+ *
+ * ESP32-C6 port: 2026
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "p1p2_bus_config.h"
+#include "p1p2_bus_types.h"
+#include "p1p2_protocol.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Auxiliary controller responses go out this long after the request */
+#define P1P2_RESPONSE_DELAY_MS  25
+
+/*
+ * Decode memo (p1p2_decode_memo.c): last payload per (src, dst, type)
+ */
+#define P1P2_MEMO_SIZE          32          /* power of 2 */
+#define P1P2_MEMO_PAYLOAD_MAX   (P1P2_MAX_PACKET_SIZE - 4)
+
+typedef struct {
+    uint8_t  src;
+    uint8_t  dst;
+    uint8_t  type;
+    uint8_t  len;                    /* payload length */
+    bool     used;
+    uint32_t epoch;                  /* state epoch after this entry's last decode */
+    uint8_t  payload[P1P2_MEMO_PAYLOAD_MAX];
+} p1p2_memo_entry_t;
+
+typedef struct {
+    p1p2_memo_entry_t entries[P1P2_MEMO_SIZE];
+    uint32_t epoch;
+    uint32_t skipped;
+    uint32_t decoded;
+} p1p2_decode_memo_t;
+
+/*
+ * F-series control (p1p2_fseries_control.c): model and pending writes
+ */
+#define P1P2_MAX_PENDING_WRITES 8
+
+typedef struct {
+    uint8_t  packet_type;    /* which packet type this write targets */
+    uint8_t  payload_offset; /* byte offset within response payload */
+    uint8_t  value;          /* value to write */
+    uint8_t  mask;           /* mask for preserving existing bits (0x00 = replace all) */
+    uint8_t  count;          /* remaining write attempts (0 = inactive) */
+} p1p2_pending_write_t;
+
+typedef struct {
+    int      model_id;
+    p1p2_pending_write_t pending_writes[P1P2_MAX_PENDING_WRITES];
+
+    /* Model detection (p1p2_fseries_model_observe) */
+    bool     model_detecting;
+    bool     model_seen_3a;
+    uint8_t  model_seen_38;
+
+    /*
+     * Writes carried by the last response per packet type, so a failed
+     * transmit confirmation can give the attempt back. seq[] guards against
+     * the slot having been reused by a new write in the meantime.
+     */
+    uint8_t  write_seq[P1P2_MAX_PENDING_WRITES];
+    struct {
+        uint8_t packet_type;    /* 0 = nothing in flight */
+        uint8_t slots;          /* bitmap of pending_writes[] applied */
+        uint8_t seq[P1P2_MAX_PENDING_WRITES];
+    } inflight;
+} p1p2_fseries_ctrl_t;
+
+/*
+ * Published state (firmware engine): see p1p2_engine_state_publish().
+ * One generation per CHANGED_* bit.
+ */
+#define P1P2_STATE_FIELDS       32
+
+typedef struct {
+    p1p2_hvac_state_t state;
+    uint32_t gen;
+    uint32_t field_gen[P1P2_STATE_FIELDS];
+} p1p2_state_pub_t;
+
+typedef struct p1p2_protocol {
+    /* Decode and control — used by the engine's thread only */
+    p1p2_hvac_state_t   state;              /* working copy packets decode into */
+    p1p2_decode_memo_t  memo;
+    p1p2_fseries_ctrl_t ctrl;
+    volatile uint8_t    control_level;      /* P1P2_CONTROL_* */
+    bool                control_supported;  /* responses implemented for this family */
+
+    /* Publishing to other tasks */
+    uint32_t            state_gen;
+    uint32_t            field_gen[P1P2_STATE_FIELDS];
+    p1p2_state_pub_t    published;
+    atomic_uint_fast32_t state_seq;
+    atomic_uint_fast32_t pending_changed;
+
+    /* Queues, NULL for engines not run by a protocol task */
+    QueueHandle_t       rx_queue;           /* from bus I/O */
+    QueueHandle_t       tx_queue;           /* to bus I/O */
+    QueueHandle_t       cmd_queue;          /* from Matter/CLI */
+    QueueHandle_t       confirm_queue;      /* echoed responses from bus I/O */
+    p1p2_queue_policy_t cmd_policy;         /* command queue overflow policy */
+    uint16_t            cmd_block_ms;
+    uint8_t             cmd_queue_hwm;
+    uint32_t            cmd_dropped;
+} p1p2_protocol_t;
+
+/*
+ * Engine (p1p2_protocol_engine.c)
+ */
+
+/* Clear the context. control_supported: the family has responses (F-series). */
+void p1p2_engine_init(p1p2_protocol_t *p, int model, uint8_t control_level,
+                      bool control_supported);
+
+/*
+ * Build the auxiliary controller response to a received packet into wb.
+ * Returns its length without CRC, 0 if none is due (not addressed to us,
+ * control level below AUX, or nothing to answer for the model).
+ */
+uint8_t p1p2_engine_response(p1p2_protocol_t *p, const p1p2_packet_t *pkt,
+                             uint8_t *wb, uint8_t wb_max);
+
+/*
+ * One received packet through the engine: decode into p->state through the
+ * memo, model detection, then the response as p1p2_engine_response().
+ * For engines without a unit map (every packet is the one unit's).
+ */
+uint8_t p1p2_engine_process(p1p2_protocol_t *p, const p1p2_packet_t *pkt,
+                            uint8_t *wb, uint8_t wb_max);
+
+/*
+ * Published state (p1p2_param_conversion.c)
+ */
+
+/*
+ * Copy p->state to p->published under the sequence lock, stamp the fields
+ * in p->state.changed with a new generation and clear them. Engine's
+ * thread only.
+ */
+void     p1p2_engine_state_publish(p1p2_protocol_t *p);
+
+/* Consistent snapshot of p->published, from any thread; retries, never blocks the writer */
+void     p1p2_engine_state_read(p1p2_protocol_t *p, p1p2_state_pub_t *out);
+
+/* p1p2_protocol_cursor_init() and p1p2_protocol_read_changes() on engine p */
+void     p1p2_engine_cursor_init(p1p2_protocol_t *p, p1p2_change_cursor_t *cursor, bool from_now);
+uint32_t p1p2_engine_read_changes(p1p2_protocol_t *p, p1p2_change_cursor_t *cursor,
+                                  p1p2_hvac_state_t *out);
+
+/*
+ * Decode memo (p1p2_decode_memo.c)
+ */
+void p1p2_decode_memo_reset(p1p2_decode_memo_t *m);
+void p1p2_decode_memo_invalidate(p1p2_decode_memo_t *m);
+void p1p2_decode_memo_packet(p1p2_decode_memo_t *m, const p1p2_packet_t *pkt,
+                             p1p2_hvac_state_t *state);
+
+/*
+ * F-series control (p1p2_fseries_control.c)
+ */
+void      p1p2_fseries_control_init(p1p2_fseries_ctrl_t *c, int model);
+void      p1p2_fseries_model_detect_start(p1p2_fseries_ctrl_t *c);
+int       p1p2_fseries_model_observe(p1p2_fseries_ctrl_t *c, const p1p2_packet_t *pkt);
+int       p1p2_fseries_control_get_model(const p1p2_fseries_ctrl_t *c);
+esp_err_t p1p2_fseries_queue_write(p1p2_fseries_ctrl_t *c, uint8_t packet_type,
+                                   uint8_t payload_offset, uint8_t value,
+                                   uint8_t mask, uint8_t count);
+esp_err_t p1p2_fseries_apply_command(p1p2_fseries_ctrl_t *c, const p1p2_control_cmd_t *cmd);
+void      p1p2_fseries_tx_confirmed(p1p2_fseries_ctrl_t *c, const p1p2_tx_confirm_t *conf);
+
+uint8_t p1p2_fseries_build_response_38(p1p2_fseries_ctrl_t *c, const uint8_t *rb,
+                                       uint8_t rb_len, uint8_t *wb, uint8_t wb_max);
+uint8_t p1p2_fseries_build_response_3b(p1p2_fseries_ctrl_t *c, const uint8_t *rb,
+                                       uint8_t rb_len, uint8_t *wb, uint8_t wb_max);
+uint8_t p1p2_fseries_build_response_39(p1p2_fseries_ctrl_t *c, const uint8_t *rb,
+                                       uint8_t rb_len, uint8_t *wb, uint8_t wb_max);
+uint8_t p1p2_fseries_build_response_3a(p1p2_fseries_ctrl_t *c, const uint8_t *rb,
+                                       uint8_t rb_len, uint8_t *wb, uint8_t wb_max);
+uint8_t p1p2_fseries_build_response_3c(p1p2_fseries_ctrl_t *c, const uint8_t *rb,
+                                       uint8_t rb_len, uint8_t *wb, uint8_t wb_max);
+uint8_t p1p2_fseries_build_response_empty(p1p2_fseries_ctrl_t *c, const uint8_t *rb,
+                                          uint8_t rb_len, uint8_t *wb, uint8_t wb_max);
+
+#ifdef __cplusplus
+}
+#endif
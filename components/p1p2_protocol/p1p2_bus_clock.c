@@ -0,0 +1,193 @@
+/*
+ * P1P2 Bus Clock — Controller date/time mapped onto the monotonic timer
+ *
+ * Every bus cycle the main controller sends its date and time (packet
+ * 0x12 from address 00, minute resolution):
+ *
+ *   payload[1]  day of week (0 = Monday)
+ *   payload[2]  hour
+ *   payload[3]  minute
+ *   payload[4]  year - 2000
+ *   payload[5]  month (1-12)
+ *   payload[6]  day of month
+ *
+ * The mapping is an offset from esp_timer_get_time() to the controller's
+ * clock, in µs since 1970 (the controller keeps local time and carries no
+ * time zone). The first packet gives a coarse offset, placed mid-minute
+ * (within 30 s). When the minute advances between two consecutive packets
+ * the minute boundary lies between them, and the offset is anchored there
+ * to within half their spacing (one bus cycle). Each later rollover
+ * re-anchors it, which follows drift between our crystal and the
+ * controller's. A time more than a minute away from the mapping's
+ * prediction (clock set, DST change) is a jump: the mapping restarts
+ * from a coarse offset.
+ *
+ * Fed by the protocol task; read from any task.
+ *
+ * ESP32-C6 port: 2026
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include "sdkconfig.h"
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "p1p2_protocol.h"
+#include "p1p2_fseries.h"
+
+static const char *TAG = "p1p2_clock";
+
+#define MINUTE_US           60000000LL
+#define CLOCK_PAYLOAD_MIN   7
+#define ROLLOVER_MAX_GAP_US 5000000     /* wider gap: boundary not pinned down */
+
+static p1p2_clock_info_t info;
+static int64_t        offset_us;        /* controller µs since 1970 - esp_timer µs */
+static int64_t        prev_minute;      /* minutes since 1970 of the previous packet */
+static int64_t        prev_us;
+
+static portMUX_TYPE   clock_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/* Days since 1970-01-01 of a proleptic Gregorian date */
+static int64_t days_from_civil(int y, unsigned m, unsigned d)
+{
+    y -= m <= 2;
+    const int era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = (unsigned)(y - era * 400);
+    const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return (int64_t)era * 146097 + (int64_t)doe - 719468;
+}
+
+/* Minutes since 1970 from a 0x12 payload, or -1 if the fields are out of range */
+static int64_t payload_minute(const uint8_t *p)
+{
+    uint8_t hour = p[2], minute = p[3], year = p[4], month = p[5], day = p[6];
+
+    if (hour > 23 || minute > 59 || year > 99 ||
+        month < 1 || month > 12 || day < 1 || day > 31) {
+        return -1;
+    }
+    return days_from_civil(2000 + year, month, day) * 1440 + hour * 60 + minute;
+}
+
+static int64_t floor_div(int64_t a, int64_t b)
+{
+    int64_t q = a / b;
+    return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+}
+
+/* Apply the mapping to the system clock, so time() and logs follow it */
+static void set_system_time(int64_t unix_us)
+{
+#ifdef CONFIG_P1P2_BUS_CLOCK_SYSTEM_TIME
+    struct timeval tv = {
+        .tv_sec = (time_t)floor_div(unix_us, 1000000),
+        .tv_usec = (suseconds_t)(unix_us - floor_div(unix_us, 1000000) * 1000000),
+    };
+    if (settimeofday(&tv, NULL) != 0) ESP_LOGW(TAG, "settimeofday failed");
+#else
+    (void)unix_us;
+#endif
+}
+
+/*
+ * Record a 0x12 packet (full packet with header, no CRC).
+ * Called by the protocol task only.
+ */
+void p1p2_bus_clock_observe(const uint8_t *data, uint8_t length, int64_t start_us)
+{
+    if (length < 3 + CLOCK_PAYLOAD_MIN || data[2] != PKT_TYPE_DATETIME_12 ||
+        data[0] != P1P2_ADDR_MAIN_CTRL) {
+        return;
+    }
+    const uint8_t *p = data + 3;
+    int64_t minute = payload_minute(p);
+
+    portENTER_CRITICAL(&clock_lock);
+
+    if (minute < 0) {
+        info.invalid++;
+        portEXIT_CRITICAL(&clock_lock);
+        return;
+    }
+    info.packets++;
+    info.day_of_week = p[1];
+    info.last_packet_us = start_us;
+
+    p1p2_clock_sync_t was = info.sync;
+    bool restarted = false;
+    int64_t predicted = floor_div(start_us + offset_us, MINUTE_US);
+
+    if (info.sync == P1P2_CLOCK_NONE || llabs(minute - predicted) > 1) {
+        /* First time, or the controller's clock was set */
+        if (info.sync != P1P2_CLOCK_NONE) info.jumps++;
+        restarted = true;
+        info.sync = P1P2_CLOCK_COARSE;
+        offset_us = minute * MINUTE_US + MINUTE_US / 2 - start_us;
+        info.error_us = MINUTE_US / 2;
+        info.last_adjust_us = 0;
+    } else if (minute == prev_minute + 1 && start_us - prev_us < ROLLOVER_MAX_GAP_US) {
+        /* Minute boundary between the previous packet and this one */
+        int64_t boundary = prev_us + (start_us - prev_us) / 2;
+        int64_t new_offset = minute * MINUTE_US - boundary;
+        if (info.sync == P1P2_CLOCK_SYNCED) {
+            info.last_adjust_us = (int32_t)(new_offset - offset_us);
+        }
+        offset_us = new_offset;
+        info.error_us = (uint32_t)((start_us - prev_us) / 2);
+        info.sync = P1P2_CLOCK_SYNCED;
+        info.rollovers++;
+    }
+
+    prev_minute = minute;
+    prev_us = start_us;
+    int64_t unix_us = start_us + offset_us;
+    p1p2_clock_sync_t now = info.sync;
+    uint32_t error_ms = info.error_us / 1000;
+
+    portEXIT_CRITICAL(&clock_lock);
+
+    if (now != was || restarted) {
+        ESP_LOGI(TAG, "Bus clock %s: %04d-%02u-%02u %02u:%02u (±%lu ms)",
+                 now == P1P2_CLOCK_SYNCED ? "synced" : "coarse",
+                 2000 + p[4], p[5], p[6], p[2], p[3], (unsigned long)error_ms);
+        set_system_time(unix_us);
+    }
+}
+
+esp_err_t p1p2_protocol_clock_to_unix(int64_t mono_us, int64_t *unix_us)
+{
+    if (!unix_us) return ESP_ERR_INVALID_ARG;
+
+    portENTER_CRITICAL(&clock_lock);
+    bool valid = info.sync != P1P2_CLOCK_NONE;
+    *unix_us = mono_us + offset_us;
+    portEXIT_CRITICAL(&clock_lock);
+    return valid ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
+
+esp_err_t p1p2_protocol_clock_now(int64_t *unix_us)
+{
+    return p1p2_protocol_clock_to_unix(esp_timer_get_time(), unix_us);
+}
+
+void p1p2_protocol_get_clock_info(p1p2_clock_info_t *out)
+{
+    portENTER_CRITICAL(&clock_lock);
+    memcpy(out, &info, sizeof(*out));
+    portEXIT_CRITICAL(&clock_lock);
+}
+
+void p1p2_protocol_reset_clock(void)
+{
+    portENTER_CRITICAL(&clock_lock);
+    memset(&info, 0, sizeof(info));
+    offset_us = 0;
+    prev_minute = 0;
+    prev_us = 0;
+    portEXIT_CRITICAL(&clock_lock);
+}
@@ -0,0 +1,401 @@
+/*
+ * P1P2 Byte Diff — Byte changes of packet types the decoder does not know
+ *
+ * Finding out what an undocumented packet carries used to mean dumping it
+ * with M and diffing hex lines by eye. Instead, for every (src, dst, type)
+ * the tables do not describe, the last payload is kept together with, per
+ * payload byte, the number of changes, the time of the last change and the
+ * most frequent values. A change becomes an event "byte X of type Y changed
+ * from A to B", read through a cursor (CLI: D w) without a console line per
+ * packet.
+ *
+ * Line rate: an unchanged payload costs one memcmp and a counter; the value
+ * histograms are credited for all its repeats when the payload changes or
+ * is read. A byte that keeps changing (a counter, a temperature on the
+ * edge) reports at most once per CONFIG_P1P2_DIFF_HOLDOFF_MS; the changes
+ * in between are folded into the next event, which runs from the value of
+ * the previous event to the value at the end of the holdoff. The event is
+ * emitted by the next packet of the type or, if the type has gone quiet,
+ * by the protocol task's tick (p1p2_byte_diff_tick).
+ *
+ * Byte numbers are payload offsets (data[3] is byte 0), as in the
+ * parameter tables. Histograms keep P1P2_DIFF_TOP values per byte
+ * (space-saving: a new value takes over the count of the least frequent
+ * one, so counts are upper bounds once more values were seen).
+ *
+ * Called by the protocol task only; read from any task.
+ *
+ * ESP32-C6 port: 2026
+ */
+
+#include <string.h>
+#include "sdkconfig.h"
+#include "esp_err.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "p1p2_protocol.h"
+#include "p1p2_bus_config.h"
+
+static const char *TAG = "p1p2_diff";
+
+#ifndef CONFIG_P1P2_DIFF_TYPES
+#define CONFIG_P1P2_DIFF_TYPES       8
+#endif
+#ifndef CONFIG_P1P2_DIFF_HOLDOFF_MS
+#define CONFIG_P1P2_DIFF_HOLDOFF_MS  5000
+#endif
+
+#define DIFF_SLOTS        (CONFIG_P1P2_DIFF_TYPES > 0 ? CONFIG_P1P2_DIFF_TYPES : 1)
+#define DIFF_PAYLOAD_MAX  (P1P2_MAX_PACKET_SIZE - 4)
+#define DIFF_EVENTS       64        /* power of 2 */
+
+_Static_assert(DIFF_PAYLOAD_MAX <= 32, "pending bitmap must cover the payload");
+
+extern bool p1p2_fseries_packet_known(const p1p2_packet_t *pkt);
+
+typedef struct {
+    uint8_t  reported;              /* value as of the last event */
+    uint8_t  unreported;            /* changes since the last event (saturating) */
+    uint16_t changes;               /* saturating */
+    uint32_t last_change_ms;
+    uint32_t event_ms;
+    uint8_t  top_value[P1P2_DIFF_TOP];
+    uint16_t top_count[P1P2_DIFF_TOP];
+} diff_byte_t;
+
+typedef struct {
+    bool     used;
+    uint8_t  src;
+    uint8_t  dst;
+    uint8_t  type;
+    uint8_t  len;                   /* payload length */
+    uint32_t pending;               /* bytes held back by the holdoff (bitmap) */
+    uint32_t uncounted;             /* packets with this payload not in the histograms yet */
+    uint32_t packets;
+    uint32_t changes;
+    uint32_t first_ms;
+    uint32_t last_change_ms;
+    uint8_t  payload[DIFF_PAYLOAD_MAX];
+    diff_byte_t bytes[DIFF_PAYLOAD_MAX];
+} diff_slot_t;
+
+static diff_slot_t slots[DIFF_SLOTS];
+static uint32_t untracked;
+
+static p1p2_diff_event_t events[DIFF_EVENTS];
+static uint32_t event_seq;          /* events emitted since boot */
+static uint32_t event_base;         /* first event still held after a reset */
+
+static portMUX_TYPE diff_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/* Called with diff_lock held. */
+static void emit(const diff_slot_t *s, uint32_t now_ms, uint8_t offset,
+                 uint8_t from, uint8_t to, uint8_t changes)
+{
+    p1p2_diff_event_t *e = &events[event_seq & (DIFF_EVENTS - 1)];
+    e->time_ms = now_ms;
+    e->src = s->src;
+    e->dst = s->dst;
+    e->type = s->type;
+    e->offset = offset;
+    e->from = from;
+    e->to = to;
+    e->changes = changes;
+    event_seq++;
+}
+
+/* Event for byte i at its current value. Called with diff_lock held. */
+static void emit_byte(diff_slot_t *s, uint8_t i, uint32_t now_ms)
+{
+    diff_byte_t *b = &s->bytes[i];
+    emit(s, now_ms, i, b->reported, s->payload[i], b->unreported);
+    b->reported = s->payload[i];
+    b->unreported = 0;
+    b->event_ms = now_ms;
+    s->pending &= ~(1UL << i);
+}
+
+/* Report bytes whose holdoff has ended. Called with diff_lock held. */
+static void flush_due(diff_slot_t *s, uint32_t now_ms)
+{
+    uint32_t due = s->pending;
+    while (due) {
+        uint8_t i = (uint8_t)__builtin_ctz(due);
+        due &= due - 1;
+        if (now_ms - s->bytes[i].event_ms >= CONFIG_P1P2_DIFF_HOLDOFF_MS) emit_byte(s, i, now_ms);
+    }
+}
+
+/* Count w packets with value v. Called with diff_lock held. */
+static void top_add(diff_byte_t *b, uint8_t v, uint32_t w)
+{
+    int slot = -1, min = 0;
+    for (int i = 0; i < P1P2_DIFF_TOP; i++) {
+        if (b->top_count[i] && b->top_value[i] == v) {
+            slot = i;
+            break;
+        }
+        if (b->top_count[i] < b->top_count[min]) min = i;
+    }
+    if (slot < 0) {
+        slot = min;
+        b->top_value[slot] = v;
+    }
+
+    if (w > UINT16_MAX) w = UINT16_MAX;
+    while (b->top_count[slot] + w > UINT16_MAX) {
+        /* Halve all counts: recent values keep their weight */
+        for (int i = 0; i < P1P2_DIFF_TOP; i++) b->top_count[i] >>= 1;
+    }
+    b->top_count[slot] += (uint16_t)w;
+}
+
+/* Credit the uncounted repeats of the current payload. Called with diff_lock held. */
+static void credit(diff_slot_t *s)
+{
+    if (!s->uncounted) return;
+    for (uint8_t i = 0; i < s->len; i++) top_add(&s->bytes[i], s->payload[i], s->uncounted);
+    s->uncounted = 0;
+}
+
+/* Fresh per-byte state for bytes [from, len). Called with diff_lock held. */
+static void bytes_start(diff_slot_t *s, uint8_t from, uint32_t now_ms)
+{
+    for (uint8_t i = from; i < s->len; i++) {
+        diff_byte_t *b = &s->bytes[i];
+        memset(b, 0, sizeof(*b));
+        b->reported = s->payload[i];
+        b->event_ms = now_ms - CONFIG_P1P2_DIFF_HOLDOFF_MS;   /* first change reports at once */
+    }
+}
+
+static diff_slot_t *slot_find(uint8_t src, uint8_t dst, uint8_t type, bool add)
+{
+    diff_slot_t *free_slot = NULL;
+    for (int i = 0; i < DIFF_SLOTS; i++) {
+        diff_slot_t *s = &slots[i];
+        if (!s->used) {
+            if (!free_slot) free_slot = s;
+        } else if (s->src == src && s->dst == dst && s->type == type) {
+            return s;
+        }
+    }
+    return add ? free_slot : NULL;
+}
+
+void p1p2_byte_diff_reset(void)
+{
+    portENTER_CRITICAL(&diff_lock);
+    memset(slots, 0, sizeof(slots));
+    untracked = 0;
+    event_base = event_seq;
+    portEXIT_CRITICAL(&diff_lock);
+}
+
+/*
+ * A received packet: track its bytes if the decoder does not know its type.
+ */
+void p1p2_byte_diff_observe(const p1p2_packet_t *pkt)
+{
+    if (CONFIG_P1P2_DIFF_TYPES == 0) return;
+    if (pkt->has_error || pkt->length < 4 || pkt->length > P1P2_MAX_PACKET_SIZE) return;
+    if (p1p2_fseries_packet_known(pkt)) return;
+
+    const uint8_t *payload = &pkt->data[3];
+    uint8_t len = pkt->length - 4;     /* exclude src, dst, type, CRC */
+    uint32_t now_ms = (uint32_t)(pkt->start_us / 1000);
+
+    portENTER_CRITICAL(&diff_lock);
+
+    diff_slot_t *s = slot_find(pkt->data[0], pkt->data[1], pkt->data[2], true);
+    if (!s) {
+        untracked++;
+        portEXIT_CRITICAL(&diff_lock);
+        return;
+    }
+
+    if (!s->used) {
+        memset(s, 0, sizeof(*s));
+        s->used = true;
+        s->src = pkt->data[0];
+        s->dst = pkt->data[1];
+        s->type = pkt->data[2];
+        s->len = len;
+        s->packets = 1;
+        s->uncounted = 1;
+        s->first_ms = now_ms;
+        memcpy(s->payload, payload, len);
+        bytes_start(s, 0, now_ms);
+        emit(s, now_ms, P1P2_DIFF_NEW_TYPE, 0, len, 1);
+        portEXIT_CRITICAL(&diff_lock);
+        return;
+    }
+
+    s->packets++;
+    if (len == s->len && memcmp(s->payload, payload, len) == 0) {
+        /* Repeat: the common case */
+        s->uncounted++;
+        if (s->pending) flush_due(s, now_ms);
+        portEXIT_CRITICAL(&diff_lock);
+        return;
+    }
+
+    credit(s);
+    if (len != s->len) emit(s, now_ms, P1P2_DIFF_LENGTH, s->len, len, 1);
+
+    uint8_t common = len < s->len ? len : s->len;
+    uint8_t old_len = s->len;
+    s->len = len;
+    s->uncounted = 1;
+    s->pending &= (len < 32) ? ((1UL << len) - 1) : UINT32_MAX;
+
+    for (uint8_t i = 0; i < common; i++) {
+        if (payload[i] == s->payload[i]) continue;
+        diff_byte_t *b = &s->bytes[i];
+        s->payload[i] = payload[i];
+        s->changes++;
+        s->last_change_ms = now_ms;
+        if (b->changes < UINT16_MAX) b->changes++;
+        if (b->unreported < UINT8_MAX) b->unreported++;
+        b->last_change_ms = now_ms;
+        s->pending |= 1UL << i;
+    }
+    if (len > old_len) {
+        memcpy(&s->payload[old_len], &payload[old_len], len - old_len);
+        bytes_start(s, old_len, now_ms);
+    }
+    flush_due(s, now_ms);
+
+    portEXIT_CRITICAL(&diff_lock);
+}
+
+/*
+ * Report folded changes whose holdoff has ended, also for types that sent
+ * no packet since. Called by the protocol task on every loop.
+ */
+void p1p2_byte_diff_tick(int64_t now_us)
+{
+    if (CONFIG_P1P2_DIFF_TYPES == 0) return;
+    uint32_t now_ms = (uint32_t)(now_us / 1000);
+
+    portENTER_CRITICAL(&diff_lock);
+    for (int i = 0; i < DIFF_SLOTS; i++) {
+        if (slots[i].used && slots[i].pending) flush_due(&slots[i], now_ms);
+    }
+    portEXIT_CRITICAL(&diff_lock);
+}
+
+/*
+ * ============================================================
+ * Public API
+ * ============================================================
+ */
+
+uint32_t p1p2_protocol_diff_seq(void)
+{
+    portENTER_CRITICAL(&diff_lock);
+    uint32_t seq = event_seq;
+    portEXIT_CRITICAL(&diff_lock);
+    return seq;
+}
+
+int p1p2_protocol_diff_read(uint32_t *cursor, p1p2_diff_event_t *out, int max, uint32_t *lost)
+{
+    int n = 0;
+
+    portENTER_CRITICAL(&diff_lock);
+    uint32_t held = event_seq - event_base;
+    if (held > DIFF_EVENTS) held = DIFF_EVENTS;
+    uint32_t oldest = event_seq - held;
+
+    if ((int32_t)(*cursor - event_seq) > 0) *cursor = event_seq;
+    if ((int32_t)(oldest - *cursor) > 0) {
+        if (lost) *lost += oldest - *cursor;
+        *cursor = oldest;
+    }
+    while (*cursor != event_seq && n < max) {
+        out[n++] = events[*cursor & (DIFF_EVENTS - 1)];
+        (*cursor)++;
+    }
+    portEXIT_CRITICAL(&diff_lock);
+
+    return n;
+}
+
+int p1p2_protocol_diff_types(p1p2_diff_type_info_t *out, int max)
+{
+    int n = 0;
+
+    portENTER_CRITICAL(&diff_lock);
+    for (int i = 0; i < DIFF_SLOTS && n < max; i++) {
+        const diff_slot_t *s = &slots[i];
+        if (!s->used) continue;
+        p1p2_diff_type_info_t *t = &out[n++];
+        t->src = s->src;
+        t->dst = s->dst;
+        t->type = s->type;
+        t->length = s->len;
+        t->packets = s->packets;
+        t->changes = s->changes;
+        t->first_ms = s->first_ms;
+        t->last_change_ms = s->last_change_ms;
+    }
+    portEXIT_CRITICAL(&diff_lock);
+
+    return n;
+}
+
+esp_err_t p1p2_protocol_diff_bytes(uint8_t src, uint8_t dst, uint8_t type,
+                                   p1p2_diff_byte_t *out, int max, uint8_t *length)
+{
+    portENTER_CRITICAL(&diff_lock);
+    diff_slot_t *s = slot_find(src, dst, type, false);
+    if (!s) {
+        portEXIT_CRITICAL(&diff_lock);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    credit(s);
+    int n = s->len < max ? s->len : max;
+    for (int i = 0; i < n; i++) {
+        const diff_byte_t *b = &s->bytes[i];
+        p1p2_diff_byte_t *o = &out[i];
+        o->value = s->payload[i];
+        o->changes = b->changes;
+        o->last_change_ms = b->last_change_ms;
+        memcpy(o->top_value, b->top_value, sizeof(o->top_value));
+        memcpy(o->top_count, b->top_count, sizeof(o->top_count));
+    }
+    *length = s->len;
+    portEXIT_CRITICAL(&diff_lock);
+
+    /* Most frequent value first */
+    for (int i = 0; i < n; i++) {
+        p1p2_diff_byte_t *o = &out[i];
+        for (int j = 1; j < P1P2_DIFF_TOP; j++) {
+            for (int k = j; k > 0 && o->top_count[k] > o->top_count[k - 1]; k--) {
+                uint8_t v = o->top_value[k];
+                uint16_t c = o->top_count[k];
+                o->top_value[k] = o->top_value[k - 1];
+                o->top_count[k] = o->top_count[k - 1];
+                o->top_value[k - 1] = v;
+                o->top_count[k - 1] = c;
+            }
+        }
+    }
+    return ESP_OK;
+}
+
+uint32_t p1p2_protocol_diff_untracked(void)
+{
+    portENTER_CRITICAL(&diff_lock);
+    uint32_t n = untracked;
+    portEXIT_CRITICAL(&diff_lock);
+    return n;
+}
+
+void p1p2_protocol_diff_reset(void)
+{
+    p1p2_byte_diff_reset();
+    ESP_LOGI(TAG, "Byte diff tables cleared");
+}
@@ -0,0 +1,270 @@
+/*
+ * P1P2 Counter Poll — Periodic 0xA3 counter requests within a bus-load budget
+ *
+ * Operation hours and compressor starts (0xA3 reply) are only sent when
+ * asked for. As auxiliary controller we ask every
+ * CONFIG_P1P2_COUNTER_POLL_INTERVAL_S seconds, in a predicted idle window
+ * (p1p2_bus_write_packet_idle) so the control exchanges are not disturbed.
+ * The reply is decoded by the normal path.
+ *
+ * The first request goes out one interval after start, once the bus
+ * schedule has had time to learn the idle windows. A request is held back
+ * while the bus load (last second or last minute) is at or above
+ * CONFIG_P1P2_COUNTER_POLL_MAX_LOAD, and is never sent sooner than one bus
+ * cycle after the previous one, so retries spread over cycles. The reply is
+ * expected within a few cycles of our request's read-back, not of queuing
+ * it: the request may wait for its idle window. A missing reply, a request
+ * that never found a window, a read-back error on our request or new bus
+ * collisions since the previous request double the retry spacing, up to
+ * 2^COUNTER_BACKOFF_MAX cycles; a reply resets it.
+ *
+ * Called by the protocol task only; statistics are read from any task.
+ *
+ * ESP32-C6 port: 2026
+ */
+
+#include <string.h>
+#include "sdkconfig.h"
+#include "esp_err.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "p1p2_protocol.h"
+#include "p1p2_fseries.h"
+#include "p1p2_bus.h"
+#include "p1p2_bus_load.h"
+
+static const char *TAG = "p1p2_counters";
+
+#ifndef CONFIG_P1P2_COUNTER_POLL_INTERVAL_S
+#define CONFIG_P1P2_COUNTER_POLL_INTERVAL_S  300
+#endif
+#ifndef CONFIG_P1P2_COUNTER_POLL_MAX_LOAD
+#define CONFIG_P1P2_COUNTER_POLL_MAX_LOAD    700
+#endif
+
+#define COUNTER_CYCLE_DEFAULT_US   1000000     /* until the bus cycle is measured */
+#define COUNTER_CYCLE_MIN_US       200000
+#define COUNTER_CYCLE_MAX_US       10000000
+#define COUNTER_REPLY_CYCLES       4           /* reply expected within, after read-back */
+#define COUNTER_BACKOFF_MAX        6
+
+static const uint8_t counter_request[F_COUNTER_REQ_LEN] = {
+    P1P2_ADDR_MAIN_CTRL, P1P2_ADDR_MAIN_CTRL, PKT_TYPE_COUNTER_A3, 0x00,
+};
+
+static p1p2_counter_poll_stats_t stats;
+static uint32_t interval_s = CONFIG_P1P2_COUNTER_POLL_INTERVAL_S;
+static uint16_t max_load = CONFIG_P1P2_COUNTER_POLL_MAX_LOAD;
+static bool     armed;                  /* next_us set from the first tick */
+static int64_t  next_us;                /* next request (or deadline) due, 0: at once */
+static int64_t  queued_us;              /* request waiting for its idle window, 0 if none */
+static int64_t  sent_us;                /* read-back of the request in flight, 0 if none */
+static uint32_t collisions_at_send;
+
+static portMUX_TYPE poll_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/* Bus cycle period (p50), or a default before it is measured */
+static int64_t cycle_us(void)
+{
+    p1p2_hist_t period;
+    if (p1p2_protocol_get_cycle_stats(&period, NULL) < 2) return COUNTER_CYCLE_DEFAULT_US;
+
+    int64_t c = p1p2_hist_percentile(&period, 50);
+    if (c < COUNTER_CYCLE_MIN_US) c = COUNTER_CYCLE_MIN_US;
+    if (c > COUNTER_CYCLE_MAX_US) c = COUNTER_CYCLE_MAX_US;
+    return c;
+}
+
+/* Retry after 2^backoff cycles, one level further back. Called with poll_lock held. */
+static void back_off(int64_t now_us, int64_t cycle)
+{
+    if (stats.backoff < COUNTER_BACKOFF_MAX) stats.backoff++;
+    next_us = now_us + (cycle << stats.backoff);
+}
+
+void p1p2_counter_poll_reset(void)
+{
+    portENTER_CRITICAL(&poll_lock);
+    memset(&stats, 0, sizeof(stats));
+    armed = false;
+    next_us = 0;
+    queued_us = 0;
+    sent_us = 0;
+    collisions_at_send = 0;
+    portEXIT_CRITICAL(&poll_lock);
+}
+
+/*
+ * Whether a request should be queued now. Deadlines that passed are
+ * handled here: a request that never reached the bus or got no reply
+ * backs off. The caller queues the request and reports the result with
+ * p1p2_counter_poll_queued().
+ */
+bool p1p2_counter_poll_due(int64_t now_us)
+{
+    if (interval_s == 0) return false;
+
+    portENTER_CRITICAL(&poll_lock);
+    if (!armed) {
+        /* First request one interval after start, when the schedule is learned */
+        armed = true;
+        next_us = now_us + (int64_t)interval_s * 1000000;
+    }
+    bool wait = now_us < next_us;
+    portEXIT_CRITICAL(&poll_lock);
+    if (wait) return false;
+
+    int64_t cycle = cycle_us();
+    p1p2_bus_stats_t bus;
+    p1p2_bus_get_stats(&bus);
+
+    portENTER_CRITICAL(&poll_lock);
+
+    if (queued_us) {
+        /* The request found no idle window and was dropped by the bus */
+        stats.unsent++;
+        queued_us = 0;
+        back_off(now_us, cycle);
+        portEXIT_CRITICAL(&poll_lock);
+        return false;
+    }
+    if (sent_us) {
+        /* The previous request was not answered in time */
+        stats.timeouts++;
+        sent_us = 0;
+        back_off(now_us, cycle);
+        portEXIT_CRITICAL(&poll_lock);
+        return false;
+    }
+    if (stats.requests && bus.collision_errors != collisions_at_send) {
+        /* The bus got busier since the last request: wait longer */
+        stats.collision_backoffs++;
+        collisions_at_send = bus.collision_errors;
+        back_off(now_us, cycle);
+        portEXIT_CRITICAL(&poll_lock);
+        return false;
+    }
+    portEXIT_CRITICAL(&poll_lock);
+
+    p1p2_bus_load_t load;
+    p1p2_bus_get_load(&load);
+    if (load.load_1s >= max_load || load.load_1m >= max_load) {
+        portENTER_CRITICAL(&poll_lock);
+        stats.deferred++;
+        next_us = now_us + cycle;
+        portEXIT_CRITICAL(&poll_lock);
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Result of queuing a request that p1p2_counter_poll_due() asked for.
+ */
+void p1p2_counter_poll_queued(int64_t now_us, esp_err_t ret)
+{
+    int64_t cycle = cycle_us();
+    p1p2_bus_stats_t bus;
+    p1p2_bus_get_stats(&bus);
+
+    portENTER_CRITICAL(&poll_lock);
+    if (ret == ESP_OK) {
+        stats.requests++;
+        queued_us = now_us;
+        collisions_at_send = bus.collision_errors;
+        /* Deadline for the read-back: the bus drops a write that finds no window */
+        next_us = now_us + P1P2_IDLE_WRITE_MAX_WAIT_MS * 1000LL + cycle;
+    } else {
+        stats.deferred++;
+        next_us = now_us + cycle;
+    }
+    portEXIT_CRITICAL(&poll_lock);
+
+    if (ret != ESP_OK) ESP_LOGD(TAG, "Counter request not queued: %s", esp_err_to_name(ret));
+}
+
+/*
+ * Send a request when one is due. Called by the protocol task on every
+ * loop while acting as auxiliary controller.
+ */
+void p1p2_counter_poll_tick(int64_t now_us)
+{
+    if (!p1p2_counter_poll_due(now_us)) return;
+
+    esp_err_t ret = p1p2_bus_write_packet_idle(counter_request, sizeof(counter_request),
+                                               F_SERIES_CRC_GEN, F_SERIES_CRC_FEED);
+    p1p2_counter_poll_queued(now_us, ret);
+}
+
+/*
+ * A received packet: a counter reply ends the request in flight.
+ */
+void p1p2_counter_poll_observe(const p1p2_packet_t *pkt)
+{
+    if (pkt->has_error || pkt->length < F_COUNTER_RSP_MIN_LEN ||
+        pkt->data[2] != PKT_TYPE_COUNTER_A3) {
+        return;
+    }
+
+    portENTER_CRITICAL(&poll_lock);
+    if (sent_us && pkt->start_us >= sent_us) {
+        stats.replies++;
+        stats.backoff = 0;
+        stats.last_reply_us = pkt->start_us;
+        sent_us = 0;
+        next_us = pkt->start_us + (int64_t)interval_s * 1000000;
+    }
+    portEXIT_CRITICAL(&poll_lock);
+}
+
+/*
+ * Read-back of a packet we sent: the reply deadline starts at the end of
+ * our request; a damaged request is retried later.
+ */
+void p1p2_counter_poll_confirmed(const p1p2_tx_confirm_t *conf)
+{
+    if (conf->length < 3 || conf->data[2] != PKT_TYPE_COUNTER_A3) return;
+
+    int64_t cycle = cycle_us();
+
+    portENTER_CRITICAL(&poll_lock);
+    bool was_queued = queued_us != 0;
+    if (was_queued) {
+        queued_us = 0;
+        if (conf->ok) {
+            sent_us = conf->eop_us;
+            /* Reply deadline; also keeps the next request at least a cycle away */
+            next_us = conf->eop_us + cycle * COUNTER_REPLY_CYCLES;
+        } else {
+            stats.readback_errors++;
+            back_off(conf->eop_us, cycle);
+        }
+    }
+    uint8_t backoff = stats.backoff;
+    portEXIT_CRITICAL(&poll_lock);
+
+    if (was_queued && !conf->ok) {
+        ESP_LOGW(TAG, "Counter request read-back error, retry in %lu cycles",
+                 (unsigned long)(1UL << backoff));
+    }
+}
+
+void p1p2_protocol_get_counter_poll_stats(p1p2_counter_poll_stats_t *out)
+{
+    portENTER_CRITICAL(&poll_lock);
+    memcpy(out, &stats, sizeof(*out));
+    out->interval_s = interval_s;
+    out->max_load = max_load;
+    portEXIT_CRITICAL(&poll_lock);
+}
+
+void p1p2_protocol_set_counter_poll(uint32_t new_interval_s, uint16_t new_max_load)
+{
+    portENTER_CRITICAL(&poll_lock);
+    interval_s = new_interval_s;
+    max_load = new_max_load;
+    if (armed && !queued_us && !sent_us) next_us = 0;
+    portEXIT_CRITICAL(&poll_lock);
+    ESP_LOGI(TAG, "Counter poll every %lu s, load budget %u.%u %%",
+             (unsigned long)new_interval_s, new_max_load / 10, new_max_load % 10);
+}
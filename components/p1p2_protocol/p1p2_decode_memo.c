@@ -0,0 +1,93 @@
+/*
+ * P1P2 Decode Memo — Skip re-decoding repeated packets
+ *
+ * The F-series bus repeats the same status packets every cycle, usually
+ * byte-identical. The protocol task decodes through this cache, which
+ * keeps the last payload per (source, destination, type):
+ *   - identical payload: nothing to decode, only the packet counters move
+ *   - changed payload: only fields whose bytes differ are decoded
+ * Both shortcuts assume the state still holds what the previous payload
+ * decoded to. Several packet types write the same state members (0x10 and
+ * 0x38 both carry power/mode), so every change to the state bumps an epoch;
+ * an entry decoded before the latest change is decoded in full once.
+ * Entries are per unit state (p1p2_unit_map.c); the unit map invalidates
+ * them all when a state is created or replaced under an address.
+ *
+ * Each engine has its own memo (p1p2_protocol_t), used by the engine's
+ * thread only, on its private working copy of the state (see
+ * p1p2_engine_state_publish()).
+ *
+ * ESP32-C6 port: 2026
+ */
+
+#include <string.h>
+#include "esp_timer.h"
+#include "p1p2_protocol.h"
+#include "p1p2_protocol_engine.h"
+
+#define MEMO_MAX_PROBE   4
+
+extern uint8_t p1p2_fseries_decode_fields(const p1p2_packet_t *pkt, p1p2_hvac_state_t *state,
+                                          const uint8_t *prev);
+
+static p1p2_memo_entry_t *memo_slot(p1p2_decode_memo_t *m, uint8_t src, uint8_t dst,
+                                    uint8_t type)
+{
+    uint8_t idx = (type ^ (src >> 2) ^ dst) & (P1P2_MEMO_SIZE - 1);
+    for (int probe = 0; probe < MEMO_MAX_PROBE; probe++) {
+        p1p2_memo_entry_t *e = &m->entries[(idx + probe) & (P1P2_MEMO_SIZE - 1)];
+        if (!e->used || (e->src == src && e->dst == dst && e->type == type)) return e;
+    }
+    return NULL;
+}
+
+void p1p2_decode_memo_reset(p1p2_decode_memo_t *m)
+{
+    memset(m, 0, sizeof(*m));
+}
+
+/* Force the next packet of every (src, dst, type) to decode in full */
+void p1p2_decode_memo_invalidate(p1p2_decode_memo_t *m)
+{
+    m->epoch++;
+}
+
+/*
+ * Decode a packet into state through the memo cache.
+ */
+void p1p2_decode_memo_packet(p1p2_decode_memo_t *m, const p1p2_packet_t *pkt,
+                             p1p2_hvac_state_t *state)
+{
+    if (pkt->length < 4 || pkt->length - 4 > P1P2_MEMO_PAYLOAD_MAX) {
+        if (p1p2_fseries_decode_fields(pkt, state, NULL)) m->epoch++;
+        m->decoded++;
+        return;
+    }
+
+    const uint8_t *payload = &pkt->data[3];
+    uint8_t len = pkt->length - 4;
+    p1p2_memo_entry_t *e = memo_slot(m, pkt->data[0], pkt->data[1], pkt->data[2]);
+
+    /* Previous payload is only usable if nothing else changed the state since */
+    bool current = e && e->used && e->len == len && e->epoch == m->epoch;
+
+    if (current && memcmp(e->payload, payload, len) == 0) {
+        state->last_update_us = esp_timer_get_time();
+        state->packet_count++;
+        m->skipped++;
+        return;
+    }
+
+    if (p1p2_fseries_decode_fields(pkt, state, current ? e->payload : NULL)) m->epoch++;
+    m->decoded++;
+
+    if (e) {
+        e->src = pkt->data[0];
+        e->dst = pkt->data[1];
+        e->type = pkt->data[2];
+        e->len = len;
+        e->used = true;
+        e->epoch = m->epoch;
+        memcpy(e->payload, payload, len);
+    }
+}
@@ -0,0 +1,121 @@
+/*
+ * P1P2 F-Series Codec — 0x38/0x3B control response layouts
+ *
+ * Compile-time layouts (p1p2_field_codec.hpp) for the auxiliary controller
+ * responses built by p1p2_fseries_control.c. Each response is a fixed set
+ * of copy rules from the request payload; the encoders unroll to straight
+ * byte moves, and the request length they need is derived from the rules.
+ *
+ * Port of P1P2Monitor.ino lines 2416-2469 (0x38) and 2514-2540 (0x3B).
+ *
+ * Original: Copyright (c) 2019-2024 Arnold Niessen — CC BY-NC-ND 4.0
+ * ESP32-C6 port: 2026
+ */
+
+#include <stdint.h>
+#include "p1p2_bus_config.h"
+#include "p1p2_fseries.h"
+#include "p1p2_field_codec.hpp"
+
+using namespace p1p2;
+
+namespace {
+
+/* ---- 0x38/0x3B request payload (from the indoor unit) ---- */
+using ReqStatus      = Byte<F38_REQ_STATUS>;
+using ReqMode        = Byte<F38_REQ_MODE>;
+using ReqCoolTemp    = Field<int16_t, F38_REQ_COOL_TEMP, 1, Endian::Big, 10>;  /* °C × 10 */
+using ReqCoolFan     = Byte<F38_REQ_COOL_FAN>;
+using ReqHeatTemp    = Field<int16_t, F38_REQ_HEAT_TEMP, 1, Endian::Big, 10>;
+using ReqHeatFan     = Byte<F38_REQ_HEAT_FAN>;
+using ReqHeatFanChg  = Byte<F38_REQ_HEAT_FAN_CHG>;
+using ReqFanMode     = Byte<F38_REQ_FAN_MODE>;
+using Req3bZones     = Byte<17>;                   /* RB[20] */
+using Req3bFanMode   = Byte<18>;                   /* RB[21] */
+
+/* ---- Response payload fields ---- */
+using RspStatus      = Byte<F38_RSP_STATUS>;
+using RspMode        = Byte<F38_RSP_MODE>;
+using RspCoolTemp    = Field<int16_t, F38_RSP_COOL_TEMP, 1, Endian::Big, 10>;
+using RspCoolFan     = Byte<F38_RSP_COOL_FAN>;
+using RspHeatTemp    = Field<int16_t, F38_RSP_HEAT_TEMP, 1, Endian::Big, 10>;
+using RspHeatFan     = Byte<F38_RSP_HEAT_FAN>;
+using RspHeatFanChg  = Byte<F38_RSP_HEAT_FAN_CHG>;
+using RspFanMode     = Byte<F38_RSP_FAN_MODE>;     /* 0x38 */
+using Rsp3bZones     = Byte<16>;                   /* WB[19] */
+using Rsp3bFanMode   = Byte<17>;                   /* WB[20] */
+
+/* Model BCL (FDY): 15-byte payload */
+using Rsp38Bcl = Layout<15, RspStatus, RspMode, RspCoolTemp, RspCoolFan,
+                        RspHeatTemp, RspHeatFan, RspHeatFanChg, RspFanMode>;
+using Map38Bcl = ResponseMap<Rsp38Bcl,
+    Copy<RspStatus,     ReqStatus,     0x01>,
+    Copy<RspMode,       ReqMode,       0x07, 0x60>,
+    Copy<RspCoolTemp,   ReqCoolTemp>,
+    Copy<RspCoolFan,    ReqCoolFan,    0x60, 0x11>,
+    Copy<RspHeatTemp,   ReqHeatTemp>,
+    Copy<RspHeatFan,    ReqHeatFan,    0x60, 0x11>,
+    Copy<RspHeatFanChg, ReqHeatFanChg, 0x7F>,
+    Copy<RspFanMode,    ReqFanMode>>;
+
+/* Model P (FXMQ): 17-byte payload, mode and fan bytes passed through */
+using Rsp38P = Layout<17, RspStatus, RspMode, RspCoolTemp, RspCoolFan,
+                      RspHeatTemp, RspHeatFan, RspHeatFanChg, RspFanMode>;
+using Map38P = ResponseMap<Rsp38P,
+    Copy<RspStatus,     ReqStatus,     0x01>,
+    Copy<RspMode,       ReqMode>,
+    Copy<RspCoolTemp,   ReqCoolTemp>,
+    Copy<RspCoolFan,    ReqCoolFan>,
+    Copy<RspHeatTemp,   ReqHeatTemp>,
+    Copy<RspHeatFan,    ReqHeatFan>,
+    Copy<RspHeatFanChg, ReqHeatFanChg>,
+    Copy<RspFanMode,    ReqFanMode>,
+    Set<Byte<15>, 0x00>>;                          /* WB[18] puzzle: initially 0, then 2, then 1 */
+
+/* Model M (FDYQ) 0x3B: 19-byte payload with zones */
+using Rsp3bM = Layout<19, RspStatus, RspMode, RspCoolTemp, RspCoolFan,
+                      RspHeatTemp, RspHeatFan, RspHeatFanChg, Rsp3bZones, Rsp3bFanMode>;
+using Map3bM = ResponseMap<Rsp3bM,
+    Copy<RspStatus,     ReqStatus,     0x01>,
+    Copy<RspMode,       ReqMode,       0x07, 0x60>,
+    Copy<RspCoolTemp,   ReqCoolTemp>,
+    Copy<RspCoolFan,    ReqCoolFan,    0x60, 0x11>,
+    Copy<RspHeatTemp,   ReqHeatTemp>,
+    Copy<RspHeatFan,    ReqHeatFan,    0x60, 0x11>,
+    Copy<RspHeatFanChg, ReqHeatFanChg, 0x7F>,
+    Copy<Rsp3bZones,    Req3bZones>,
+    Copy<Rsp3bFanMode,  Req3bFanMode,  0x03>>;
+
+/* Responses plus CRC must fit a bus packet */
+static_assert(3 + Map38P::rsp_size + 1 <= P1P2_MAX_PACKET_SIZE, "0x38 response exceeds packet size");
+static_assert(3 + Map3bM::rsp_size + 1 <= P1P2_MAX_PACKET_SIZE, "0x3B response exceeds packet size");
+
+template <typename Map>
+uint8_t encode(const uint8_t *rb, uint8_t rb_len, uint8_t *wb, uint8_t wb_max)
+{
+    if (rb_len < 3 + Map::req_size) return 0;
+    if (wb_max < 3 + Map::rsp_size) return 0;
+    Map::encode(&rb[3], &wb[3]);
+    return 3 + Map::rsp_size;
+}
+
+} // namespace
+
+/*
+ * Fill the payload of a control response (wb[3..]) from the request rb.
+ * Returns the response length excluding CRC, or 0 if the model has no
+ * response for this type or either buffer is too short. The header and
+ * pending writes are left to the caller.
+ */
+extern "C" uint8_t p1p2_fseries_encode_response(uint8_t type, int model,
+                                                const uint8_t *rb, uint8_t rb_len,
+                                                uint8_t *wb, uint8_t wb_max)
+{
+    if (type == PKT_TYPE_CTRL_38) {
+        if (model == F_MODEL_BCL) return encode<Map38Bcl>(rb, rb_len, wb, wb_max);
+        if (model == F_MODEL_P)   return encode<Map38P>(rb, rb_len, wb, wb_max);
+    } else if (type == PKT_TYPE_CTRL_3B) {
+        if (model == F_MODEL_M)   return encode<Map3bM>(rb, rb_len, wb, wb_max);
+    }
+    return 0;
+}
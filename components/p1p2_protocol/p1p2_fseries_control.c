@@ -10,6 +10,11 @@
  * The response also applies any pending write commands (temperature change,
  * mode change, etc.) from the Matter layer.
  *
+ * The model can be detected from the control requests on the bus instead
+ * of being fixed at build time (see p1p2_fseries_model_observe).
+ *
+ * All state is per engine (p1p2_fseries_ctrl_t in p1p2_protocol_engine.h).
+ *
  * Original: Copyright (c) 2019-2024 Arnold Niessen — CC BY-NC-ND 4.0
  * ESP32-C6 port: 2026
  */
@@ -20,44 +25,113 @@
 #include "p1p2_fseries.h"
 #include "p1p2_bus.h"
 #include "p1p2_bus_types.h"
+#include "p1p2_protocol_engine.h"
 
 static const char *TAG = "p1p2_ctrl";
 
-/* Pending write commands — set by Matter command callbacks */
-#define MAX_PENDING_WRITES 8
-
-typedef struct {
-    uint8_t  packet_type;    /* which packet type this write targets */
-    uint8_t  payload_offset; /* byte offset within response payload */
-    uint8_t  value;          /* value to write */
-    uint8_t  mask;           /* mask for preserving existing bits (0x00 = replace all) */
-    uint8_t  count;          /* remaining write attempts (0 = inactive) */
-} pending_write_t;
+/* Compile-time response layouts from p1p2_fseries_codec.cpp */
+extern uint8_t p1p2_fseries_encode_response(uint8_t type, int model,
+                                            const uint8_t *rb, uint8_t rb_len,
+                                            uint8_t *wb, uint8_t wb_max);
 
-static pending_write_t pending_writes[MAX_PENDING_WRITES];
-static int model_id;
+/*
+ * Model detection. 0x3B requests only exist on model M; 0x3A only on
+ * model P. The indoor unit polls the 0x3x types in rotation, so model BCL
+ * is only concluded once MODEL_BCL_AFTER_38 0x38 requests went by without
+ * a 0x3A. A request only counts if the candidate model can answer it
+ * (length covers the response map).
+ */
+#define MODEL_BCL_AFTER_38  16
 
-void p1p2_fseries_control_init(int model)
+void p1p2_fseries_control_init(p1p2_fseries_ctrl_t *c, int model)
 {
-    model_id = model;
-    memset(pending_writes, 0, sizeof(pending_writes));
+    memset(c, 0, sizeof(*c));
+    c->model_id = model;
     ESP_LOGI(TAG, "F-series control initialized for model %d", model);
 }
 
+/*
+ * Start detecting the model from bus traffic. Until a model is known
+ * (model_id F_MODEL_AUTO), only model-independent responses are sent.
+ */
+void p1p2_fseries_model_detect_start(p1p2_fseries_ctrl_t *c)
+{
+    c->model_detecting = true;
+    c->model_seen_3a = false;
+    c->model_seen_38 = 0;
+}
+
+int p1p2_fseries_control_get_model(const p1p2_fseries_ctrl_t *c)
+{
+    return c->model_id;
+}
+
+static bool model_can_answer(int model, const p1p2_packet_t *pkt)
+{
+    uint8_t wb[P1P2_MAX_PACKET_SIZE];
+    return p1p2_fseries_encode_response(pkt->data[2], model, pkt->data, pkt->length,
+                                        wb, sizeof(wb)) != 0;
+}
+
+/*
+ * Feed a received packet to the model detector. Returns the model once
+ * detection concludes with a model other than the one in use (which it
+ * then replaces), F_MODEL_AUTO otherwise. Detection runs once per start.
+ */
+int p1p2_fseries_model_observe(p1p2_fseries_ctrl_t *c, const p1p2_packet_t *pkt)
+{
+    if (!c->model_detecting || pkt->has_error || pkt->length < 4) return F_MODEL_AUTO;
+    if (pkt->data[0] == P1P2_ADDR_AUX_CTRL || pkt->data[1] != P1P2_ADDR_AUX_CTRL) return F_MODEL_AUTO;
+
+    int found = F_MODEL_AUTO;
+    switch (pkt->data[2]) {
+    case PKT_TYPE_CTRL_3A:
+        c->model_seen_3a = true;
+        break;
+    case PKT_TYPE_CTRL_3B:
+        if (model_can_answer(F_MODEL_M, pkt)) found = F_MODEL_M;
+        break;
+    case PKT_TYPE_CTRL_38:
+        if (c->model_seen_3a && model_can_answer(F_MODEL_P, pkt)) {
+            found = F_MODEL_P;
+        } else if (model_can_answer(F_MODEL_BCL, pkt) && ++c->model_seen_38 >= MODEL_BCL_AFTER_38) {
+            found = F_MODEL_BCL;
+        }
+        break;
+    default:
+        break;
+    }
+
+    if (found == F_MODEL_AUTO) return F_MODEL_AUTO;
+    c->model_detecting = false;
+    if (found == c->model_id) {
+        ESP_LOGI(TAG, "Model %d confirmed from bus traffic", found);
+        return F_MODEL_AUTO;
+    }
+    ESP_LOGI(TAG, "Model %d detected from bus traffic (was %d)", found, c->model_id);
+    c->model_id = found;
+    /* Writes queued for the old model's packet type would never apply */
+    memset(c->pending_writes, 0, sizeof(c->pending_writes));
+    memset(&c->inflight, 0, sizeof(c->inflight));
+    return found;
+}
+
 /*
  * Queue a pending parameter write.
  * This will be applied to the next matching control response.
  */
-esp_err_t p1p2_fseries_queue_write(uint8_t packet_type, uint8_t payload_offset,
-                                    uint8_t value, uint8_t mask, uint8_t count)
+esp_err_t p1p2_fseries_queue_write(p1p2_fseries_ctrl_t *c, uint8_t packet_type,
+                                   uint8_t payload_offset, uint8_t value,
+                                   uint8_t mask, uint8_t count)
 {
-    for (int i = 0; i < MAX_PENDING_WRITES; i++) {
-        if (pending_writes[i].count == 0) {
-            pending_writes[i].packet_type = packet_type;
-            pending_writes[i].payload_offset = payload_offset;
-            pending_writes[i].value = value;
-            pending_writes[i].mask = mask;
-            pending_writes[i].count = count;
+    for (int i = 0; i < P1P2_MAX_PENDING_WRITES; i++) {
+        if (c->pending_writes[i].count == 0) {
+            c->pending_writes[i].packet_type = packet_type;
+            c->pending_writes[i].payload_offset = payload_offset;
+            c->pending_writes[i].value = value;
+            c->pending_writes[i].mask = mask;
+            c->pending_writes[i].count = count;
+            c->write_seq[i]++;
             ESP_LOGI(TAG, "Queued write: pkt=0x%02X off=%d val=0x%02X mask=0x%02X cnt=%d",
                      packet_type, payload_offset, value, mask, count);
             return ESP_OK;
@@ -70,30 +144,58 @@ esp_err_t p1p2_fseries_queue_write(uint8_t packet_type, uint8_t payload_offset,
 /*
  * Apply pending writes to a response buffer.
  */
-static void apply_pending_writes(uint8_t packet_type, uint8_t *wb, uint8_t wb_len)
+static void apply_pending_writes(p1p2_fseries_ctrl_t *c, uint8_t packet_type,
+                                 uint8_t *wb, uint8_t wb_len)
 {
-    for (int i = 0; i < MAX_PENDING_WRITES; i++) {
-        if (pending_writes[i].count && pending_writes[i].packet_type == packet_type) {
-            uint8_t off = pending_writes[i].payload_offset;
+    c->inflight.packet_type = packet_type;
+    c->inflight.slots = 0;
+
+    for (int i = 0; i < P1P2_MAX_PENDING_WRITES; i++) {
+        if (c->pending_writes[i].count && c->pending_writes[i].packet_type == packet_type) {
+            uint8_t off = c->pending_writes[i].payload_offset;
             if (off < wb_len) {
-                wb[off] = pending_writes[i].value |
-                          (pending_writes[i].mask & wb[off]);
-                pending_writes[i].count |= 0x80; /* mark as applied this cycle */
+                wb[off] = c->pending_writes[i].value |
+                          (c->pending_writes[i].mask & wb[off]);
+                c->pending_writes[i].count |= 0x80; /* mark as applied this cycle */
             }
         }
     }
 
     /* Decrement counts for applied writes */
-    for (int i = 0; i < MAX_PENDING_WRITES; i++) {
-        if (pending_writes[i].count & 0x80) {
-            pending_writes[i].count--;
-            pending_writes[i].count &= 0x7F;
+    for (int i = 0; i < P1P2_MAX_PENDING_WRITES; i++) {
+        if (c->pending_writes[i].count & 0x80) {
+            c->pending_writes[i].count--;
+            c->pending_writes[i].count &= 0x7F;
+            c->inflight.slots |= (1 << i);
+            c->inflight.seq[i] = c->write_seq[i];
             ESP_LOGI(TAG, "Write applied: pkt=0x%02X off=%d remaining=%d",
-                     pending_writes[i].packet_type,
-                     pending_writes[i].payload_offset,
-                     pending_writes[i].count);
+                     c->pending_writes[i].packet_type,
+                     c->pending_writes[i].payload_offset,
+                     c->pending_writes[i].count);
+        }
+    }
+}
+
+/*
+ * Transmit confirmation for a response we sent. On a read-back error the
+ * response may not have reached the indoor unit, so every write it carried
+ * gets its attempt back and goes out again in the next response.
+ */
+void p1p2_fseries_tx_confirmed(p1p2_fseries_ctrl_t *c, const p1p2_tx_confirm_t *conf)
+{
+    if (conf->length < 3 || conf->data[2] != c->inflight.packet_type) return;
+
+    if (!conf->ok) {
+        for (int i = 0; i < P1P2_MAX_PENDING_WRITES; i++) {
+            if (!(c->inflight.slots & (1 << i))) continue;
+            if (c->inflight.seq[i] != c->write_seq[i]) continue;  /* slot reused */
+            if (c->pending_writes[i].count < 0x7F) c->pending_writes[i].count++;
         }
+        ESP_LOGW(TAG, "Response 0x%02X read-back error, %s",
+                 conf->data[2], c->inflight.slots ? "retrying writes" : "no writes affected");
     }
+    c->inflight.packet_type = 0;
+    c->inflight.slots = 0;
 }
 
 /*
@@ -135,83 +237,37 @@ static uint8_t encode_mode(p1p2_system_mode_t mode)
  *   20 bytes total (header + 17-byte payload + CRC)
  *   Port of P1P2Monitor.ino lines 2441-2469
  *
+ * The byte mapping from request to response for each model lives in
+ * p1p2_fseries_codec.cpp.
+ *
  * Returns response length (excluding CRC, which bus layer adds), or 0 if no response needed.
  */
-uint8_t p1p2_fseries_build_response_38(const uint8_t *rb, uint8_t rb_len,
-                                        uint8_t *wb, uint8_t wb_max)
+uint8_t p1p2_fseries_build_response_38(p1p2_fseries_ctrl_t *c, const uint8_t *rb,
+                                       uint8_t rb_len, uint8_t *wb, uint8_t wb_max)
 {
-    if (rb_len < 18) return 0; /* minimum packet size for 0x38 */
-
-    uint8_t nwrite;
+    /* Payload from the compile-time layout; checks rb_len/wb_max too */
+    uint8_t nwrite = p1p2_fseries_encode_response(PKT_TYPE_CTRL_38, c->model_id,
+                                                  rb, rb_len, wb, wb_max);
+    if (nwrite == 0) return 0; /* model not supported for 0x38, or short packet */
 
     /* Response header: src=aux controller, dst=indoor, type=same */
     wb[0] = P1P2_ADDR_AUX_CTRL;
     wb[1] = rb[0]; /* respond to sender */
     wb[2] = rb[2]; /* same packet type */
 
-    if (model_id == F_MODEL_BCL) {
-        /* ---- Model BCL (FDY): 15-byte payload ---- */
-        nwrite = 18; /* 3 header + 15 payload (CRC added by bus layer) */
-        if (wb_max < nwrite) return 0;
-
-        /* Clear bytes 13-15 */
-        wb[13] = 0x00;
-        wb[14] = 0x00;
-        wb[15] = 0x00;
-
-        wb[3]  = rb[3] & 0x01;           /* Target status (power) */
-        wb[4]  = (rb[5] & 0x07) | 0x60;  /* Target operating mode */
-        wb[5]  = rb[7];                   /* Target temperature cooling */
-        wb[6]  = 0x00;                    /* Clear change flag */
-        wb[7]  = (rb[9] & 0x60) | 0x11;  /* Target fan speed cooling */
-        wb[8]  = 0x00;                    /* Clear change flag */
-        wb[9]  = rb[11];                  /* Target temperature heating */
-        wb[10] = 0x00;                    /* Clear change flag */
-        wb[11] = (rb[13] & 0x60) | 0x11; /* Target fan speed heating */
-        wb[12] = rb[14] & 0x7F;          /* Clear change flag */
-        wb[16] = rb[18];                  /* Target fan mode */
-        wb[17] = 0x00;                    /* Change flag */
-
-        /* Apply any pending writes from Matter commands */
-        apply_pending_writes(PKT_TYPE_CTRL_38, &wb[3], nwrite - 3);
-
-    } else if (model_id == F_MODEL_P) {
-        /* ---- Model P (FXMQ): 17-byte payload ---- */
-        nwrite = 20;
-        if (wb_max < nwrite) return 0;
-
-        wb[3]  = rb[3] & 0x01;
-        wb[4]  = rb[5];
-        wb[5]  = rb[7];
-        wb[6]  = 0x00;
-        wb[7]  = rb[9];
-        wb[8]  = 0x00;
-        wb[9]  = rb[11];
-        wb[10] = 0x00;
-        wb[11] = rb[13];
-        wb[12] = rb[14];
-        wb[13] = 0x00;
-        wb[14] = 0x00;
-        wb[15] = 0x00;
-        wb[16] = rb[18];
-        wb[17] = 0x00;
-        wb[18] = 0;                       /* puzzle: initially 0, then 2, then 1 */
-        wb[19] = 0x00;
-
-        /* FXMQ special: if turning on, set bit in wb[16] */
-        apply_pending_writes(PKT_TYPE_CTRL_38, &wb[3], nwrite - 3);
+    /* Apply any pending writes from Matter commands */
+    apply_pending_writes(c, PKT_TYPE_CTRL_38, &wb[3], nwrite - 3);
 
+    if (c->model_id == F_MODEL_P) {
         /* FXMQ: if power is being turned on via pending write, set mode flag */
-        for (int i = 0; i < MAX_PENDING_WRITES; i++) {
-            if (pending_writes[i].count && pending_writes[i].packet_type == PKT_TYPE_CTRL_38) {
-                if ((pending_writes[i].payload_offset == 0) &&
-                    (wb[3] == 0x00) && (pending_writes[i].value)) {
+        for (int i = 0; i < P1P2_MAX_PENDING_WRITES; i++) {
+            if (c->pending_writes[i].count && c->pending_writes[i].packet_type == PKT_TYPE_CTRL_38) {
+                if ((c->pending_writes[i].payload_offset == 0) &&
+                    (wb[3] == 0x00) && (c->pending_writes[i].value)) {
                     wb[16] |= 0x20;
                 }
             }
         }
-    } else {
-        return 0; /* model not supported for 0x38 */
     }
 
     return nwrite;
@@ -224,38 +280,19 @@ uint8_t p1p2_fseries_build_response_38(const uint8_t *rb, uint8_t rb_len,
  *   22 bytes total (header + 19-byte payload + CRC)
  *   Port of P1P2Monitor.ino lines 2514-2540
  */
-uint8_t p1p2_fseries_build_response_3b(const uint8_t *rb, uint8_t rb_len,
-                                        uint8_t *wb, uint8_t wb_max)
+uint8_t p1p2_fseries_build_response_3b(p1p2_fseries_ctrl_t *c, const uint8_t *rb,
+                                       uint8_t rb_len, uint8_t *wb, uint8_t wb_max)
 {
-    if (model_id != F_MODEL_M) return 0;
-    if (rb_len < 22) return 0;
-
-    uint8_t nwrite = 22;
-    if (wb_max < nwrite) return 0;
+    uint8_t nwrite = p1p2_fseries_encode_response(PKT_TYPE_CTRL_3B, c->model_id,
+                                                  rb, rb_len, wb, wb_max);
+    if (nwrite == 0) return 0;
 
     wb[0] = P1P2_ADDR_AUX_CTRL;
     wb[1] = rb[0];
     wb[2] = rb[2];
 
-    /* Clear bytes 13-18 */
-    for (int w = 13; w <= 18; w++) wb[w] = 0x00;
-
-    wb[3]  = rb[3] & 0x01;           /* Target status */
-    wb[4]  = (rb[5] & 0x07) | 0x60;  /* Target operating mode */
-    wb[5]  = rb[7];                   /* Target temperature cooling */
-    wb[6]  = 0x00;                    /* Clear change flag */
-    wb[7]  = (rb[9] & 0x60) | 0x11;  /* Target fan speed cooling */
-    wb[8]  = 0x00;                    /* Clear change flag */
-    wb[9]  = rb[11];                  /* Target temperature heating */
-    wb[10] = 0x00;                    /* Clear change flag */
-    wb[11] = (rb[13] & 0x60) | 0x11; /* Target fan speed heating */
-    wb[12] = rb[14] & 0x7F;          /* Clear change flag */
-    wb[19] = rb[20];                  /* Active HVAC zones */
-    wb[20] = rb[21] & 0x03;          /* Target fan mode */
-    wb[21] = 0x00;                    /* Change flag */
-
     /* Apply pending writes */
-    apply_pending_writes(PKT_TYPE_CTRL_3B, &wb[3], nwrite - 3);
+    apply_pending_writes(c, PKT_TYPE_CTRL_3B, &wb[3], nwrite - 3);
 
     return nwrite;
 }
@@ -263,14 +300,14 @@ uint8_t p1p2_fseries_build_response_3b(const uint8_t *rb, uint8_t rb_len,
 /*
  * Build response to 0x39 packet (filter warning / status).
  */
-uint8_t p1p2_fseries_build_response_39(const uint8_t *rb, uint8_t rb_len,
-                                        uint8_t *wb, uint8_t wb_max)
+uint8_t p1p2_fseries_build_response_39(p1p2_fseries_ctrl_t *c, const uint8_t *rb,
+                                       uint8_t rb_len, uint8_t *wb, uint8_t wb_max)
 {
     wb[0] = P1P2_ADDR_AUX_CTRL;
     wb[1] = rb[0];
     wb[2] = rb[2];
 
-    if (model_id == F_MODEL_BCL) {
+    if (c->model_id == F_MODEL_BCL) {
         /* 4-byte payload */
         uint8_t nwrite = 7;
         if (wb_max < nwrite) return 0;
@@ -279,7 +316,7 @@ uint8_t p1p2_fseries_build_response_39(const uint8_t *rb, uint8_t rb_len,
         wb[5] = rb[11];
         wb[6] = rb[12];
         return nwrite;
-    } else if (model_id == F_MODEL_P) {
+    } else if (c->model_id == F_MODEL_P) {
         /* 5-byte all-zero payload */
         uint8_t nwrite = 8;
         if (wb_max < nwrite) return 0;
@@ -293,10 +330,10 @@ uint8_t p1p2_fseries_build_response_39(const uint8_t *rb, uint8_t rb_len,
 /*
  * Build response to 0x3A packet (FXMQ only).
  */
-uint8_t p1p2_fseries_build_response_3a(const uint8_t *rb, uint8_t rb_len,
-                                        uint8_t *wb, uint8_t wb_max)
+uint8_t p1p2_fseries_build_response_3a(p1p2_fseries_ctrl_t *c, const uint8_t *rb,
+                                       uint8_t rb_len, uint8_t *wb, uint8_t wb_max)
 {
-    if (model_id != F_MODEL_P) return 0;
+    if (c->model_id != F_MODEL_P) return 0;
 
     uint8_t nwrite = 11; /* 8-byte all-zero payload */
     if (wb_max < nwrite) return 0;
@@ -312,10 +349,10 @@ uint8_t p1p2_fseries_build_response_3a(const uint8_t *rb, uint8_t rb_len,
 /*
  * Build response to 0x3C packet (FDYQ filter, model M only).
  */
-uint8_t p1p2_fseries_build_response_3c(const uint8_t *rb, uint8_t rb_len,
-                                        uint8_t *wb, uint8_t wb_max)
+uint8_t p1p2_fseries_build_response_3c(p1p2_fseries_ctrl_t *c, const uint8_t *rb,
+                                       uint8_t rb_len, uint8_t *wb, uint8_t wb_max)
 {
-    if (model_id != F_MODEL_M) return 0;
+    if (c->model_id != F_MODEL_M) return 0;
 
     uint8_t nwrite = 5; /* 2-byte zero payload */
     if (wb_max < nwrite) return 0;
@@ -332,8 +369,8 @@ uint8_t p1p2_fseries_build_response_3c(const uint8_t *rb, uint8_t rb_len,
 /*
  * Build response for empty-payload reply (0x35, 0x36, 0x37).
  */
-uint8_t p1p2_fseries_build_response_empty(const uint8_t *rb, uint8_t rb_len,
-                                           uint8_t *wb, uint8_t wb_max)
+uint8_t p1p2_fseries_build_response_empty(p1p2_fseries_ctrl_t *c, const uint8_t *rb,
+                                          uint8_t rb_len, uint8_t *wb, uint8_t wb_max)
 {
     uint8_t nwrite = 3; /* header only, CRC added by bus layer */
     if (wb_max < nwrite) return 0;
@@ -348,12 +385,15 @@ uint8_t p1p2_fseries_build_response_empty(const uint8_t *rb, uint8_t rb_len,
 /*
  * Translate a Matter control command into a pending F-series write.
  */
-esp_err_t p1p2_fseries_apply_command(const p1p2_control_cmd_t *cmd)
+esp_err_t p1p2_fseries_apply_command(p1p2_fseries_ctrl_t *c, const p1p2_control_cmd_t *cmd)
 {
     uint8_t pkt_type;
 
     /* Determine which packet type to target based on model */
-    if (model_id == F_MODEL_M) {
+    if (c->model_id == F_MODEL_AUTO) {
+        ESP_LOGW(TAG, "Model not detected yet, command dropped");
+        return ESP_ERR_INVALID_STATE;
+    } else if (c->model_id == F_MODEL_M) {
         pkt_type = PKT_TYPE_CTRL_3B;
     } else {
         pkt_type = PKT_TYPE_CTRL_38;
@@ -361,46 +401,46 @@ esp_err_t p1p2_fseries_apply_command(const p1p2_control_cmd_t *cmd)
 
     switch (cmd->type) {
     case P1P2_CMD_SET_POWER:
-        return p1p2_fseries_queue_write(pkt_type, F38_RSP_STATUS,
+        return p1p2_fseries_queue_write(c, pkt_type, F38_RSP_STATUS,
                                         cmd->value ? 0x01 : 0x00, 0x00, 3);
 
     case P1P2_CMD_SET_MODE:
-        return p1p2_fseries_queue_write(pkt_type, F38_RSP_MODE,
+        return p1p2_fseries_queue_write(c, pkt_type, F38_RSP_MODE,
                                         encode_mode((p1p2_system_mode_t)cmd->value),
                                         0x00, 3);
 
     case P1P2_CMD_SET_TEMP_COOL:
         /* value is temperature × 10, F-series uses integer °C */
-        return p1p2_fseries_queue_write(pkt_type, F38_RSP_COOL_TEMP,
+        return p1p2_fseries_queue_write(c, pkt_type, F38_RSP_COOL_TEMP,
                                         (uint8_t)(cmd->value / 10), 0x00, 3);
 
     case P1P2_CMD_SET_TEMP_HEAT:
-        return p1p2_fseries_queue_write(pkt_type, F38_RSP_HEAT_TEMP,
+        return p1p2_fseries_queue_write(c, pkt_type, F38_RSP_HEAT_TEMP,
                                         (uint8_t)(cmd->value / 10), 0x00, 3);
 
     case P1P2_CMD_SET_FAN_COOL:
-        return p1p2_fseries_queue_write(pkt_type, F38_RSP_COOL_FAN,
+        return p1p2_fseries_queue_write(c, pkt_type, F38_RSP_COOL_FAN,
                                         encode_fan_speed((p1p2_fan_mode_t)cmd->value),
                                         0x00, 3);
 
     case P1P2_CMD_SET_FAN_HEAT:
-        return p1p2_fseries_queue_write(pkt_type, F38_RSP_HEAT_FAN,
+        return p1p2_fseries_queue_write(c, pkt_type, F38_RSP_HEAT_FAN,
                                         encode_fan_speed((p1p2_fan_mode_t)cmd->value),
                                         0x00, 3);
 
     case P1P2_CMD_SET_DHW_POWER:
-        return p1p2_fseries_queue_write(pkt_type, F38_RSP_DHW_POWER,
+        return p1p2_fseries_queue_write(c, pkt_type, F38_RSP_DHW_POWER,
                                         cmd->value ? 0x01 : 0x00, 0x00, 3);
 
     case P1P2_CMD_SET_DHW_TEMP:
         /* value is temperature × 10, F-series uses integer °C */
-        return p1p2_fseries_queue_write(pkt_type, F38_RSP_DHW_TEMP,
+        return p1p2_fseries_queue_write(c, pkt_type, F38_RSP_DHW_TEMP,
                                         (uint8_t)(cmd->value / 10), 0x00, 3);
 
     case P1P2_CMD_SET_ZONES:
-        if (model_id == F_MODEL_M) {
+        if (c->model_id == F_MODEL_M) {
             /* Zones: offset 16 in 0x3B response payload */
-            return p1p2_fseries_queue_write(PKT_TYPE_CTRL_3B, 16,
+            return p1p2_fseries_queue_write(c, PKT_TYPE_CTRL_3B, 16,
                                             (uint8_t)cmd->value, 0x00, 3);
         }
         return ESP_ERR_NOT_SUPPORTED;
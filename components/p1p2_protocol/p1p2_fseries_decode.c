@@ -6,18 +6,22 @@
  *
  * Instead of converting to MQTT topic/value strings, this decoder updates
  * a p1p2_hvac_state_t structure that is read by the Matter layer.
+ * Field layouts come from the parameter tables (p1p2_param_tables.h); the
+ * decoder itself only knows how to convert each p1p2_param_type_t. The
+ * E-series tables run on the same engine: the family is chosen once at
+ * init, so decoding a packet never checks it.
  *
  * Original: Copyright (c) 2019-2024 Arnold Niessen — CC BY-NC-ND 4.0
  * ESP32-C6 port: 2026
  */
 
 #include <string.h>
-#include <stdio.h>
 #include "esp_log.h"
 #include "esp_timer.h"
 #include "p1p2_protocol.h"
 #include "p1p2_fseries.h"
 #include "p1p2_param_tables.h"
+#include "p1p2_fixed.h"
 
 static const char *TAG = "p1p2_decode";
 
@@ -63,311 +67,345 @@ void p1p2_log_packet(const p1p2_packet_t *pkt, const char *prefix)
 {
     if (pkt->length == 0) return;
 
-    char buf[P1P2_MAX_PACKET_SIZE * 3 + 16];
+    static const char hex[] = "0123456789ABCDEF";
+    char buf[P1P2_MAX_PACKET_SIZE * 3 + 1];
     int pos = 0;
 
-    for (int i = 0; i < pkt->length && pos < (int)sizeof(buf) - 4; i++) {
-        pos += snprintf(&buf[pos], sizeof(buf) - pos, "%02X ", pkt->data[i]);
+    for (int i = 0; i < pkt->length && i < P1P2_MAX_PACKET_SIZE; i++) {
+        buf[pos++] = hex[pkt->data[i] >> 4];
+        buf[pos++] = hex[pkt->data[i] & 0x0F];
+        buf[pos++] = ' ';
     }
+    buf[pos] = '\0';
 
     ESP_LOGI(TAG, "%s: %s[%s]", prefix, buf, pkt->has_error ? "ERR" : "OK");
 }
 
 /*
- * Decode a single F-series packet and update HVAC state.
- * Sets bits in state->changed for any field that actually changes value.
- *
- * Packet layout:
- *   data[0] = source address
- *   data[1] = destination address
- *   data[2] = packet type
- *   data[3..length-2] = payload
- *   data[length-1] = CRC
+ * Active family tables, selected by p1p2_decode_select_family().
+ * Packets from the auxiliary address are keyed apart from the requests
+ * (KEY_AUX): E-series replies have their own layouts, while the
+ * F-series tables describe only the main controller's side, so an F-series
+ * reply (0x40 -> 0x00) is not decoded or stored with the request layout.
  */
-void p1p2_fseries_decode_packet(const p1p2_packet_t *pkt, p1p2_hvac_state_t *state)
+typedef struct {
+    const p1p2_param_def_t  *params;
+    uint16_t                 param_count;
+    const p1p2_packet_def_t *packets;
+    uint16_t                 packet_count;
+} family_tables_t;
+
+#define KEY_AUX 0x100
+
+static const family_tables_t families[] = {
+    [P1P2_FAMILY_F] = { f_series_params, F_SERIES_PARAM_COUNT,
+                        f_series_packets, F_SERIES_PACKET_COUNT },
+    [P1P2_FAMILY_E] = { e_series_params, E_SERIES_PARAM_COUNT,
+                        e_series_packets, E_SERIES_PACKET_COUNT },
+};
+
+static const family_tables_t *active = &families[P1P2_FAMILY_F];
+
+/*
+ * Packet index into the active parameter table, built once by
+ * p1p2_fseries_decode_init(). field_order[] holds the table indices
+ * grouped by packet key (stable, so table order is kept within a key);
+ * type_index[key] is the slice of field_order[] for that key.
+ */
+typedef struct {
+    uint16_t first;                 /* first slot in field_order[] */
+    uint16_t count;                 /* number of fields of this type */
+    uint8_t  min_payload;
+    uint8_t  flags;                 /* PKT_DEF_* */
+    bool     known;                 /* listed in the tables */
+} type_slice_t;
+
+static type_slice_t type_index[P1P2_PACKET_KEYS];
+static uint16_t     field_order[P1P2_PARAM_MAX];
+static bool         index_built = false;
+
+/*
+ * Index key of a received packet: its type, plus 256 for a reply from the
+ * auxiliary address.
+ */
+uint16_t p1p2_fseries_packet_key(const p1p2_packet_t *pkt)
 {
-    if (pkt->length < 4) return; /* minimum: src + dst + type + CRC */
+    return pkt->data[2] | (pkt->data[0] == P1P2_ADDR_AUX_CTRL ? KEY_AUX : 0);
+}
+
+/*
+ * Index key of the packets a parameter is found in.
+ */
+uint16_t p1p2_fseries_param_key(const p1p2_param_def_t *p)
+{
+    return p->packet_type | ((p->flags & PARAM_F_AUX_SRC) ? KEY_AUX : 0);
+}
+
+/*
+ * Build the packet index. Called from p1p2_protocol_init(); decode
+ * also builds it on first use so it can be called standalone.
+ */
+void p1p2_fseries_decode_init(void)
+{
+    static uint16_t fill[P1P2_PACKET_KEYS];
+
+    if (index_built) return;
+
+    memset(type_index, 0, sizeof(type_index));
+    for (size_t i = 0; i < active->param_count; i++) {
+        type_slice_t *ts = &type_index[p1p2_fseries_param_key(&active->params[i])];
+        ts->count++;
+        ts->known = true;
+    }
+
+    /* Counting sort: prefix sums give each key's first slot */
+    uint16_t next = 0;
+    for (int k = 0; k < P1P2_PACKET_KEYS; k++) {
+        type_index[k].first = next;
+        next += type_index[k].count;
+    }
+    memset(fill, 0, sizeof(fill));
+    for (size_t i = 0; i < active->param_count; i++) {
+        uint16_t k = p1p2_fseries_param_key(&active->params[i]);
+        field_order[type_index[k].first + fill[k]++] = (uint16_t)i;
+    }
+
+    for (size_t i = 0; i < active->packet_count; i++) {
+        const p1p2_packet_def_t *d = &active->packets[i];
+        uint16_t k = d->packet_type | ((d->flags & PKT_DEF_AUX_SRC) ? KEY_AUX : 0);
+        type_index[k].min_payload = d->min_payload;
+        type_index[k].flags = d->flags;
+        type_index[k].known = true;
+    }
+
+    index_built = true;
+    ESP_LOGD(TAG, "Param index: %u fields", (unsigned)active->param_count);
+}
+
+/*
+ * Select the protocol family (P1P2_FAMILY_*) whose tables the decoder and
+ * the parameter store use, and rebuild the index. Called once at init,
+ * before the payload store is initialized.
+ */
+void p1p2_decode_select_family(int family)
+{
+    if (family != P1P2_FAMILY_E) family = P1P2_FAMILY_F;
+    active = &families[family];
+    index_built = false;
+    p1p2_fseries_decode_init();
+}
+
+/*
+ * Whether the active tables describe a received packet's type (its key).
+ */
+bool p1p2_fseries_packet_known(const p1p2_packet_t *pkt)
+{
+    if (pkt->length < 3) return false;
+    if (!index_built) p1p2_fseries_decode_init();
+    return type_index[p1p2_fseries_packet_key(pkt)].known;
+}
+
+/*
+ * Parameter definition by id (index into the active table), or NULL.
+ */
+const p1p2_param_def_t *p1p2_fseries_param_def(uint16_t id)
+{
+    return id < active->param_count ? &active->params[id] : NULL;
+}
+
+/*
+ * Parameter ids of one packet key, in table order. Returns the count and
+ * sets *ids to the slice (valid until the next p1p2_fseries_decode_init).
+ */
+uint16_t p1p2_fseries_type_params(uint16_t key, const uint16_t **ids)
+{
+    if (!index_built) p1p2_fseries_decode_init();
+    *ids = &field_order[type_index[key].first];
+    return type_index[key].count;
+}
+
+/*
+ * Number of significant bits of a parameter's compact raw value.
+ */
+uint8_t p1p2_fseries_param_width(const p1p2_param_def_t *p)
+{
+    switch (p->value_type) {
+    case PARAM_TYPE_FLAG8:  return 1;
+    case PARAM_TYPE_FAN:    return 2;   /* speed bits 6-5 */
+    case PARAM_TYPE_MODE:   return 3;   /* mode bits 2-0 */
+    case PARAM_TYPE_U16:
+    case PARAM_TYPE_S16:
+    case PARAM_TYPE_U16_LE:
+    case PARAM_TYPE_TEMP16:
+    case PARAM_TYPE_F88:    return 16;
+    case PARAM_TYPE_U32:    return 32;
+    default:                return 8;
+    }
+}
+
+/*
+ * Extract a field's compact raw value from its bytes (b points at
+ * payload_offset): the bits that matter for its type, unsigned, no scaling.
+ * Two payloads decode to the same value iff their compact raw values match.
+ */
+uint32_t p1p2_fseries_param_extract(const p1p2_param_def_t *p, const uint8_t *b)
+{
+    switch (p->value_type) {
+    case PARAM_TYPE_U16:
+    case PARAM_TYPE_S16:
+    case PARAM_TYPE_TEMP16:
+    case PARAM_TYPE_F88:    return (uint32_t)((b[0] << 8) | b[1]);
+    case PARAM_TYPE_U16_LE: return (uint32_t)((b[1] << 8) | b[0]);
+    case PARAM_TYPE_U32:
+        return ((uint32_t)b[0] << 24) | ((uint32_t)b[1] << 16) |
+               ((uint32_t)b[2] << 8) | b[3];
+    case PARAM_TYPE_FLAG8:  return (b[0] & (p->bit_mask ? p->bit_mask : 0xFF)) != 0;
+    case PARAM_TYPE_FAN:    return (b[0] >> 5) & 0x03;
+    case PARAM_TYPE_MODE:   return b[0] & 0x07;
+    default:                return b[0];
+    }
+}
+
+/*
+ * Convert a compact raw value according to the parameter's value type,
+ * then apply scale/offset. Returns the value in the state member's units.
+ */
+int64_t p1p2_fseries_param_convert(const p1p2_param_def_t *p, uint32_t raw)
+{
+    int64_t v;
+
+    switch (p->value_type) {
+    case PARAM_TYPE_S8:     v = (int8_t)raw; break;
+    case PARAM_TYPE_S16:
+    case PARAM_TYPE_TEMP16: v = (int16_t)raw; break;
+    case PARAM_TYPE_TEMP8:  v = (int64_t)raw * 10; break;
+    case PARAM_TYPE_F88:    v = p1p2_scale_round((int16_t)raw, 10, 256); break;  /* °C × 256 to × 10 */
+    case PARAM_TYPE_FAN:    v = decode_fan_speed((uint8_t)(raw << 5)); break;
+    case PARAM_TYPE_MODE:   v = decode_mode((uint8_t)raw); break;
+    default:                v = raw; break;
+    }
+
+    if (p->scale_num != 1 || p->scale_den != 1) {
+        v = p1p2_scale_round(v, p->scale_num, p->scale_den);
+    }
+    return v + p->offset;
+}
+
+/*
+ * Extract and convert a field (b points at payload_offset).
+ */
+int64_t p1p2_fseries_param_value(const p1p2_param_def_t *p, const uint8_t *b)
+{
+    return p1p2_fseries_param_convert(p, p1p2_fseries_param_extract(p, b));
+}
+
+/*
+ * Store a value into the bound state member. Returns true if it changed.
+ * Members are compared as raw integers of their size, so signed, enum
+ * and bool members all work.
+ */
+static bool param_store(const p1p2_param_def_t *p, p1p2_hvac_state_t *state, int64_t v)
+{
+    uint8_t *dst = (uint8_t *)state + p->state_offset;
+
+    switch (p->state_size) {
+    case 1: {
+        uint8_t n = (uint8_t)v;
+        if (*dst == n) return false;
+        *dst = n;
+        return true;
+    }
+    case 2: {
+        uint16_t n = (uint16_t)v, o;
+        memcpy(&o, dst, sizeof(o));
+        if (o == n) return false;
+        memcpy(dst, &n, sizeof(n));
+        return true;
+    }
+    case 4: {
+        uint32_t n = (uint32_t)v, o;
+        memcpy(&o, dst, sizeof(o));
+        if (o == n) return false;
+        memcpy(dst, &n, sizeof(n));
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+/*
+ * Decode a packet into HVAC state, optionally against the previous
+ * payload of the same (src, dst, type). With prev set (same length as
+ * this payload), fields whose bytes are identical in prev are skipped; the
+ * caller must only do so while the state still holds what prev decoded to.
+ * Returns the number of state members that changed value.
+ */
+uint8_t p1p2_fseries_decode_fields(const p1p2_packet_t *pkt, p1p2_hvac_state_t *state,
+                                   const uint8_t *prev)
+{
+    if (pkt->length < 4) return 0; /* minimum: src + dst + type + CRC */
+    if (!index_built) p1p2_fseries_decode_init();
 
-    uint8_t src  = pkt->data[0];
-    uint8_t dst  = pkt->data[1];
     uint8_t type = pkt->data[2];
     const uint8_t *payload = &pkt->data[3];
     uint8_t payload_len = pkt->length - 4; /* exclude src, dst, type, CRC */
+    const type_slice_t *ts = &type_index[p1p2_fseries_packet_key(pkt)];
+    uint8_t nchanged = 0;
 
-    (void)src;
-    (void)dst;
-
-    switch (type) {
-    case PKT_TYPE_STATUS_10:
-        /*
-         * Status packet 0x10: Power, mode, target temperatures, fan speeds.
-         * This is the primary status packet from the indoor unit.
-         *
-         * Payload layout (varies by model, typical for BCL/M):
-         *   [0] status flags (bit 0 = power on)
-         *   [2] operating mode
-         *   [4] target cooling temperature
-         *   [6] fan speed cooling
-         *   [8] target heating temperature
-         *   [10] fan speed heating
-         */
-        if (payload_len >= 1) {
-            bool pwr = (payload[0] & 0x01);
-            if (pwr != state->power) state->changed |= CHANGED_POWER;
-            state->power = pwr;
-        }
-        if (payload_len >= 3) {
-            p1p2_system_mode_t m = decode_mode(payload[2]);
-            if (m != state->mode) state->changed |= CHANGED_MODE;
-            state->mode = m;
-        }
-        if (payload_len >= 5) {
-            int16_t tc = payload[4] * 10;
-            if (tc != state->target_temp_cool) state->changed |= CHANGED_TEMP_COOL;
-            state->target_temp_cool = tc;
-        }
-        if (payload_len >= 7) {
-            p1p2_fan_mode_t fc = decode_fan_speed(payload[6]);
-            if (fc != state->fan_mode_cool) state->changed |= CHANGED_FAN_COOL;
-            state->fan_mode_cool = fc;
-        }
-        if (payload_len >= 9) {
-            int16_t th = payload[8] * 10;
-            if (th != state->target_temp_heat) state->changed |= CHANGED_TEMP_HEAT;
-            state->target_temp_heat = th;
-        }
-        if (payload_len >= 11) {
-            p1p2_fan_mode_t fh = decode_fan_speed(payload[10]);
-            if (fh != state->fan_mode_heat) state->changed |= CHANGED_FAN_HEAT;
-            state->fan_mode_heat = fh;
-        }
+    if (!ts->known) {
+        /* Other packet types — log at debug level */
+        ESP_LOGD(TAG, "Unhandled packet type 0x%02X (len=%d)", type, pkt->length);
+    } else if (payload_len >= ts->min_payload) {
+        bool prev_applied = false;
 
-        /* Determine running state from mode and power */
-        if (!state->power) {
-            state->running = P1P2_RUNNING_IDLE;
-        } else if (state->mode == P1P2_MODE_HEAT) {
-            state->running = P1P2_RUNNING_HEATING;
-        } else if (state->mode == P1P2_MODE_COOL) {
-            state->running = P1P2_RUNNING_COOLING;
-        }
+        for (uint16_t i = ts->first; i < ts->first + ts->count; i++) {
+            const p1p2_param_def_t *p = &active->params[field_order[i]];
 
-        state->data_valid = true;
-        break;
-
-    case PKT_TYPE_STATUS_11:
-        /*
-         * Temperature readings packet 0x11.
-         *   [0] room/return temperature
-         *   [2] outdoor temperature (signed)
-         */
-        if (payload_len >= 1) {
-            int16_t rt = payload[0] * 10;
-            if (rt != state->room_temp) state->changed |= CHANGED_ROOM_TEMP;
-            state->room_temp = rt;
-        }
-        if (payload_len >= 3) {
-            int16_t ot = (int8_t)payload[2] * 10;
-            if (ot != state->outdoor_temp) state->changed |= CHANGED_OUTDOOR_TEMP;
-            state->outdoor_temp = ot;
-        }
-        break;
-
-    case PKT_TYPE_DATETIME_12:
-        /* Date/time packet — we don't need this for Matter but could use for diagnostics */
-        break;
-
-    case PKT_TYPE_STATUS_13:
-        /*
-         * Extended status packet 0x13.
-         *   [0] Error sub-code or status flags
-         *   [1-2] Extended mode/status bits
-         * We extract the error sub-code into error_code if non-zero.
-         */
-        if (payload_len >= 1) {
-            uint16_t ec = payload[0];
-            if (payload_len >= 3) {
-                ec = (payload[1] << 8) | payload[2];
+            if ((p->flags & PARAM_F_ALT) && prev_applied) continue;
+            prev_applied = (p->payload_offset + p->byte_length <= payload_len);
+            if (!prev_applied || p->state_size == 0) continue;
+            if (prev && memcmp(&prev[p->payload_offset], &payload[p->payload_offset],
+                               p->byte_length) == 0) continue;
+
+            if (param_store(p, state, p1p2_fseries_param_value(p, &payload[p->payload_offset]))) {
+                state->changed |= p->changed_bit;
+                nchanged++;
             }
-            if (ec != state->error_code) state->changed |= CHANGED_ERROR_CODE;
-            state->error_code = ec;
-        }
-        break;
-
-    case PKT_TYPE_STATUS_14:
-        /*
-         * Extended status / compressor data.
-         *   [0-1] compressor frequency (16-bit)
-         *   [2-3] flow rate (16-bit, L/min × 10)
-         */
-        if (payload_len >= 2) {
-            uint16_t cf = (payload[0] << 8) | payload[1];
-            if (cf != state->compressor_freq) state->changed |= CHANGED_COMPRESSOR;
-            state->compressor_freq = cf;
-        }
-        if (payload_len >= 4) {
-            uint16_t fr = (payload[2] << 8) | payload[3];
-            if (fr != state->flow_rate) state->changed |= CHANGED_FLOW_RATE;
-            state->flow_rate = fr;
-        }
-        break;
-
-    case PKT_TYPE_STATUS_15:
-        /*
-         * DHW and water temperatures packet 0x15.
-         *   [0] DHW active flag
-         *   [1] DHW target temperature
-         *   [2] DHW actual temperature
-         *   [3-4] Leaving water temperature (signed, big-endian)
-         *   [5-6] Return water temperature (signed, big-endian)
-         */
-        if (payload_len >= 1) {
-            bool dhw = (payload[0] & 0x01);
-            if (dhw != state->dhw_active) state->changed |= CHANGED_DHW;
-            state->dhw_active = dhw;
-        }
-        if (payload_len >= 2) {
-            int16_t dt = payload[1] * 10;
-            if (dt != state->dhw_target) state->changed |= CHANGED_DHW;
-            state->dhw_target = dt;
         }
-        if (payload_len >= 3) {
-            int16_t da = payload[2] * 10;
-            if (da != state->dhw_temp) state->changed |= CHANGED_DHW;
-            state->dhw_temp = da;
-        }
-        if (payload_len >= 5) {
-            int16_t lwt = (int16_t)((payload[3] << 8) | payload[4]);
-            if (lwt != state->leaving_water_temp) state->changed |= CHANGED_WATER_TEMPS;
-            state->leaving_water_temp = lwt;
-        }
-        if (payload_len >= 7) {
-            int16_t rwt = (int16_t)((payload[5] << 8) | payload[6]);
-            if (rwt != state->return_water_temp) state->changed |= CHANGED_WATER_TEMPS;
-            state->return_water_temp = rwt;
-        }
-        break;
-
-    case PKT_TYPE_STATUS_16:
-        /*
-         * Additional status packet 0x16.
-         *   [0-1] Error code (16-bit)
-         */
-        if (payload_len >= 2) {
-            uint16_t ec = (payload[0] << 8) | payload[1];
-            if (ec != state->error_code) state->changed |= CHANGED_ERROR_CODE;
-            state->error_code = ec;
-        }
-        break;
-
-    case PKT_TYPE_CTRL_38:
-        /*
-         * 0x38 control exchange (request from indoor unit).
-         * This packet is what we must respond to as auxiliary controller.
-         * We also decode it to update our state with the "current request" values.
-         */
-        if (payload_len >= 1) {
-            bool pwr = (payload[0] & 0x01);
-            if (pwr != state->power) state->changed |= CHANGED_POWER;
-            state->power = pwr;
-        }
-        if (payload_len >= 3) {
-            p1p2_system_mode_t m = decode_mode(payload[2]);
-            if (m != state->mode) state->changed |= CHANGED_MODE;
-            state->mode = m;
-        }
-        if (payload_len >= 5) {
-            int16_t tc = payload[4] * 10;
-            if (tc != state->target_temp_cool) state->changed |= CHANGED_TEMP_COOL;
-            state->target_temp_cool = tc;
-        }
-        if (payload_len >= 7) {
-            p1p2_fan_mode_t fc = decode_fan_speed(payload[6]);
-            if (fc != state->fan_mode_cool) state->changed |= CHANGED_FAN_COOL;
-            state->fan_mode_cool = fc;
-        }
-        if (payload_len >= 9) {
-            int16_t th = payload[8] * 10;
-            if (th != state->target_temp_heat) state->changed |= CHANGED_TEMP_HEAT;
-            state->target_temp_heat = th;
-        }
-        if (payload_len >= 11) {
-            p1p2_fan_mode_t fh = decode_fan_speed(payload[10]);
-            if (fh != state->fan_mode_heat) state->changed |= CHANGED_FAN_HEAT;
-            state->fan_mode_heat = fh;
-        }
-        state->data_valid = true;
-        break;
-
-    case PKT_TYPE_CTRL_3B:
-        /*
-         * 0x3B control exchange (FDYQ model M variant).
-         * Similar to 0x38 but with zone support.
-         */
-        if (payload_len >= 1) {
-            bool pwr = (payload[0] & 0x01);
-            if (pwr != state->power) state->changed |= CHANGED_POWER;
-            state->power = pwr;
-        }
-        if (payload_len >= 3) {
-            p1p2_system_mode_t m = decode_mode(payload[2]);
-            if (m != state->mode) state->changed |= CHANGED_MODE;
-            state->mode = m;
-        }
-        if (payload_len >= 5) {
-            int16_t tc = payload[4] * 10;
-            if (tc != state->target_temp_cool) state->changed |= CHANGED_TEMP_COOL;
-            state->target_temp_cool = tc;
-        }
-        if (payload_len >= 7) {
-            p1p2_fan_mode_t fc = decode_fan_speed(payload[6]);
-            if (fc != state->fan_mode_cool) state->changed |= CHANGED_FAN_COOL;
-            state->fan_mode_cool = fc;
-        }
-        if (payload_len >= 9) {
-            int16_t th = payload[8] * 10;
-            if (th != state->target_temp_heat) state->changed |= CHANGED_TEMP_HEAT;
-            state->target_temp_heat = th;
-        }
-        if (payload_len >= 11) {
-            p1p2_fan_mode_t fh = decode_fan_speed(payload[10]);
-            if (fh != state->fan_mode_heat) state->changed |= CHANGED_FAN_HEAT;
-            state->fan_mode_heat = fh;
-        }
-        if (payload_len >= 18) {
-            uint8_t z = payload[17];
-            if (z != state->active_zones) state->changed |= CHANGED_ZONES;
-            state->active_zones = z;
-        }
-        state->data_valid = true;
-        break;
-
-    case PKT_TYPE_COUNTER_A3:
-        /*
-         * Counter data (operation hours, compressor starts, etc.)
-         */
-        if (payload_len >= 8) {
-            uint32_t oh = ((uint32_t)payload[0] << 24) |
-                          ((uint32_t)payload[1] << 16) |
-                          ((uint32_t)payload[2] << 8) |
-                          payload[3];
-            if (oh != state->operation_hours) state->changed |= CHANGED_OP_HOURS;
-            state->operation_hours = oh;
-
-            uint32_t cs = ((uint32_t)payload[4] << 24) |
-                          ((uint32_t)payload[5] << 16) |
-                          ((uint32_t)payload[6] << 8) |
-                          payload[7];
-            if (cs != state->compressor_starts) state->changed |= CHANGED_COMP_STARTS;
-            state->compressor_starts = cs;
-        }
-        break;
 
-    default:
-        /* Other packet types — log at debug level */
-        ESP_LOGD(TAG, "Unhandled packet type 0x%02X (len=%d)", type, pkt->length);
-        break;
+        /* Determine running state from mode and power */
+        if (ts->flags & PKT_DEF_RUNNING) {
+            if (!state->power) {
+                state->running = P1P2_RUNNING_IDLE;
+            } else if (state->mode == P1P2_MODE_HEAT) {
+                state->running = P1P2_RUNNING_HEATING;
+            } else if (state->mode == P1P2_MODE_COOL) {
+                state->running = P1P2_RUNNING_COOLING;
+            }
+        }
+        if (ts->flags & PKT_DEF_DATA_VALID) state->data_valid = true;
     }
 
     state->last_update_us = esp_timer_get_time();
     state->packet_count++;
+    return nchanged;
+}
+
+/*
+ * Decode a single F-series packet and update HVAC state.
+ * Sets bits in state->changed for any field that actually changes value.
+ * Only the fields of this packet type are visited; a field is decoded
+ * when it lies entirely within the payload.
+ *
+ * Packet layout:
+ *   data[0] = source address
+ *   data[1] = destination address
+ *   data[2] = packet type
+ *   data[3..length-2] = payload
+ *   data[length-1] = CRC
+ */
+void p1p2_fseries_decode_packet(const p1p2_packet_t *pkt, p1p2_hvac_state_t *state)
+{
+    p1p2_fseries_decode_fields(pkt, state, NULL);
 }
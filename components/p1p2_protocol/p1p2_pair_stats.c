@@ -0,0 +1,180 @@
+/*
+ * P1P2 Pair Statistics — Request/response latency and bus cycle period
+ *
+ * The bus is a sequence of request/response exchanges: the main controller
+ * asks the indoor unit (00 -> 80, reply 80 -> 00), the indoor unit asks
+ * the auxiliary controller (00 -> 40, reply 40 -> 00), an E-series heat
+ * pump answers from 0x40. A packet is the response to the previous one if
+ * it has the same type, comes from another address and starts within
+ * PAIR_TIMEOUT_US of the request's end. Anything else is a new request;
+ * a request followed by another request went unanswered.
+ *
+ * Per request stream (src, dst, type) this keeps a histogram of response
+ * latency (request end to response start) and the count of unanswered
+ * requests. The first stream seen anchors the bus cycle: the time between
+ * its requests is the cycle period.
+ *
+ * Fed by the protocol task with received packets and with read-back of our
+ * own responses, in bus order.
+ *
+ * ESP32-C6 port: 2026
+ */
+
+#include <string.h>
+#include "esp_err.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "p1p2_protocol.h"
+
+static const char *TAG = "p1p2_pairs";
+
+#define PAIR_TIMEOUT_US   200000        /* longer silence: no response */
+
+typedef struct {
+    bool     valid;
+    uint8_t  src;
+    uint8_t  dst;
+    uint8_t  type;
+    int64_t  eop_us;
+    p1p2_pair_stats_t *entry;
+} pending_req_t;
+
+static p1p2_pair_stats_t entries[P1P2_PAIR_MAX_ENTRIES];
+static bool           entry_used[P1P2_PAIR_MAX_ENTRIES];
+static uint32_t       overflow_count;
+static pending_req_t  pending;
+
+/* Bus cycle, anchored on the first request stream seen */
+static bool           anchor_set;
+static uint8_t        anchor_src, anchor_dst, anchor_type;
+static int64_t        anchor_last_us;
+static p1p2_hist_t    cycle_us;
+static uint32_t       cycles;
+
+static portMUX_TYPE   pair_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static inline uint8_t key_hash(uint8_t src, uint8_t dst, uint8_t type)
+{
+    return (type ^ (src >> 2) ^ (dst >> 1)) & (P1P2_PAIR_MAX_ENTRIES - 1);
+}
+
+/* Find or claim the entry of a request stream. Called with pair_lock held. */
+static p1p2_pair_stats_t *find_entry(uint8_t src, uint8_t dst, uint8_t type)
+{
+    uint8_t slot = key_hash(src, dst, type);
+
+    for (uint8_t i = 0; i < P1P2_PAIR_MAX_PROBE; i++) {
+        p1p2_pair_stats_t *e = &entries[slot];
+        if (!entry_used[slot]) {
+            memset(e, 0, sizeof(*e));
+            e->src = src;
+            e->dst = dst;
+            e->type = type;
+            entry_used[slot] = true;
+            return e;
+        }
+        if (e->src == src && e->dst == dst && e->type == type) return e;
+        slot = (slot + 1) & (P1P2_PAIR_MAX_ENTRIES - 1);
+    }
+    return NULL;
+}
+
+/*
+ * Record a packet seen on the bus (received, or our own read back).
+ * Called by the protocol task only, in bus order.
+ */
+void p1p2_pair_stats_record(const uint8_t *hdr, uint8_t length, int64_t start_us, int64_t eop_us)
+{
+    if (length < 3) return;
+    uint8_t src = hdr[0], dst = hdr[1], type = hdr[2];
+
+    portENTER_CRITICAL(&pair_lock);
+
+    if (pending.valid && type == pending.type && src != pending.src &&
+        start_us - pending.eop_us < PAIR_TIMEOUT_US) {
+        /* Response */
+        if (pending.entry) {
+            pending.entry->responder = src;
+            pending.entry->answered++;
+            p1p2_hist_add(&pending.entry->latency_us, (uint32_t)(start_us - pending.eop_us));
+        }
+        pending.valid = false;
+        portEXIT_CRITICAL(&pair_lock);
+        return;
+    }
+
+    /* New request; the previous one (if any) went unanswered */
+    if (pending.valid && pending.entry) pending.entry->unanswered++;
+
+    p1p2_pair_stats_t *e = find_entry(src, dst, type);
+    if (e) {
+        e->requests++;
+    } else {
+        overflow_count++;
+    }
+    pending.valid = true;
+    pending.src = src;
+    pending.dst = dst;
+    pending.type = type;
+    pending.eop_us = eop_us;
+    pending.entry = e;
+
+    if (!anchor_set) {
+        anchor_set = true;
+        anchor_src = src;
+        anchor_dst = dst;
+        anchor_type = type;
+        anchor_last_us = start_us;
+    } else if (src == anchor_src && dst == anchor_dst && type == anchor_type) {
+        p1p2_hist_add(&cycle_us, (uint32_t)(start_us - anchor_last_us));
+        anchor_last_us = start_us;
+        cycles++;
+    }
+
+    portEXIT_CRITICAL(&pair_lock);
+}
+
+bool p1p2_protocol_get_pair_stats(int index, p1p2_pair_stats_t *out)
+{
+    bool found = false;
+
+    portENTER_CRITICAL(&pair_lock);
+    for (int i = 0; i < P1P2_PAIR_MAX_ENTRIES; i++) {
+        if (!entry_used[i]) continue;
+        if (index-- == 0) {
+            memcpy(out, &entries[i], sizeof(*out));
+            found = true;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&pair_lock);
+    return found;
+}
+
+uint32_t p1p2_protocol_get_cycle_stats(p1p2_hist_t *period_us, uint8_t *anchor_type_out)
+{
+    portENTER_CRITICAL(&pair_lock);
+    if (period_us) memcpy(period_us, &cycle_us, sizeof(*period_us));
+    if (anchor_type_out) *anchor_type_out = anchor_type;
+    uint32_t n = cycles;
+    portEXIT_CRITICAL(&pair_lock);
+    return n;
+}
+
+uint32_t p1p2_protocol_get_pair_overflow(void)
+{
+    return overflow_count;
+}
+
+void p1p2_protocol_reset_pair_stats(void)
+{
+    portENTER_CRITICAL(&pair_lock);
+    memset(entry_used, 0, sizeof(entry_used));
+    memset(&pending, 0, sizeof(pending));
+    p1p2_hist_reset(&cycle_us);
+    anchor_set = false;
+    cycles = 0;
+    overflow_count = 0;
+    portEXIT_CRITICAL(&pair_lock);
+    ESP_LOGD(TAG, "Pair statistics reset");
+}
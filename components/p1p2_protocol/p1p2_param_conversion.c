@@ -1,9 +1,10 @@
 /*
  * P1P2 Protocol Task — Packet processing, decode, and control response
  *
- * This is the main protocol engine that:
+ * The protocol task drives the firmware's engine (p1p2_protocol_t, see
+ * p1p2_protocol_engine.h):
  * 1. Receives packets from the bus I/O queue
- * 2. Decodes them to update HVAC state
+ * 2. Decodes them to update HVAC state (per unit, see p1p2_unit_map.c)
  * 3. Generates control responses (when acting as auxiliary controller)
  * 4. Processes commands from the Matter layer
  *
@@ -12,124 +13,146 @@
  */
 
 #include <string.h>
+#include <stdatomic.h>
 #include "esp_log.h"
 #include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
-#include "freertos/semphr.h"
 #include "p1p2_protocol.h"
+#include "p1p2_protocol_engine.h"
 #include "p1p2_fseries.h"
 #include "p1p2_bus.h"
 #include "p1p2_bus_types.h"
+#include "p1p2_network.h"
 
 static const char *TAG = "p1p2_proto";
 
-/* HVAC state — updated by decoder, read by Matter layer */
-static p1p2_hvac_state_t hvac_state;
-static SemaphoreHandle_t state_mutex;
+/*
+ * The firmware's engine (p1p2_protocol_engine.h). The protocol task
+ * decodes into engine.state (private to it) and publishes a copy to
+ * engine.published under a sequence lock: the sequence is odd while the
+ * copy is written, so readers retry a snapshot that overlapped a publish.
+ * The writer never waits for readers.
+ *
+ * Every publish that changes fields advances a generation and stamps it on
+ * each changed field (one per CHANGED_* bit), so each consumer can hold
+ * its own p1p2_change_cursor_t. Legacy get_state_copy() callers share the
+ * bits accumulated in pending_changed.
+ */
+static p1p2_protocol_t engine;
 
-/* Queues */
-static QueueHandle_t rx_queue;    /* from bus I/O */
-static QueueHandle_t tx_queue;    /* to bus I/O */
-static QueueHandle_t cmd_queue;   /* from Matter/CLI */
+/* Command queue policy and statistics, shared by all senders */
+static portMUX_TYPE cmd_lock = portMUX_INITIALIZER_UNLOCKED;
 
-/* Control level */
-static volatile uint8_t control_level;
+/* Reader spins before yielding, in case it preempted the writer mid-publish */
+#define STATE_READ_SPINS   8
 
 /* External functions from decode/control modules */
-extern void p1p2_fseries_decode_packet(const p1p2_packet_t *pkt, p1p2_hvac_state_t *state);
-extern void p1p2_fseries_control_init(int model);
-extern uint8_t p1p2_fseries_build_response_38(const uint8_t *rb, uint8_t rb_len, uint8_t *wb, uint8_t wb_max);
-extern uint8_t p1p2_fseries_build_response_3b(const uint8_t *rb, uint8_t rb_len, uint8_t *wb, uint8_t wb_max);
-extern uint8_t p1p2_fseries_build_response_39(const uint8_t *rb, uint8_t rb_len, uint8_t *wb, uint8_t wb_max);
-extern uint8_t p1p2_fseries_build_response_3a(const uint8_t *rb, uint8_t rb_len, uint8_t *wb, uint8_t wb_max);
-extern uint8_t p1p2_fseries_build_response_3c(const uint8_t *rb, uint8_t rb_len, uint8_t *wb, uint8_t wb_max);
-extern uint8_t p1p2_fseries_build_response_empty(const uint8_t *rb, uint8_t rb_len, uint8_t *wb, uint8_t wb_max);
-extern esp_err_t p1p2_fseries_apply_command(const p1p2_control_cmd_t *cmd);
+extern void p1p2_decode_select_family(int family);
+extern void p1p2_unit_map_reset(void);
+extern p1p2_hvac_state_t *p1p2_unit_map_begin(const p1p2_packet_t *pkt, p1p2_hvac_state_t *primary,
+                                              p1p2_decode_memo_t *memo);
+extern void p1p2_unit_map_end(void);
+extern void p1p2_pair_stats_record(const uint8_t *hdr, uint8_t length, int64_t start_us, int64_t eop_us);
+extern void p1p2_bus_clock_observe(const uint8_t *data, uint8_t length, int64_t start_us);
+extern void p1p2_counter_poll_reset(void);
+extern void p1p2_counter_poll_tick(int64_t now_us);
+extern void p1p2_counter_poll_observe(const p1p2_packet_t *pkt);
+extern void p1p2_counter_poll_confirmed(const p1p2_tx_confirm_t *conf);
+extern void p1p2_payload_store_init(void);
+extern void p1p2_payload_store_update(const p1p2_packet_t *pkt);
+extern void p1p2_byte_diff_reset(void);
+extern void p1p2_byte_diff_observe(const p1p2_packet_t *pkt);
+extern void p1p2_byte_diff_tick(int64_t now_us);
 
 /*
- * Determine if a received packet requires an auxiliary controller response.
- * Returns the appropriate delay (in ms) before responding.
- * Returns 0 if no response is needed.
- *
- * F-series: packets addressed to 0x40 (aux controller) in the 0x30-0x3F range
- * need responses.
+ * Publish the engine's state to readers. Only called by the engine's task.
+ * The snapshot is published before its changed bits, so a reader that
+ * takes the bits first always sees values at least as new.
  */
-static uint16_t packet_needs_response(const p1p2_packet_t *pkt)
+void p1p2_engine_state_publish(p1p2_protocol_t *p)
 {
-    if (pkt->length < 3) return 0;
-
-    uint8_t dst  = pkt->data[1];
-    uint8_t type = pkt->data[2];
+    uint32_t changed = p->state.changed;
+    uint_fast32_t seq = atomic_load_explicit(&p->state_seq, memory_order_relaxed);
 
-    /* Only respond to packets addressed to the auxiliary controller */
-    if (dst != P1P2_ADDR_AUX_CTRL) return 0;
+    if (changed) {
+        p->state_gen++;
+        for (uint32_t bits = changed; bits; bits &= bits - 1) {
+            p->field_gen[__builtin_ctz(bits)] = p->state_gen;
+        }
+    }
+    p->state.changed = 0;
+
+    atomic_store_explicit(&p->state_seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    memcpy(&p->published.state, &p->state, sizeof(p->published.state));
+    if (changed) {
+        p->published.gen = p->state_gen;
+        memcpy(p->published.field_gen, p->field_gen, sizeof(p->published.field_gen));
+    }
+    atomic_store_explicit(&p->state_seq, seq + 2, memory_order_release);
 
-    /* Only respond to 0x3x packet types */
-    if (type < 0x30 || type > 0x3F) return 0;
+    if (changed) atomic_fetch_or_explicit(&p->pending_changed, changed, memory_order_release);
+}
 
-    /* Standard response delay: 25ms after the request packet */
-    return 25;
+/*
+ * Take a consistent snapshot of the published state and generations
+ * (state.changed is left as published, i.e. 0). Retries while a publish
+ * overlaps the copy.
+ */
+void p1p2_engine_state_read(p1p2_protocol_t *p, p1p2_state_pub_t *out)
+{
+    uint_fast32_t s1, s2;
+    int spins = 0;
+
+    for (;;) {
+        s1 = atomic_load_explicit(&p->state_seq, memory_order_acquire);
+        if (!(s1 & 1)) {
+            memcpy(out, &p->published, sizeof(*out));
+            atomic_thread_fence(memory_order_acquire);
+            s2 = atomic_load_explicit(&p->state_seq, memory_order_relaxed);
+            if (s1 == s2) return;
+        }
+        if (++spins >= STATE_READ_SPINS) {
+            vTaskDelay(1);  /* let a preempted writer finish */
+            spins = 0;
+        }
+    }
 }
 
 /*
- * Build and send an auxiliary controller response.
+ * Build and send the auxiliary controller response to a packet, if one is due.
  */
-static void send_control_response(const p1p2_packet_t *pkt, uint16_t delay_ms)
+static void send_control_response(p1p2_protocol_t *p, const p1p2_packet_t *pkt)
 {
     uint8_t wb[P1P2_MAX_PACKET_SIZE];
-    uint8_t nwrite = 0;
-    uint8_t type = pkt->data[2];
+    uint8_t nwrite = p1p2_engine_response(p, pkt, wb, sizeof(wb));
+    if (nwrite == 0) return;
 
-    switch (type) {
-    case PKT_TYPE_CTRL_35:
-    case PKT_TYPE_CTRL_36:
-    case PKT_TYPE_CTRL_37:
-        nwrite = p1p2_fseries_build_response_empty(pkt->data, pkt->length,
-                                                    wb, sizeof(wb));
-        break;
-
-    case PKT_TYPE_CTRL_38:
-        nwrite = p1p2_fseries_build_response_38(pkt->data, pkt->length,
-                                                 wb, sizeof(wb));
-        break;
-
-    case PKT_TYPE_CTRL_39:
-        nwrite = p1p2_fseries_build_response_39(pkt->data, pkt->length,
-                                                 wb, sizeof(wb));
-        break;
-
-    case PKT_TYPE_CTRL_3A:
-        nwrite = p1p2_fseries_build_response_3a(pkt->data, pkt->length,
-                                                 wb, sizeof(wb));
-        break;
-
-    case PKT_TYPE_CTRL_3B:
-        nwrite = p1p2_fseries_build_response_3b(pkt->data, pkt->length,
-                                                 wb, sizeof(wb));
-        break;
-
-    case PKT_TYPE_CTRL_3C:
-        nwrite = p1p2_fseries_build_response_3c(pkt->data, pkt->length,
-                                                 wb, sizeof(wb));
-        break;
-
-    default:
-        ESP_LOGD(TAG, "No response handler for packet type 0x%02X", type);
-        return;
+    uint8_t type = pkt->data[2];
+    esp_err_t ret = p1p2_bus_write_packet(wb, nwrite, P1P2_RESPONSE_DELAY_MS,
+                                          F_SERIES_CRC_GEN, F_SERIES_CRC_FEED);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to send response for 0x%02X: %s",
+                 type, esp_err_to_name(ret));
+    } else {
+        ESP_LOGD(TAG, "Sent response for 0x%02X (%d bytes, %dms delay)",
+                 type, nwrite, P1P2_RESPONSE_DELAY_MS);
     }
+}
 
-    if (nwrite > 0) {
-        esp_err_t ret = p1p2_bus_write_packet(wb, nwrite, delay_ms,
-                                               F_SERIES_CRC_GEN, F_SERIES_CRC_FEED);
-        if (ret != ESP_OK) {
-            ESP_LOGW(TAG, "Failed to send response for 0x%02X: %s",
-                     type, esp_err_to_name(ret));
-        } else {
-            ESP_LOGD(TAG, "Sent response for 0x%02X (%d bytes, %dms delay)",
-                     type, nwrite, delay_ms);
-        }
+/*
+ * Handle read-back of our own transmissions.
+ */
+static void drain_tx_confirms(p1p2_protocol_t *p)
+{
+    p1p2_tx_confirm_t conf;
+
+    while (p->confirm_queue && xQueueReceive(p->confirm_queue, &conf, 0) == pdTRUE) {
+        p1p2_pair_stats_record(conf.data, conf.length, conf.start_us, conf.eop_us);
+        p1p2_fseries_tx_confirmed(&p->ctrl, &conf);
+        p1p2_counter_poll_confirmed(&conf);
     }
 }
 
@@ -139,33 +162,34 @@ static void send_control_response(const p1p2_packet_t *pkt, uint16_t delay_ms)
  */
 static void protocol_task(void *pvParameters)
 {
+    p1p2_protocol_t *p = pvParameters;
     p1p2_packet_t pkt;
     p1p2_control_cmd_t cmd;
 
-    ESP_LOGI(TAG, "Protocol task started (control_level=%d)", control_level);
+    ESP_LOGI(TAG, "Protocol task started (control_level=%d)", p->control_level);
 
     while (1) {
         /* Process any pending control commands from Matter */
-        while (xQueueReceive(cmd_queue, &cmd, 0) == pdTRUE) {
+        while (xQueueReceive(p->cmd_queue, &cmd, 0) == pdTRUE) {
             ESP_LOGI(TAG, "Processing command: type=%d value=%ld", cmd.type, (long)cmd.value);
-            p1p2_fseries_apply_command(&cmd);
+            p1p2_fseries_apply_command(&p->ctrl, &cmd);
         }
 
-        /* Wait for next packet from bus */
-        if (xQueueReceive(rx_queue, &pkt, pdMS_TO_TICKS(100)) == pdTRUE) {
-            /* Decode packet to update HVAC state */
-            if (xSemaphoreTake(state_mutex, pdMS_TO_TICKS(10)) == pdTRUE) {
-                p1p2_fseries_decode_packet(&pkt, &hvac_state);
-                xSemaphoreGive(state_mutex);
-            }
+        /* Read-back results of responses we sent */
+        drain_tx_confirms(p);
 
-            /* If acting as auxiliary controller, send response if needed */
-            if (control_level == P1P2_CONTROL_AUX) {
-                uint16_t delay = packet_needs_response(&pkt);
-                if (delay > 0) {
-                    send_control_response(&pkt, delay);
-                }
-            }
+        /* Counter requests, in idle windows within the load budget */
+        if (p->control_level == P1P2_CONTROL_AUX && p->control_supported) {
+            p1p2_counter_poll_tick(esp_timer_get_time());
+        }
+
+        /* Folded byte changes of types that went quiet */
+        p1p2_byte_diff_tick(esp_timer_get_time());
+
+        /* Wait for next packet from bus */
+        if (xQueueReceive(p->rx_queue, &pkt, pdMS_TO_TICKS(100)) == pdTRUE) {
+            /* Our responses read back before this packet came first on the bus */
+            drain_tx_confirms(p);
 
             /* Log packet at debug level */
             if (pkt.length > 0) {
@@ -173,6 +197,36 @@ static void protocol_task(void *pvParameters)
                          pkt.data[0], pkt.data[1], pkt.data[2], pkt.length,
                          pkt.has_error ? "YES" : "no");
             }
+
+            /* Damaged packets (split tails included): header bytes can't be trusted */
+            if (pkt.has_error) continue;
+
+            p1p2_pair_stats_record(pkt.data, pkt.length, pkt.start_us, pkt.eop_us);
+            p1p2_bus_clock_observe(pkt.data, pkt.length, pkt.start_us);
+
+            /* Decode into the state of the unit it belongs to (repeats are skipped) */
+            p1p2_hvac_state_t *unit_state = p1p2_unit_map_begin(&pkt, &p->state, &p->memo);
+            if (unit_state) p1p2_decode_memo_packet(&p->memo, &pkt, unit_state);
+            p1p2_unit_map_end();
+            p1p2_engine_state_publish(p);
+
+            /* Keep the primary unit's raw payload for on-demand parameter reads */
+            if (unit_state == &p->state) p1p2_payload_store_update(&pkt);
+            p1p2_counter_poll_observe(&pkt);
+
+            /* Byte changes of types the tables do not describe (CLI: D) */
+            p1p2_byte_diff_observe(&pkt);
+
+            /* Model auto-detection */
+            int model = p1p2_fseries_model_observe(&p->ctrl, &pkt);
+
+            /* If acting as auxiliary controller, send response if needed */
+            send_control_response(p, &pkt);
+
+            /* Keep the detected model for the next boot, after the reply slot */
+            if (model != F_MODEL_AUTO && p1p2_config_set_u8("f_model", model) != ESP_OK) {
+                ESP_LOGW(TAG, "Could not save detected model %d", model);
+            }
         }
     }
 }
@@ -185,86 +239,195 @@ static void protocol_task(void *pvParameters)
 
 esp_err_t p1p2_protocol_init(QueueHandle_t bus_rx_queue, QueueHandle_t bus_tx_queue)
 {
-    rx_queue = bus_rx_queue;
-    tx_queue = bus_tx_queue;
-
-    /* Create command queue */
-    cmd_queue = xQueueCreate(16, sizeof(p1p2_control_cmd_t));
-    if (!cmd_queue) return ESP_ERR_NO_MEM;
-
-    /* Create state mutex */
-    state_mutex = xSemaphoreCreateMutex();
-    if (!state_mutex) return ESP_ERR_NO_MEM;
-
-    /* Initialize HVAC state */
-    memset(&hvac_state, 0, sizeof(hvac_state));
-
     /* Set control level from Kconfig */
 #ifdef CONFIG_P1P2_CONTROL_LEVEL
-    control_level = CONFIG_P1P2_CONTROL_LEVEL;
+    uint8_t level = CONFIG_P1P2_CONTROL_LEVEL;
 #else
-    control_level = P1P2_CONTROL_OFF;
+    uint8_t level = P1P2_CONTROL_OFF;
 #endif
 
-    /* Initialize F-series control engine */
+    /* Select the family's tables and build the index for the table-driven decoder */
+#ifdef CONFIG_P1P2_E_SERIES
+    int family = P1P2_FAMILY_E;
+#else
+    int family = P1P2_FAMILY_F;
+#endif
+    p1p2_decode_select_family(family);
+    p1p2_unit_map_reset();
+    p1p2_protocol_reset_pair_stats();
+    p1p2_counter_poll_reset();
+    p1p2_payload_store_init();
+    p1p2_byte_diff_reset();
+
+    /* F-series control (E-series: monitoring only) */
+    bool supported = (family == P1P2_FAMILY_F);
+    if (!supported && level == P1P2_CONTROL_AUX) {
+        ESP_LOGW(TAG, "No auxiliary controller support for this family, monitoring only");
+    }
 #ifdef CONFIG_P1P2_F_MODEL_ID
-    p1p2_fseries_control_init(CONFIG_P1P2_F_MODEL_ID);
+    int model = CONFIG_P1P2_F_MODEL_ID;
 #else
-    p1p2_fseries_control_init(F_MODEL_BCL);
+    int model = F_MODEL_BCL;
 #endif
+    bool detect = (model == F_MODEL_AUTO);
+    if (detect) {
+        /* Start with the model detected on a previous boot, confirm it on the bus */
+        uint8_t saved;
+        if (p1p2_config_get_u8("f_model", &saved) == ESP_OK &&
+            saved >= F_MODEL_BCL && saved <= F_MODEL_M) {
+            model = saved;
+            ESP_LOGI(TAG, "Using saved model %d until confirmed", model);
+        }
+    }
+
+    /* HVAC state, decode memo and control state */
+    p1p2_engine_init(&engine, model, level, supported);
+    if (detect) p1p2_fseries_model_detect_start(&engine.ctrl);
+
+    engine.rx_queue = bus_rx_queue;
+    engine.tx_queue = bus_tx_queue;
+    engine.confirm_queue = p1p2_bus_get_tx_confirm_queue();
+
+    /* Create command queue */
+    engine.cmd_queue = xQueueCreate(P1P2_CMD_QUEUE_SIZE, sizeof(p1p2_control_cmd_t));
+    if (!engine.cmd_queue) return ESP_ERR_NO_MEM;
+    engine.cmd_policy = P1P2_QUEUE_BLOCK;
+    engine.cmd_block_ms = 100;
 
     /* Start protocol task at priority 15 */
-    BaseType_t ret = xTaskCreate(protocol_task, "protocol", 8192, NULL, 15, NULL);
+    BaseType_t ret = xTaskCreate(protocol_task, "protocol", 8192, &engine, 15, NULL);
     if (ret != pdPASS) return ESP_ERR_NO_MEM;
 
     ESP_LOGI(TAG, "Protocol engine initialized");
     return ESP_OK;
 }
 
-const p1p2_hvac_state_t *p1p2_protocol_get_state(void)
+int p1p2_protocol_get_model(void)
+{
+    return p1p2_fseries_control_get_model(&engine.ctrl);
+}
+
+void p1p2_protocol_read_state(p1p2_hvac_state_t *out)
 {
-    return &hvac_state;
+    p1p2_state_pub_t snap;
+    p1p2_engine_state_read(&engine, &snap);
+    memcpy(out, &snap.state, sizeof(*out));
 }
 
 void p1p2_protocol_get_state_copy(p1p2_hvac_state_t *out)
 {
-    if (xSemaphoreTake(state_mutex, pdMS_TO_TICKS(50)) == pdTRUE) {
-        memcpy(out, &hvac_state, sizeof(hvac_state));
-        /* Clear changed flags after Matter has consumed the snapshot */
-        hvac_state.changed = 0;
-        xSemaphoreGive(state_mutex);
+    /* Take the bits first: the snapshot read after is at least as new */
+    uint32_t changed = atomic_exchange_explicit(&engine.pending_changed, 0, memory_order_acquire);
+    p1p2_protocol_read_state(out);
+    out->changed = changed;
+}
+
+void p1p2_engine_cursor_init(p1p2_protocol_t *p, p1p2_change_cursor_t *cursor, bool from_now)
+{
+    cursor->gen = 0;
+    if (from_now) {
+        p1p2_state_pub_t snap;
+        p1p2_engine_state_read(p, &snap);
+        cursor->gen = snap.gen;
     }
 }
 
-void p1p2_protocol_clear_changed(void)
+uint32_t p1p2_engine_read_changes(p1p2_protocol_t *p, p1p2_change_cursor_t *cursor,
+                                  p1p2_hvac_state_t *out)
 {
-    if (xSemaphoreTake(state_mutex, pdMS_TO_TICKS(50)) == pdTRUE) {
-        hvac_state.changed = 0;
-        xSemaphoreGive(state_mutex);
+    p1p2_state_pub_t snap;
+    uint32_t changed = 0;
+
+    p1p2_engine_state_read(p, &snap);
+    if (snap.gen != cursor->gen) {
+        for (int i = 0; i < P1P2_STATE_FIELDS; i++) {
+            if (snap.field_gen[i] > cursor->gen) changed |= 1u << i;
+        }
+        cursor->gen = snap.gen;
     }
+
+    memcpy(out, &snap.state, sizeof(*out));
+    out->changed = changed;
+    return changed;
+}
+
+void p1p2_protocol_cursor_init(p1p2_change_cursor_t *cursor, bool from_now)
+{
+    p1p2_engine_cursor_init(&engine, cursor, from_now);
+}
+
+uint32_t p1p2_protocol_read_changes(p1p2_change_cursor_t *cursor, p1p2_hvac_state_t *out)
+{
+    return p1p2_engine_read_changes(&engine, cursor, out);
+}
+
+void p1p2_protocol_clear_changed(void)
+{
+    atomic_store_explicit(&engine.pending_changed, 0, memory_order_relaxed);
 }
 
 QueueHandle_t p1p2_protocol_get_cmd_queue(void)
 {
-    return cmd_queue;
+    return engine.cmd_queue;
 }
 
 esp_err_t p1p2_protocol_send_cmd(p1p2_cmd_type_t type, int32_t value)
 {
     p1p2_control_cmd_t cmd = { .type = type, .value = value };
-    if (xQueueSend(cmd_queue, &cmd, pdMS_TO_TICKS(100)) != pdTRUE) {
-        return ESP_ERR_TIMEOUT;
+    p1p2_control_cmd_t old;
+    uint8_t evicted;
+
+    /* Senders are several tasks (Matter, CLI): stats under cmd_lock */
+    esp_err_t ret = p1p2_queue_post(engine.cmd_queue, &cmd, engine.cmd_policy,
+                                    engine.cmd_block_ms, &old, &evicted);
+    UBaseType_t n = uxQueueMessagesWaiting(engine.cmd_queue);
+
+    portENTER_CRITICAL(&cmd_lock);
+    if (evicted) engine.cmd_dropped++;
+    if (ret != ESP_OK) {
+        engine.cmd_dropped++;
+    } else if (n > engine.cmd_queue_hwm) {
+        engine.cmd_queue_hwm = n;
     }
-    return ESP_OK;
+    portEXIT_CRITICAL(&cmd_lock);
+
+    if (evicted) ESP_LOGW(TAG, "Command queue full, dropped command type=%d", old.type);
+    return ret;
+}
+
+void p1p2_protocol_set_cmd_queue_policy(p1p2_queue_policy_t policy, uint16_t block_ms)
+{
+    portENTER_CRITICAL(&cmd_lock);
+    engine.cmd_policy = policy;
+    engine.cmd_block_ms = block_ms;
+    portEXIT_CRITICAL(&cmd_lock);
+}
+
+void p1p2_protocol_get_cmd_queue_stats(uint8_t *hwm, uint32_t *dropped, bool reset)
+{
+    portENTER_CRITICAL(&cmd_lock);
+    if (hwm) *hwm = engine.cmd_queue_hwm;
+    if (dropped) *dropped = engine.cmd_dropped;
+    if (reset) {
+        engine.cmd_queue_hwm = 0;
+        engine.cmd_dropped = 0;
+    }
+    portEXIT_CRITICAL(&cmd_lock);
 }
 
 void p1p2_protocol_set_control_level(uint8_t level)
 {
-    control_level = level;
+    engine.control_level = level;
     ESP_LOGI(TAG, "Control level set to %d", level);
 }
 
 uint8_t p1p2_protocol_get_control_level(void)
 {
-    return control_level;
+    return engine.control_level;
+}
+
+void p1p2_protocol_get_decode_stats(uint32_t *skipped, uint32_t *decoded)
+{
+    if (skipped) *skipped = engine.memo.skipped;
+    if (decoded) *decoded = engine.memo.decoded;
 }
@@ -0,0 +1,317 @@
+/*
+ * P1P2 Payload Store — Latest payload per packet type and a packed
+ * parameter store with change generations
+ *
+ * The protocol task stores the latest payload of every packet type and
+ * direction (p1p2_fseries_packet_key) that has parameters in the active
+ * table; F-series replies from the auxiliary address have none, so they
+ * do not overwrite the request of the same type. When a payload changes,
+ * only the parameters whose bytes differ are extracted, as compact raw values
+ * (p1p2_fseries_param_extract: 1 bit for flags, 3 for modes, 16 for
+ * 16-bit fields, ...) bit-packed into a fixed budget. Conversion to the
+ * final value (sign, ×10, scale) happens when a consumer reads it through
+ * p1p2_protocol_get_param().
+ *
+ * Every value change advances a global generation; the parameter records
+ * it and the change goes into a journal ring, so "what changed since
+ * generation N" costs time proportional to the changes while the journal
+ * reaches back that far, and one scan of per-parameter generations
+ * otherwise. A change bitmap additionally marks parameters changed since
+ * they were last acknowledged.
+ *
+ * RAM: STORE_VALUE_WORDS * 4 bytes of packed values, plus per parameter
+ * a 16-bit bit offset, a 32-bit generation and 2 bits of bitmaps.
+ * Parameters beyond the value budget are decoded from the payload on read.
+ *
+ * ESP32-C6 port: 2026
+ */
+
+#include <string.h>
+#include "esp_err.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "p1p2_protocol.h"
+#include "p1p2_param_tables.h"
+#include "p1p2_bus_config.h"
+
+static const char *TAG = "p1p2_store";
+
+#define STORE_MAX_TYPES     24
+#define STORE_PAYLOAD_MAX   (P1P2_MAX_PACKET_SIZE - 4)
+#define STORE_VALUE_WORDS   64          /* 2048 bits of packed values */
+#define STORE_JOURNAL_SIZE  64          /* power of 2 */
+#define STORE_NO_BITS       0xFFFF      /* parameter outside the value budget */
+#define PARAM_WORDS         ((P1P2_PARAM_MAX + 31) / 32)
+
+typedef struct {
+    uint32_t version;               /* 0 = nothing received yet */
+    uint8_t  len;
+    uint8_t  payload[STORE_PAYLOAD_MAX];
+} store_slot_t;
+
+typedef struct {
+    uint16_t id;
+    uint32_t gen;
+} journal_entry_t;
+
+static uint8_t       type_slot[P1P2_PACKET_KEYS];  /* slot + 1, 0 = not stored */
+static store_slot_t  slots[STORE_MAX_TYPES];
+
+static uint32_t      values[STORE_VALUE_WORDS];
+static uint16_t      value_bit[P1P2_PARAM_MAX];
+static uint32_t      param_gen[P1P2_PARAM_MAX];
+static uint16_t      param_count;       /* parameters in the active table */
+static uint32_t      valid_map[PARAM_WORDS];
+static uint32_t      changed_map[PARAM_WORDS];
+static uint32_t      store_gen;
+
+static journal_entry_t journal[STORE_JOURNAL_SIZE];
+static uint16_t      journal_count;     /* saturates at STORE_JOURNAL_SIZE */
+
+static portMUX_TYPE  store_lock = portMUX_INITIALIZER_UNLOCKED;
+
+extern const p1p2_param_def_t *p1p2_fseries_param_def(uint16_t id);
+extern uint16_t p1p2_fseries_type_params(uint16_t key, const uint16_t **ids);
+extern uint16_t p1p2_fseries_packet_key(const p1p2_packet_t *pkt);
+extern uint16_t p1p2_fseries_param_key(const p1p2_param_def_t *p);
+extern uint8_t  p1p2_fseries_param_width(const p1p2_param_def_t *p);
+extern uint32_t p1p2_fseries_param_extract(const p1p2_param_def_t *p, const uint8_t *b);
+extern int64_t  p1p2_fseries_param_convert(const p1p2_param_def_t *p, uint32_t raw);
+
+static inline bool map_test(const uint32_t *map, uint16_t id)
+{
+    return (map[id >> 5] >> (id & 31)) & 1;
+}
+
+static inline void map_set(uint32_t *map, uint16_t id)
+{
+    map[id >> 5] |= 1u << (id & 31);
+}
+
+/* Read/write `width` bits at bit position `bit` (may straddle two words) */
+static uint32_t bits_get(uint16_t bit, uint8_t width)
+{
+    uint64_t w = values[bit >> 5];
+    if ((bit & 31) + width > 32) w |= (uint64_t)values[(bit >> 5) + 1] << 32;
+    uint64_t mask = (width == 32) ? 0xFFFFFFFFu : ((1u << width) - 1);
+    return (uint32_t)((w >> (bit & 31)) & mask);
+}
+
+static void bits_put(uint16_t bit, uint8_t width, uint32_t v)
+{
+    uint64_t mask = ((width == 32) ? 0xFFFFFFFFull : ((1ull << width) - 1)) << (bit & 31);
+    uint64_t w = values[bit >> 5];
+    bool straddle = (bit & 31) + width > 32;
+    if (straddle) w |= (uint64_t)values[(bit >> 5) + 1] << 32;
+    w = (w & ~mask) | (((uint64_t)v << (bit & 31)) & mask);
+    values[bit >> 5] = (uint32_t)w;
+    if (straddle) values[(bit >> 5) + 1] = (uint32_t)(w >> 32);
+}
+
+/*
+ * Assign a slot to every packet type that has parameters and lay out the
+ * packed values. Follows the family selected in the decoder.
+ */
+void p1p2_payload_store_init(void)
+{
+    uint8_t n = 0;
+    uint32_t bit = 0;
+    uint16_t unpacked = 0;
+
+    memset(type_slot, 0, sizeof(type_slot));
+    memset(slots, 0, sizeof(slots));
+    memset(values, 0, sizeof(values));
+    memset(param_gen, 0, sizeof(param_gen));
+    memset(valid_map, 0, sizeof(valid_map));
+    memset(changed_map, 0, sizeof(changed_map));
+    memset(journal, 0, sizeof(journal));
+    journal_count = 0;
+    store_gen = 0;
+    param_count = 0;
+
+    const p1p2_param_def_t *p;
+    for (uint16_t id = 0; (p = p1p2_fseries_param_def(id)) != NULL; id++) {
+        uint16_t key = p1p2_fseries_param_key(p);
+        if (!type_slot[key] && n < STORE_MAX_TYPES) {
+            type_slot[key] = ++n;
+        }
+        param_count = id + 1;
+        uint8_t width = p1p2_fseries_param_width(p);
+        if (bit + width <= STORE_VALUE_WORDS * 32) {
+            value_bit[id] = (uint16_t)bit;
+            bit += width;
+        } else {
+            value_bit[id] = STORE_NO_BITS;
+            unpacked++;
+        }
+    }
+
+    if (unpacked) {
+        ESP_LOGW(TAG, "%u parameters exceed the value budget, decoded on read", unpacked);
+    }
+    ESP_LOGD(TAG, "%u packet types, %lu value bits", n, (unsigned long)bit);
+}
+
+/* Record a value change. Called with store_lock held. */
+static void note_change(uint16_t id)
+{
+    store_gen++;
+    param_gen[id] = store_gen;
+    map_set(changed_map, id);
+
+    uint16_t head = store_gen & (STORE_JOURNAL_SIZE - 1);
+    journal[head].id = id;
+    journal[head].gen = store_gen;
+    if (journal_count < STORE_JOURNAL_SIZE) journal_count++;
+}
+
+/*
+ * Store a received packet's payload and extract changed parameters.
+ * Called by the protocol task.
+ */
+void p1p2_payload_store_update(const p1p2_packet_t *pkt)
+{
+    if (pkt->length < 4) return;
+    uint16_t key = p1p2_fseries_packet_key(pkt);
+    uint8_t slot = type_slot[key];
+    if (!slot) return;
+
+    store_slot_t *s = &slots[slot - 1];
+    const uint8_t *payload = &pkt->data[3];
+    uint8_t len = pkt->length - 4;
+    if (len > STORE_PAYLOAD_MAX) len = STORE_PAYLOAD_MAX;
+
+    const uint16_t *ids;
+    uint16_t count = p1p2_fseries_type_params(key, &ids);
+
+    portENTER_CRITICAL(&store_lock);
+    if (s->version != 0 && s->len == len && memcmp(s->payload, payload, len) == 0) {
+        portEXIT_CRITICAL(&store_lock);
+        return;
+    }
+
+    for (uint16_t i = 0; i < count; i++) {
+        uint16_t id = ids[i];
+        const p1p2_param_def_t *p = p1p2_fseries_param_def(id);
+        uint8_t off = p->payload_offset;
+
+        if (off + p->byte_length > len) continue;   /* keep last known value */
+        if (s->version != 0 && off + p->byte_length <= s->len &&
+            memcmp(&s->payload[off], &payload[off], p->byte_length) == 0) continue;
+
+        uint32_t raw = p1p2_fseries_param_extract(p, &payload[off]);
+        bool valid = map_test(valid_map, id);
+
+        if (value_bit[id] != STORE_NO_BITS) {
+            uint8_t width = p1p2_fseries_param_width(p);
+            if (valid && bits_get(value_bit[id], width) == raw) continue;
+            bits_put(value_bit[id], width, raw);
+        }
+        map_set(valid_map, id);
+        note_change(id);
+    }
+
+    memcpy(s->payload, payload, len);
+    s->len = len;
+    if (++s->version == 0) s->version = 1;
+    portEXIT_CRITICAL(&store_lock);
+}
+
+esp_err_t p1p2_protocol_get_param(uint16_t id, int64_t *value)
+{
+    const p1p2_param_def_t *p = p1p2_fseries_param_def(id);
+    if (!p || !value) return ESP_ERR_INVALID_ARG;
+
+    uint8_t slot = type_slot[p1p2_fseries_param_key(p)];
+    if (!slot) return ESP_ERR_INVALID_STATE;
+    store_slot_t *s = &slots[slot - 1];
+
+    uint32_t raw = 0;
+    esp_err_t ret = ESP_OK;
+
+    portENTER_CRITICAL(&store_lock);
+    if (s->version == 0 || !map_test(valid_map, id)) {
+        ret = ESP_ERR_INVALID_STATE;                 /* not seen yet */
+    } else if (p->payload_offset + p->byte_length > s->len) {
+        ret = ESP_ERR_INVALID_SIZE;                  /* last payload too short */
+    } else if (value_bit[id] != STORE_NO_BITS) {
+        raw = bits_get(value_bit[id], p1p2_fseries_param_width(p));
+    } else {
+        raw = p1p2_fseries_param_extract(p, &s->payload[p->payload_offset]);
+    }
+    portEXIT_CRITICAL(&store_lock);
+
+    if (ret == ESP_OK) *value = p1p2_fseries_param_convert(p, raw);
+    return ret;
+}
+
+uint32_t p1p2_protocol_get_param_generation(void)
+{
+    portENTER_CRITICAL(&store_lock);
+    uint32_t gen = store_gen;
+    portEXIT_CRITICAL(&store_lock);
+    return gen;
+}
+
+int p1p2_protocol_params_changed_since(uint32_t since, uint16_t *ids, int max_ids,
+                                       uint32_t *gen_out)
+{
+    uint32_t seen[PARAM_WORDS];
+    int n = 0;
+
+    memset(seen, 0, sizeof(seen));
+
+    portENTER_CRITICAL(&store_lock);
+    uint32_t cur = store_gen;
+
+    if (since < cur && cur - since <= journal_count) {
+        /* Journal holds every change after `since`: walk newest first */
+        for (uint32_t g = cur; g > since; g--) {
+            uint16_t id = journal[g & (STORE_JOURNAL_SIZE - 1)].id;
+            if (map_test(seen, id)) continue;
+            map_set(seen, id);
+            if (n < max_ids) ids[n] = id;
+            n++;
+        }
+    } else if (since < cur) {
+        /* Journal wrapped: fall back to per-parameter generations */
+        for (uint16_t id = 0; id < param_count; id++) {
+            if (param_gen[id] <= since) continue;
+            if (n < max_ids) ids[n] = id;
+            n++;
+        }
+    }
+    portEXIT_CRITICAL(&store_lock);
+
+    if (gen_out) *gen_out = cur;
+    return n;
+}
+
+bool p1p2_protocol_param_changed(uint16_t id, bool clear)
+{
+    if (id >= param_count) return false;
+
+    portENTER_CRITICAL(&store_lock);
+    bool changed = map_test(changed_map, id);
+    if (clear) changed_map[id >> 5] &= ~(1u << (id & 31));
+    portEXIT_CRITICAL(&store_lock);
+    return changed;
+}
+
+const char *p1p2_protocol_get_param_name(uint16_t id, uint8_t *packet_type)
+{
+    const p1p2_param_def_t *p = p1p2_fseries_param_def(id);
+    if (!p) return NULL;
+    if (packet_type) *packet_type = p->packet_type;
+    return p->name;
+}
+
+int p1p2_protocol_find_param(uint8_t packet_type, const char *name)
+{
+    const p1p2_param_def_t *p;
+    for (uint16_t id = 0; (p = p1p2_fseries_param_def(id)) != NULL; id++) {
+        if (packet_type && p->packet_type != packet_type) continue;
+        if (strcmp(p->name, name) == 0) return id;
+    }
+    return -1;
+}
@@ -0,0 +1,87 @@
+/*
+ * P1P2 Protocol Engine — Decode and control response for one bus
+ *
+ * The per-packet work of the protocol task, on a p1p2_protocol_t context
+ * instead of file statics: decode through the engine's memo, model
+ * detection and the auxiliary controller response. The protocol task
+ * (p1p2_param_conversion.c) drives the firmware's engine with the unit
+ * map in between; p1p2_engine_process() is the whole path for engines
+ * that track a single unit, such as the host fleet benchmark.
+ *
+ * Engines share nothing mutable: any number can run on separate threads,
+ * each context used by one thread at a time.
+ *
+ * ESP32-C6 port: 2026
+ */
+
+#include <string.h>
+#include "esp_log.h"
+#include "p1p2_protocol.h"
+#include "p1p2_protocol_engine.h"
+#include "p1p2_fseries.h"
+
+static const char *TAG = "p1p2_engine";
+
+void p1p2_engine_init(p1p2_protocol_t *p, int model, uint8_t control_level,
+                      bool control_supported)
+{
+    memset(p, 0, sizeof(*p));
+    p->control_level = control_level;
+    p->control_supported = control_supported;
+    p1p2_decode_memo_reset(&p->memo);
+    p1p2_fseries_control_init(&p->ctrl, model);
+}
+
+/*
+ * Whether a received packet needs an auxiliary controller response.
+ *
+ * F-series: packets addressed to 0x40 (aux controller) in the 0x30-0x3F range
+ * need responses.
+ */
+static bool packet_needs_response(const p1p2_packet_t *pkt)
+{
+    if (pkt->length < 3) return false;
+
+    /* Only respond to packets addressed to the auxiliary controller */
+    if (pkt->data[1] != P1P2_ADDR_AUX_CTRL) return false;
+
+    /* Only respond to 0x3x packet types */
+    return pkt->data[2] >= 0x30 && pkt->data[2] <= 0x3F;
+}
+
+uint8_t p1p2_engine_response(p1p2_protocol_t *p, const p1p2_packet_t *pkt,
+                             uint8_t *wb, uint8_t wb_max)
+{
+    if (p->control_level != P1P2_CONTROL_AUX || !p->control_supported) return 0;
+    if (!packet_needs_response(pkt)) return 0;
+
+    p1p2_fseries_ctrl_t *c = &p->ctrl;
+
+    switch (pkt->data[2]) {
+    case PKT_TYPE_CTRL_35:
+    case PKT_TYPE_CTRL_36:
+    case PKT_TYPE_CTRL_37:
+        return p1p2_fseries_build_response_empty(c, pkt->data, pkt->length, wb, wb_max);
+    case PKT_TYPE_CTRL_38:
+        return p1p2_fseries_build_response_38(c, pkt->data, pkt->length, wb, wb_max);
+    case PKT_TYPE_CTRL_39:
+        return p1p2_fseries_build_response_39(c, pkt->data, pkt->length, wb, wb_max);
+    case PKT_TYPE_CTRL_3A:
+        return p1p2_fseries_build_response_3a(c, pkt->data, pkt->length, wb, wb_max);
+    case PKT_TYPE_CTRL_3B:
+        return p1p2_fseries_build_response_3b(c, pkt->data, pkt->length, wb, wb_max);
+    case PKT_TYPE_CTRL_3C:
+        return p1p2_fseries_build_response_3c(c, pkt->data, pkt->length, wb, wb_max);
+    default:
+        ESP_LOGD(TAG, "No response handler for packet type 0x%02X", pkt->data[2]);
+        return 0;
+    }
+}
+
+uint8_t p1p2_engine_process(p1p2_protocol_t *p, const p1p2_packet_t *pkt,
+                            uint8_t *wb, uint8_t wb_max)
+{
+    p1p2_decode_memo_packet(&p->memo, pkt, &p->state);
+    p1p2_fseries_model_observe(&p->ctrl, pkt);
+    return p1p2_engine_response(p, pkt, wb, wb_max);
+}
@@ -0,0 +1,297 @@
+/*
+ * P1P2 Unit Map — Per-unit HVAC state keyed by bus address
+ *
+ * A bus can carry several indoor units (VRV) or a second remote. Decoding
+ * all of them into one state makes every value depend on whichever unit
+ * spoke last, so each packet is attributed to a unit address — its source,
+ * or its destination when sent from the auxiliary controller address — and
+ * decoded into that unit's own state.
+ *
+ * The first unit heard is the primary unit: its state is the protocol
+ * task's engine state, published to Matter as before. Other units live in a
+ * small open-addressed table (P1P2_MAX_UNITS slots, linear probing over the
+ * whole table, so freed slots need no tombstones). A unit silent for
+ * P1P2_UNIT_TIMEOUT_MS is dropped; if the primary unit goes silent, the most
+ * recently heard other unit takes its place. Packets from new units are not
+ * decoded while the table is full.
+ *
+ * Written by the protocol task only. Other tasks read under a sequence
+ * lock, as for the published primary state.
+ *
+ * ESP32-C6 port: 2026
+ */
+
+#include <string.h>
+#include <stdatomic.h>
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "p1p2_protocol.h"
+#include "p1p2_fseries.h"
+#include "p1p2_protocol_engine.h"
+
+static const char *TAG = "p1p2_units";
+
+#define UNIT_AGE_CHECK_US  1000000LL            /* look for silent units once a second */
+#define UNIT_READ_SPINS    8
+#define UNIT_ALL_CHANGED   ((CHANGED_ZONES << 1) - 1)
+
+typedef struct {
+    bool     used;
+    uint8_t  addr;
+    uint32_t packets;
+    int64_t  last_seen_us;
+    p1p2_hvac_state_t state;
+} unit_slot_t;
+
+static unit_slot_t units[P1P2_MAX_UNITS];
+static bool     primary_set;
+static uint8_t  primary_addr;
+static uint32_t primary_packets;
+static int64_t  primary_seen_us;
+static int64_t  last_age_check_us;
+static uint32_t units_dropped;          /* packets from units that found no slot */
+static bool     writing;
+static atomic_uint_fast32_t unit_seq;
+
+_Static_assert((P1P2_MAX_UNITS & (P1P2_MAX_UNITS - 1)) == 0, "P1P2_MAX_UNITS must be a power of 2");
+
+/* Unit a packet belongs to: its sender, unless we (or another aux) sent it */
+static inline uint8_t unit_addr(const p1p2_packet_t *pkt)
+{
+    return (pkt->data[0] == P1P2_ADDR_AUX_CTRL) ? pkt->data[1] : pkt->data[0];
+}
+
+static inline uint8_t unit_hash(uint8_t addr)
+{
+    return (addr ^ (addr >> 3) ^ (addr >> 6)) & (P1P2_MAX_UNITS - 1);
+}
+
+static unit_slot_t *unit_find(uint8_t addr)
+{
+    uint8_t idx = unit_hash(addr);
+    for (int probe = 0; probe < P1P2_MAX_UNITS; probe++) {
+        unit_slot_t *u = &units[(idx + probe) & (P1P2_MAX_UNITS - 1)];
+        if (u->used && u->addr == addr) return u;
+    }
+    return NULL;
+}
+
+static unit_slot_t *unit_alloc(uint8_t addr)
+{
+    uint8_t idx = unit_hash(addr);
+    for (int probe = 0; probe < P1P2_MAX_UNITS; probe++) {
+        unit_slot_t *u = &units[(idx + probe) & (P1P2_MAX_UNITS - 1)];
+        if (!u->used) {
+            memset(u, 0, sizeof(*u));
+            u->used = true;
+            u->addr = addr;
+            return u;
+        }
+    }
+    return NULL;
+}
+
+static void write_begin(void)
+{
+    uint_fast32_t seq = atomic_load_explicit(&unit_seq, memory_order_relaxed);
+    atomic_store_explicit(&unit_seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    writing = true;
+}
+
+static void write_end(void)
+{
+    uint_fast32_t seq = atomic_load_explicit(&unit_seq, memory_order_relaxed);
+    atomic_store_explicit(&unit_seq, seq + 1, memory_order_release);
+    writing = false;
+}
+
+/* Wait until no write is in progress; returns the sequence to validate against */
+static uint_fast32_t read_begin(void)
+{
+    uint_fast32_t seq;
+    int spins = 0;
+    while ((seq = atomic_load_explicit(&unit_seq, memory_order_acquire)) & 1) {
+        if (++spins >= UNIT_READ_SPINS) {
+            vTaskDelay(1);
+            spins = 0;
+        }
+    }
+    return seq;
+}
+
+static bool read_retry(uint_fast32_t seq)
+{
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(&unit_seq, memory_order_relaxed) != seq;
+}
+
+/*
+ * Drop silent units; replace a silent primary unit by the most recently
+ * heard other unit. Called with the write sequence held.
+ */
+static void unit_age(int64_t now, p1p2_hvac_state_t *primary, p1p2_decode_memo_t *memo)
+{
+    const int64_t timeout = (int64_t)P1P2_UNIT_TIMEOUT_MS * 1000;
+    unit_slot_t *newest = NULL;
+
+    for (int i = 0; i < P1P2_MAX_UNITS; i++) {
+        unit_slot_t *u = &units[i];
+        if (!u->used) continue;
+        if (now - u->last_seen_us > timeout) {
+            ESP_LOGI(TAG, "Unit 0x%02X silent, dropped", u->addr);
+            u->used = false;
+        } else if (!newest || u->last_seen_us > newest->last_seen_us) {
+            newest = u;
+        }
+    }
+
+    if (primary_set && newest && now - primary_seen_us > timeout) {
+        ESP_LOGI(TAG, "Primary unit 0x%02X silent, 0x%02X takes over", primary_addr, newest->addr);
+        memcpy(primary, &newest->state, sizeof(*primary));
+        primary->changed = UNIT_ALL_CHANGED;
+        primary_addr = newest->addr;
+        primary_packets = newest->packets;
+        primary_seen_us = newest->last_seen_us;
+        newest->used = false;
+        /* The memo's view of the primary state no longer holds */
+        p1p2_decode_memo_invalidate(memo);
+    }
+}
+
+void p1p2_unit_map_reset(void)
+{
+    memset(units, 0, sizeof(units));
+    primary_set = false;
+    primary_addr = 0;
+    primary_packets = 0;
+    primary_seen_us = 0;
+    last_age_check_us = 0;
+    units_dropped = 0;
+    writing = false;
+    atomic_store(&unit_seq, 0);
+}
+
+/*
+ * State a received packet decodes into: primary (the engine's state) or
+ * the unit's own slot, created on first sight. Returns NULL if the unit
+ * has no slot. memo is the engine's decode memo, invalidated when a state
+ * is created or replaced. Must be followed by p1p2_unit_map_end() once the
+ * packet is decoded. Called by the protocol task only.
+ */
+p1p2_hvac_state_t *p1p2_unit_map_begin(const p1p2_packet_t *pkt, p1p2_hvac_state_t *primary,
+                                       p1p2_decode_memo_t *memo)
+{
+    int64_t now = esp_timer_get_time();
+
+    if (now - last_age_check_us >= UNIT_AGE_CHECK_US) {
+        last_age_check_us = now;
+        write_begin();
+        unit_age(now, primary, memo);
+        write_end();
+    }
+
+    if (pkt->length < 3) return primary;
+    uint8_t addr = unit_addr(pkt);
+
+    write_begin();
+    if (!primary_set) {
+        primary_set = true;
+        primary_addr = addr;
+        ESP_LOGI(TAG, "Primary unit 0x%02X", addr);
+    }
+    if (addr == primary_addr) {
+        primary_seen_us = now;
+        primary_packets++;
+        write_end();
+        return primary;
+    }
+
+    unit_slot_t *u = unit_find(addr);
+    if (!u) {
+        u = unit_alloc(addr);
+        if (!u) {
+            units_dropped++;
+            write_end();
+            return NULL;
+        }
+        /* Memo entries from an earlier life of this unit describe a state it no longer has */
+        p1p2_decode_memo_invalidate(memo);
+        ESP_LOGI(TAG, "Unit 0x%02X added", addr);
+    }
+    u->last_seen_us = now;
+    u->packets++;
+    return &u->state;
+}
+
+void p1p2_unit_map_end(void)
+{
+    if (writing) write_end();
+}
+
+int p1p2_protocol_get_units(p1p2_unit_info_t *out, int max)
+{
+    int64_t now = esp_timer_get_time();
+    int n;
+    uint_fast32_t seq;
+
+    do {
+        seq = read_begin();
+        n = 0;
+        if (primary_set && n < max) {
+            out[n].addr = primary_addr;
+            out[n].primary = true;
+            out[n].packets = primary_packets;
+            out[n].age_ms = (uint32_t)((now - primary_seen_us) / 1000);
+            n++;
+        }
+        for (int i = 0; i < P1P2_MAX_UNITS && n < max; i++) {
+            const unit_slot_t *u = &units[i];
+            if (!u->used) continue;
+            out[n].addr = u->addr;
+            out[n].primary = false;
+            out[n].packets = u->packets;
+            out[n].age_ms = (uint32_t)((now - u->last_seen_us) / 1000);
+            n++;
+        }
+    } while (read_retry(seq));
+
+    return n;
+}
+
+esp_err_t p1p2_protocol_get_unit_state(uint8_t addr, p1p2_hvac_state_t *out)
+{
+    esp_err_t ret;
+    uint_fast32_t seq;
+    bool is_primary;
+
+    if (!out) return ESP_ERR_INVALID_ARG;
+
+    do {
+        seq = read_begin();
+        is_primary = primary_set && addr == primary_addr;
+        ret = ESP_ERR_NOT_FOUND;
+        if (!is_primary) {
+            const unit_slot_t *u = unit_find(addr);
+            if (u) {
+                memcpy(out, &u->state, sizeof(*out));
+                ret = ESP_OK;
+            }
+        }
+    } while (read_retry(seq));
+
+    if (is_primary) {
+        p1p2_protocol_read_state(out);
+        return ESP_OK;
+    }
+    out->changed = 0;
+    return ret;
+}
+
+uint32_t p1p2_protocol_get_units_dropped(void)
+{
+    return units_dropped;
+}
@@ -33,6 +33,8 @@
 
 #include "p1p2_bus.h"
 #include "p1p2_protocol.h"
+#include "p1p2_fixed.h"
+#include "p1p2_fseries.h"
 #include "p1p2_matter.h"
 #include "p1p2_network.h"
 
@@ -72,15 +74,16 @@ static void housekeeping_task(void *pvParameters)
                      (unsigned long)stats.parity_errors,
                      (unsigned long)stats.collision_errors);
 
-            const p1p2_hvac_state_t *state = p1p2_protocol_get_state();
-            if (state->data_valid) {
-                ESP_LOGI(TAG, "HVAC: power=%d mode=%d cool=%.1fC heat=%.1fC "
-                              "room=%.1fC outdoor=%.1fC",
-                         state->power, state->mode,
-                         state->target_temp_cool / 10.0,
-                         state->target_temp_heat / 10.0,
-                         state->room_temp / 10.0,
-                         state->outdoor_temp / 10.0);
+            p1p2_hvac_state_t state;
+            p1p2_protocol_read_state(&state);
+            if (state.data_valid) {
+                ESP_LOGI(TAG, "HVAC: power=%d mode=%d cool=" P1P2_FMT_X10 "C heat=" P1P2_FMT_X10 "C "
+                              "room=" P1P2_FMT_X10 "C outdoor=" P1P2_FMT_X10 "C",
+                         state.power, state.mode,
+                         P1P2_X10(state.target_temp_cool),
+                         P1P2_X10(state.target_temp_heat),
+                         P1P2_X10(state.room_temp),
+                         P1P2_X10(state.outdoor_temp));
             }
         }
 
@@ -160,7 +163,8 @@ void app_main(void)
     ESP_LOGI(TAG, "Initialization complete!");
     ESP_LOGI(TAG, "  Bus I/O:  RX=GPIO%d TX=GPIO%d",
              bus_config.gpio_rx, bus_config.gpio_tx);
-    ESP_LOGI(TAG, "  Model:    %d", CONFIG_P1P2_F_MODEL_ID);
+    ESP_LOGI(TAG, "  Model:    %d%s", p1p2_protocol_get_model(),
+             CONFIG_P1P2_F_MODEL_ID == F_MODEL_AUTO ? " (auto)" : "");
     ESP_LOGI(TAG, "  Control:  level %d", p1p2_protocol_get_control_level());
     ESP_LOGI(TAG, "  Thread:   %s", p1p2_thread_is_attached() ? "attached" : "not attached");
     ESP_LOGI(TAG, "  Matter:   %s", p1p2_matter_is_commissioned() ? "commissioned" : "not commissioned");
@@ -0,0 +1,87 @@
+/*
+ * Host benchmark corpus — one F-series bus cycle as seen on a BCL bus:
+ * the main controller's status packets to the indoor unit, a 0x38
+ * exchange with the auxiliary controller and a counter reply. And one
+ * E-series cycle: types 0x10-0x16, each a request from the main
+ * controller and a reply from the heat pump.
+ */
+
+#include <string.h>
+#include "p1p2_fseries.h"
+#include "p1p2_crc.h"
+#include "bench_corpus.h"
+
+typedef struct {
+    uint8_t len;                /* without CRC */
+    uint8_t data[P1P2_MAX_PACKET_SIZE];
+} corpus_entry_t;
+
+static const corpus_entry_t cycle_src[BENCH_CYCLE_LEN] = {
+    { 14, { 0x00, 0x80, 0x10, 0x01, 0x00, F_MODE_COOL, 0x00, 24, 0x00, F_FAN_MED, 0x00,
+            22, 0x00, F_FAN_LOW } },
+    { 11, { 0x00, 0x80, 0x11, 23, 0x00, (uint8_t)-5, 0x00, 0x00, 0x00, 0x00, 0x00 } },
+    { 15, { 0x00, 0x80, 0x12, 0x00, 0x07, 0x1A, 0x0E, 0x19, 0x0A, 0x12, 0x00, 0x00,
+            0x00, 0x00, 0x00 } },
+    {  8, { 0x00, 0x80, 0x13, 0x00, 0x00, 0x00, 0x00, 0x00 } },
+    { 11, { 0x00, 0x80, 0x14, 0x00, 0x3C, 0x00, 0x20, 0x00, 0x00, 0x00, 0x00 } },
+    { 11, { 0x00, 0x80, 0x15, 0x00, 45, 42, 0x01, 0x5E, 0x01, 0x2C, 0x00 } },
+    {  8, { 0x00, 0x80, 0x16, 0x00, 0x00, 0x00, 0x00, 0x00 } },
+    { 20, { 0x00, 0x40, 0x38, 0x01, 0x00, F_MODE_COOL | F_MODE_ACTIVE_MASK, 0x00, 24, 0x00,
+            F_FAN_MED, 0x00, 22, 0x00, F_FAN_LOW, 0x00, 0x00, 0x00, 0x00, 0x03, 0x00 } },
+    { 18, { 0x40, 0x00, 0x38, 0x01, 0x00, 24, 0x00, F_FAN_MED, 0x00, 22, 0x00,
+            F_FAN_LOW, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 } },
+    { 11, { 0x00, 0x80, 0xA3, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x64 } },
+};
+
+/* Temperatures f8.8: LWT 35.5, DHW 48.25, outside 5.0 / -2.5, RWT 30.0, room 21.0 */
+static const corpus_entry_t e_cycle_src[BENCH_E_CYCLE_LEN] = {
+    { 23, { 0x00, 0x00, 0x10, 0x01, 0x81, 0x01, 0x00, 0x2D, 0x00, 0x00, 0x00, 0x00, 0x00,
+            0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 } },
+    { 23, { 0x40, 0x00, 0x10, 0x01, 0x00, 0x02, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00,
+            0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 } },
+    { 11, { 0x00, 0x00, 0x11, 0x15, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 } },
+    { 21, { 0x40, 0x00, 0x11, 0x23, 0x80, 0x30, 0x40, 0x05, 0x00, 0x1E, 0x00, 0x1D, 0x00,
+            0x10, 0x00, 0x15, 0x00, 0xFD, 0x80, 0x00, 0x00 } },
+    { 23, { 0x00, 0x00, 0x12, 0x00, 0x05, 0x0E, 0x1A, 0x0A, 0x12, 0x00, 0x00, 0x00, 0x00,
+            0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 } },
+    { 23, { 0x40, 0x00, 0x12, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+            0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 } },
+    { 19, { 0x00, 0x00, 0x13, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+            0x00, 0x00, 0x00, 0x00, 0x00, 0x00 } },
+    { 19, { 0x40, 0x00, 0x13, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+            0x9A, 0x00, 0x00, 0x00, 0x00, 0x00 } },
+    { 21, { 0x00, 0x00, 0x14, 0x23, 0x00, 0x12, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+            0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 } },
+    { 21, { 0x40, 0x00, 0x14, 0x23, 0x00, 0x12, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+            0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 } },
+    { 17, { 0x00, 0x00, 0x15, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+            0x00, 0x00, 0x00, 0x00 } },
+    { 17, { 0x40, 0x00, 0x15, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+            0x00, 0x00, 0x00, 0x00 } },
+    { 20, { 0x00, 0x00, 0x16, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+            0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 } },
+    { 20, { 0x40, 0x00, 0x16, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+            0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 } },
+};
+
+static void corpus_fill(const corpus_entry_t *src, size_t n, p1p2_packet_t *out)
+{
+    for (size_t i = 0; i < n; i++) {
+        memset(&out[i], 0, sizeof(out[i]));
+        memcpy(out[i].data, src[i].data, src[i].len);
+        out[i].data[src[i].len] = p1p2_crc_calc(src[i].data, src[i].len,
+                                                F_SERIES_CRC_GEN, F_SERIES_CRC_FEED);
+        out[i].length = src[i].len + 1;
+    }
+}
+
+void bench_corpus_cycle(p1p2_packet_t *out)
+{
+    corpus_fill(cycle_src, BENCH_CYCLE_LEN, out);
+}
+
+/* E-series uses the same CRC as F-series */
+void bench_corpus_e_cycle(p1p2_packet_t *out)
+{
+    corpus_fill(e_cycle_src, BENCH_E_CYCLE_LEN, out);
+}
@@ -0,0 +1,24 @@
+/*
+ * Host benchmark corpus — one F-series bus cycle as seen on a BCL bus,
+ * and one E-series (Altherma) cycle
+ *
+ * Shared by p1p2_bench and p1p2_fleet.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "p1p2_bus_types.h"
+
+#define BENCH_CYCLE_LEN     10
+#define BENCH_CYCLE_REQ_38  7       /* index of the 0x38 request to the aux controller */
+#define BENCH_CYCLE_ROOM    1       /* index of the 0x11 packet carrying room temperature */
+
+#define BENCH_E_CYCLE_LEN   14
+#define BENCH_E_CYCLE_TEMPS 3       /* index of the 0x11 reply carrying the temperatures */
+
+/* Fill out[BENCH_CYCLE_LEN] with the cycle's packets, CRC appended */
+void bench_corpus_cycle(p1p2_packet_t *out);
+
+/* Fill out[BENCH_E_CYCLE_LEN] with the E-series cycle's packets, CRC appended */
+void bench_corpus_e_cycle(p1p2_packet_t *out);
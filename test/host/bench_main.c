@@ -0,0 +1,387 @@
+/*
+ * P1P2 Host Benchmarks — Decode, response building and CRC on Linux
+ *
+ * Runs the protocol-path sources (built against the stub ESP-IDF headers in
+ * stubs/) over a corpus of F-series packets as seen on a BCL bus (one bus
+ * cycle, see bench_corpus.c), and decode also over an E-series cycle. For each benchmark reports ns/packet,
+ * packets/s and heap allocations in the timed loop, and fails if a
+ * benchmark is slower than its budget or allocates at all.
+ *
+ * Usage: p1p2_bench [--json] [--iterations N] [--budget-scale X] [--no-check]
+ *   --json          print the report as JSON instead of a table
+ *   --iterations N  passes over the corpus per benchmark (default 20000)
+ *   --budget-scale  multiply all budgets, for slow or emulated machines
+ *   --no-check      report only, always exit 0
+ *
+ * Exit status: 0 all within budget, 1 a budget was exceeded, 2 bad usage.
+ *
+ * ESP32-C6 port: 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "p1p2_protocol.h"
+#include "p1p2_fseries.h"
+#include "p1p2_protocol_engine.h"
+#include "p1p2_crc.h"
+#include "bench_corpus.h"
+
+/* Internal entry points, as declared by their callers in the firmware */
+extern void p1p2_fseries_decode_packet(const p1p2_packet_t *pkt, p1p2_hvac_state_t *state);
+extern void p1p2_decode_select_family(int family);
+
+/* ================================================================
+ * Allocation counting (GNU ld --wrap, see CMakeLists.txt)
+ * ================================================================ */
+
+static long alloc_count;
+
+#ifdef P1P2_BENCH_WRAP_MALLOC
+extern void *__real_malloc(size_t size);
+extern void *__real_calloc(size_t n, size_t size);
+extern void *__real_realloc(void *p, size_t size);
+
+void *__wrap_malloc(size_t size)
+{
+    alloc_count++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t n, size_t size)
+{
+    alloc_count++;
+    return __real_calloc(n, size);
+}
+
+void *__wrap_realloc(void *p, size_t size)
+{
+    alloc_count++;
+    return __real_realloc(p, size);
+}
+#define ALLOCS_COUNTED  1
+#else
+#define ALLOCS_COUNTED  0
+#endif
+
+/* ================================================================
+ * Packet corpus
+ * ================================================================ */
+
+/* Requests the auxiliary controller answers, per model */
+static const uint8_t requests_bcl[] = { 0x38, 0x39, 0x35, 0x36, 0x37 };
+static const uint8_t requests_m[]   = { 0x3B, 0x3C, 0x35, 0x36, 0x37 };
+
+/* Byte diff (p1p2_byte_diff.c), not in a public header */
+extern void p1p2_byte_diff_reset(void);
+extern void p1p2_byte_diff_observe(const p1p2_packet_t *pkt);
+
+#define BENCH_DIFF_TYPES  8         /* fits the default table */
+
+static p1p2_packet_t cycle[BENCH_CYCLE_LEN];
+static p1p2_packet_t e_cycle[BENCH_E_CYCLE_LEN];
+static uint8_t rb_bcl[sizeof(requests_bcl)][P1P2_MAX_PACKET_SIZE];
+static uint8_t rb_m[sizeof(requests_m)][P1P2_MAX_PACKET_SIZE];
+static p1p2_hvac_state_t state;
+static p1p2_decode_memo_t memo;
+static p1p2_fseries_ctrl_t ctrl;
+static volatile uint32_t sink;  /* keeps results live */
+
+static void corpus_init(void)
+{
+    bench_corpus_cycle(cycle);
+    bench_corpus_e_cycle(e_cycle);
+
+    /* Control requests: the corpus 0x38 request, the others with a zero payload */
+    for (size_t i = 0; i < sizeof(requests_bcl); i++) {
+        memcpy(rb_bcl[i], cycle[BENCH_CYCLE_REQ_38].data, P1P2_MAX_PACKET_SIZE);
+        rb_bcl[i][2] = requests_bcl[i];
+        memcpy(rb_m[i], cycle[BENCH_CYCLE_REQ_38].data, P1P2_MAX_PACKET_SIZE);
+        rb_m[i][2] = requests_m[i];
+    }
+}
+
+/* ================================================================
+ * Benchmarks — each run is one pass, returning the packets processed
+ * ================================================================ */
+
+static uint32_t run_crc(void)
+{
+    uint32_t acc = 0;
+    for (size_t i = 0; i < BENCH_CYCLE_LEN; i++) {
+        acc += p1p2_crc_calc(cycle[i].data, cycle[i].length - 1,
+                             F_SERIES_CRC_GEN, F_SERIES_CRC_FEED);
+    }
+    sink += acc;
+    return BENCH_CYCLE_LEN;
+}
+
+static void setup_decode(void)
+{
+    memset(&state, 0, sizeof(state));
+}
+
+static uint32_t run_decode(void)
+{
+    for (size_t i = 0; i < BENCH_CYCLE_LEN; i++) {
+        p1p2_fseries_decode_packet(&cycle[i], &state);
+    }
+    sink += state.room_temp;
+    return BENCH_CYCLE_LEN;
+}
+
+static void setup_decode_e(void)
+{
+    memset(&state, 0, sizeof(state));
+    p1p2_decode_select_family(P1P2_FAMILY_E);
+}
+
+static void teardown_decode_e(void)
+{
+    p1p2_decode_select_family(P1P2_FAMILY_F);
+}
+
+/* Every temperature of the 0x11 reply moves on every pass */
+static uint32_t run_decode_e(void)
+{
+    static uint8_t pass;
+    pass++;
+    for (int off = 4; off < 20; off += 2) e_cycle[BENCH_E_CYCLE_TEMPS].data[off] = pass;
+
+    for (size_t i = 0; i < BENCH_E_CYCLE_LEN; i++) {
+        p1p2_fseries_decode_packet(&e_cycle[i], &state);
+    }
+    sink += state.outdoor_temp;
+    return BENCH_E_CYCLE_LEN;
+}
+
+static void setup_memo(void)
+{
+    memset(&state, 0, sizeof(state));
+    p1p2_decode_memo_reset(&memo);
+}
+
+/* As on the bus: mostly repeats, the room temperature moves now and then */
+static uint32_t run_memo(void)
+{
+    static uint32_t pass;
+    if ((++pass & 15) == 0) cycle[BENCH_CYCLE_ROOM].data[3] ^= 0x01;
+
+    for (size_t i = 0; i < BENCH_CYCLE_LEN; i++) {
+        p1p2_decode_memo_packet(&memo, &cycle[i], &state);
+    }
+    sink += state.room_temp;
+    return BENCH_CYCLE_LEN;
+}
+
+/*
+ * Byte diff at line rate: the corpus as if the decoder knew none of its
+ * types (a new family), mostly repeats with a byte moving now and then.
+ */
+static p1p2_packet_t diff_cycle[BENCH_DIFF_TYPES];
+
+static void setup_diff(void)
+{
+    p1p2_byte_diff_reset();
+    for (size_t i = 0; i < BENCH_DIFF_TYPES; i++) {
+        diff_cycle[i] = cycle[i];
+        diff_cycle[i].data[2] = 0x18 + i;
+    }
+}
+
+static uint32_t run_diff(void)
+{
+    static uint32_t pass;
+    if ((++pass & 15) == 0) diff_cycle[BENCH_CYCLE_ROOM].data[3] ^= 0x01;
+
+    for (size_t i = 0; i < BENCH_DIFF_TYPES; i++) {
+        diff_cycle[i].start_us = (int64_t)pass * 1000000;
+        p1p2_byte_diff_observe(&diff_cycle[i]);
+    }
+    return BENCH_DIFF_TYPES;
+}
+
+static uint8_t build_response(uint8_t type, const uint8_t *rb, uint8_t *wb)
+{
+    switch (type) {
+    case PKT_TYPE_CTRL_38: return p1p2_fseries_build_response_38(&ctrl, rb, 20, wb, P1P2_MAX_PACKET_SIZE);
+    case PKT_TYPE_CTRL_39: return p1p2_fseries_build_response_39(&ctrl, rb, 20, wb, P1P2_MAX_PACKET_SIZE);
+    case PKT_TYPE_CTRL_3B: return p1p2_fseries_build_response_3b(&ctrl, rb, 20, wb, P1P2_MAX_PACKET_SIZE);
+    case PKT_TYPE_CTRL_3C: return p1p2_fseries_build_response_3c(&ctrl, rb, 20, wb, P1P2_MAX_PACKET_SIZE);
+    default:               return p1p2_fseries_build_response_empty(&ctrl, rb, 20, wb, P1P2_MAX_PACKET_SIZE);
+    }
+}
+
+static void setup_response_bcl(void)
+{
+    p1p2_fseries_control_init(&ctrl, F_MODEL_BCL);
+}
+
+static uint32_t run_response_bcl(void)
+{
+    uint8_t wb[P1P2_MAX_PACKET_SIZE];
+    uint32_t acc = 0;
+    for (size_t i = 0; i < sizeof(requests_bcl); i++) {
+        acc += build_response(requests_bcl[i], rb_bcl[i], wb);
+    }
+    sink += acc;
+    return sizeof(requests_bcl);
+}
+
+static void setup_response_m(void)
+{
+    p1p2_fseries_control_init(&ctrl, F_MODEL_M);
+}
+
+static uint32_t run_response_m(void)
+{
+    uint8_t wb[P1P2_MAX_PACKET_SIZE];
+    uint32_t acc = 0;
+    for (size_t i = 0; i < sizeof(requests_m); i++) {
+        acc += build_response(requests_m[i], rb_m[i], wb);
+    }
+    sink += acc;
+    return sizeof(requests_m);
+}
+
+typedef struct {
+    const char *name;
+    void      (*setup)(void);
+    uint32_t  (*run)(void);
+    void      (*teardown)(void);
+    double      budget_ns;      /* max ns per packet */
+} bench_t;
+
+/*
+ * Budgets leave room for slow CI hosts (about 10x a current desktop);
+ * they catch algorithmic regressions, not small drifts.
+ */
+static const bench_t benches[] = {
+    { "crc",          NULL,               run_crc,          NULL,              1500.0 },
+    { "decode",       setup_decode,       run_decode,       NULL,              1000.0 },
+    { "decode_e",     setup_decode_e,     run_decode_e,     teardown_decode_e, 1000.0 },
+    { "decode_memo",  setup_memo,         run_memo,         NULL,              1000.0 },
+    { "response_bcl", setup_response_bcl, run_response_bcl, NULL,              100.0 },
+    { "response_m",   setup_response_m,   run_response_m,   NULL,              100.0 },
+    { "byte_diff",    setup_diff,         run_diff,         NULL,              1000.0 },
+};
+#define BENCH_COUNT  (sizeof(benches) / sizeof(benches[0]))
+
+typedef struct {
+    uint64_t packets;
+    double   ns_per_packet;
+    double   packets_per_s;
+    long     allocations;       /* -1 if not counted */
+    double   budget_ns;
+    bool     pass;
+} bench_result_t;
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void bench_run(const bench_t *b, uint32_t iterations, double scale, bench_result_t *r)
+{
+    if (b->setup) b->setup();
+
+    /* Warm caches and any first-use initialization outside the timed loop */
+    for (uint32_t i = 0; i < iterations / 10 + 1; i++) b->run();
+
+    uint64_t packets = 0;
+    alloc_count = 0;
+    int64_t t0 = now_ns();
+    for (uint32_t i = 0; i < iterations; i++) packets += b->run();
+    int64_t t1 = now_ns();
+    if (b->teardown) b->teardown();
+
+    r->packets = packets;
+    r->ns_per_packet = packets ? (double)(t1 - t0) / packets : 0.0;
+    r->packets_per_s = r->ns_per_packet > 0 ? 1e9 / r->ns_per_packet : 0.0;
+    r->allocations = ALLOCS_COUNTED ? alloc_count : -1;
+    r->budget_ns = b->budget_ns * scale;
+    r->pass = r->ns_per_packet <= r->budget_ns && r->allocations <= 0;
+}
+
+static void print_table(const bench_result_t *res, uint32_t iterations)
+{
+    printf("%-14s %12s %14s %7s %10s  %s\n",
+           "benchmark", "ns/packet", "packets/s", "allocs", "budget", "result");
+    for (size_t i = 0; i < BENCH_COUNT; i++) {
+        const bench_result_t *r = &res[i];
+        char allocs[24];
+        if (r->allocations < 0) snprintf(allocs, sizeof(allocs), "-");
+        else snprintf(allocs, sizeof(allocs), "%ld", r->allocations);
+        printf("%-14s %12.1f %14.0f %7s %10.0f  %s\n",
+               benches[i].name, r->ns_per_packet, r->packets_per_s, allocs,
+               r->budget_ns, r->pass ? "ok" : "OVER BUDGET");
+    }
+    printf("(%u passes per benchmark, %u-packet corpus, %u for E-series)\n", iterations,
+           (unsigned)BENCH_CYCLE_LEN, (unsigned)BENCH_E_CYCLE_LEN);
+}
+
+static void print_json(const bench_result_t *res, uint32_t iterations, bool pass)
+{
+    printf("{\n  \"iterations\": %u,\n  \"allocations_counted\": %s,\n  \"benchmarks\": [\n",
+           iterations, ALLOCS_COUNTED ? "true" : "false");
+    for (size_t i = 0; i < BENCH_COUNT; i++) {
+        const bench_result_t *r = &res[i];
+        printf("    {\"name\": \"%s\", \"packets\": %llu, \"ns_per_packet\": %.1f, "
+               "\"packets_per_s\": %.0f, \"allocations\": %ld, \"budget_ns\": %.0f, "
+               "\"pass\": %s}%s\n",
+               benches[i].name, (unsigned long long)r->packets, r->ns_per_packet,
+               r->packets_per_s, r->allocations, r->budget_ns,
+               r->pass ? "true" : "false", i + 1 < BENCH_COUNT ? "," : "");
+    }
+    printf("  ],\n  \"pass\": %s\n}\n", pass ? "true" : "false");
+}
+
+static int usage(const char *prog)
+{
+    fprintf(stderr, "Usage: %s [--json] [--iterations N] [--budget-scale X] [--no-check]\n", prog);
+    return 2;
+}
+
+int main(int argc, char **argv)
+{
+    bool json = false;
+    bool check = true;
+    uint32_t iterations = 20000;
+    double scale = 1.0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0) {
+            json = true;
+        } else if (strcmp(argv[i], "--no-check") == 0) {
+            check = false;
+        } else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            long n = strtol(argv[++i], NULL, 10);
+            if (n <= 0) return usage(argv[0]);
+            iterations = (uint32_t)n;
+        } else if (strcmp(argv[i], "--budget-scale") == 0 && i + 1 < argc) {
+            scale = strtod(argv[++i], NULL);
+            if (scale <= 0) return usage(argv[0]);
+        } else {
+            return usage(argv[0]);
+        }
+    }
+
+    corpus_init();
+
+    bench_result_t res[BENCH_COUNT];
+    bool pass = true;
+    for (size_t i = 0; i < BENCH_COUNT; i++) {
+        bench_run(&benches[i], iterations, scale, &res[i]);
+        pass = pass && res[i].pass;
+    }
+
+    if (json) {
+        print_json(res, iterations, pass);
+    } else {
+        print_table(res, iterations);
+    }
+    return (check && !pass) ? 1 : 0;
+}
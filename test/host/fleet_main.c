@@ -0,0 +1,442 @@
+/*
+ * P1P2 Host Fleet Benchmark — Many protocol engines on a thread pool
+ *
+ * Runs N independent protocol engines (p1p2_protocol_engine.h), each
+ * replaying the same bus traffic as if it were its own bus, on a pool of
+ * worker threads, and reports the CPU one engine costs per second of bus
+ * traffic: the capacity of a multi-bus gateway or of an off-device
+ * bus-processing service.
+ *
+ * Traffic is a capture from the CLI monitor command (M): one packet per
+ * line, "R <delta ms> <hex bytes incl. CRC> [ERR]", other lines ignored.
+ * Without one, 64 cycles of the benchmark corpus (bench_corpus.c) are used,
+ * at a nominal FLEET_CYCLE_MS per cycle, with the room temperature moving
+ * every 16 cycles. Every engine acts as auxiliary controller, detects its
+ * model from the traffic and then gets a setpoint command every few
+ * passes, so model detection and the pending-write path run as well.
+ *
+ * Each worker thread owns the engines i with i % threads == its index, and
+ * runs one pass over the traffic on each of them in turn, so all engines
+ * advance together as on a live gateway. CPU time is taken per thread
+ * (CLOCK_THREAD_CPUTIME_ID). Engines get setpoints from FLEET_SETPOINTS
+ * classes; every engine's responses and final state must match a
+ * single-threaded reference engine of its class, which catches any state
+ * shared between engines.
+ *
+ * Usage: p1p2_fleet [--json] [--instances N] [--threads T] [--passes P]
+ *                   [--trace FILE] [--budget-scale X] [--no-check]
+ *   --instances N   engines (default 256)
+ *   --threads T     worker threads (default: online CPUs)
+ *   --passes P      passes over the traffic per engine (default 20)
+ *   --trace FILE    replay a monitor capture instead of the built-in cycles
+ *   --budget-scale  multiply the CPU budget, for slow or emulated machines
+ *   --no-check      report only, exit 0 unless engines disagree
+ *
+ * Exit status: 0 ok, 1 over budget or an engine disagrees with its
+ * reference, 2 bad usage or unreadable trace.
+ *
+ * ESP32-C6 port: 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "p1p2_protocol.h"
+#include "p1p2_protocol_engine.h"
+#include "p1p2_fseries.h"
+#include "p1p2_crc.h"
+#include "bench_corpus.h"
+
+/* Internal entry point, as declared by its callers in the firmware */
+extern void p1p2_decode_select_family(int family);
+
+#define FLEET_CYCLES        64          /* built-in traffic: corpus cycles */
+#define FLEET_CYCLE_MS      1000        /* built-in traffic: nominal cycle period */
+#define FLEET_SETPOINTS     8           /* setpoint classes, one reference engine each */
+#define FLEET_CMD_PASSES    4           /* a setpoint command every this many passes */
+#define FLEET_BUDGET_NS     3000.0      /* max CPU ns per packet per engine */
+#define FLEET_CTX_ALIGN     64          /* contexts on their own cache lines */
+
+/* ================================================================
+ * Traffic
+ * ================================================================ */
+
+static p1p2_packet_t *trace;
+static size_t   trace_len;
+static int64_t  trace_ms;               /* bus time covered by one pass */
+
+static int trace_add(const p1p2_packet_t *pkt)
+{
+    static size_t cap;
+    if (trace_len == cap) {
+        size_t n = cap ? cap * 2 : 1024;
+        p1p2_packet_t *t = realloc(trace, n * sizeof(*t));
+        if (!t) return -1;
+        trace = t;
+        cap = n;
+    }
+    trace[trace_len++] = *pkt;
+    return 0;
+}
+
+static int hex_nibble(int c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    c = tolower(c);
+    return (c >= 'a' && c <= 'f') ? c - 'a' + 10 : -1;
+}
+
+/* "R <delta> <hex> [ERR]" lines of a monitor (M) capture */
+static int trace_load(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        char *p = line;
+        if (*p++ != 'R' || *p != ' ') continue;
+
+        char *end;
+        long delta = strtol(p, &end, 10);
+        if (end == p || delta < 0) continue;
+        p = end;
+        while (*p == ' ') p++;
+
+        p1p2_packet_t pkt;
+        memset(&pkt, 0, sizeof(pkt));
+        while (pkt.length < P1P2_MAX_PACKET_SIZE) {
+            int hi = hex_nibble(p[0]);
+            int lo = hi < 0 ? -1 : hex_nibble(p[1]);
+            if (lo < 0) break;
+            pkt.data[pkt.length++] = (uint8_t)(hi << 4 | lo);
+            p += 2;
+        }
+        if (pkt.length == 0) continue;
+        pkt.has_error = strstr(p, "ERR") != NULL;
+        pkt.delta = (uint16_t)(delta > 0xFFFF ? 0xFFFF : delta);
+        trace_ms += delta;
+        if (trace_add(&pkt) != 0) {
+            fclose(f);
+            return -1;
+        }
+    }
+    fclose(f);
+
+    if (trace_len == 0) {
+        fprintf(stderr, "%s: no monitor lines (\"R <delta> <hex>\")\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+static int trace_builtin(void)
+{
+    p1p2_packet_t cycle[BENCH_CYCLE_LEN];
+    bench_corpus_cycle(cycle);
+
+    for (int c = 0; c < FLEET_CYCLES; c++) {
+        p1p2_packet_t *room = &cycle[BENCH_CYCLE_ROOM];
+        if (c % 16 == 15) {
+            room->data[3] ^= 0x01;
+            room->data[room->length - 1] = p1p2_crc_calc(room->data, room->length - 1,
+                                                         F_SERIES_CRC_GEN, F_SERIES_CRC_FEED);
+        }
+        for (size_t i = 0; i < BENCH_CYCLE_LEN; i++) {
+            cycle[i].delta = (uint16_t)(FLEET_CYCLE_MS / BENCH_CYCLE_LEN);
+            if (trace_add(&cycle[i]) != 0) return -1;
+        }
+    }
+    trace_ms = (int64_t)FLEET_CYCLES * FLEET_CYCLE_MS;
+    return 0;
+}
+
+/* ================================================================
+ * Engines
+ * ================================================================ */
+
+typedef struct {
+    p1p2_protocol_t eng;
+    uint32_t checksum;              /* over all responses, then the final state */
+    uint64_t responses;
+} instance_t;
+
+static size_t instance_stride;
+static uint8_t *instances;
+
+static instance_t *instance(size_t i)
+{
+    return (instance_t *)(instances + i * instance_stride);
+}
+
+static void instance_init(instance_t *in)
+{
+    memset(in, 0, sizeof(*in));
+    p1p2_engine_init(&in->eng, F_MODEL_AUTO, P1P2_CONTROL_AUX, true);
+    p1p2_fseries_model_detect_start(&in->eng.ctrl);
+    in->checksum = 2166136261u;
+}
+
+static inline uint32_t fnv(uint32_t h, const uint8_t *p, size_t len)
+{
+    for (size_t i = 0; i < len; i++) h = (h ^ p[i]) * 16777619u;
+    return h;
+}
+
+/* One pass over the traffic. pass selects when the setpoint command is due. */
+static void instance_pass(instance_t *in, size_t setpoint_class, uint32_t pass)
+{
+    p1p2_protocol_t *eng = &in->eng;
+
+    if (pass % FLEET_CMD_PASSES == 0 &&
+        p1p2_fseries_control_get_model(&eng->ctrl) != F_MODEL_AUTO) {
+        p1p2_control_cmd_t cmd = {
+            .type = P1P2_CMD_SET_TEMP_COOL,
+            .value = 180 + 10 * (int32_t)setpoint_class,
+        };
+        p1p2_fseries_apply_command(&eng->ctrl, &cmd);
+    }
+
+    uint8_t wb[P1P2_MAX_PACKET_SIZE];
+    for (size_t i = 0; i < trace_len; i++) {
+        uint8_t n = p1p2_engine_process(eng, &trace[i], wb, sizeof(wb));
+        if (n) {
+            in->checksum = fnv(in->checksum, wb, n);
+            in->responses++;
+        }
+    }
+}
+
+/* Fold the decoded state (less timestamps) into the checksum */
+static void instance_finish(instance_t *in)
+{
+    const p1p2_hvac_state_t *s = &in->eng.state;
+    int32_t v[] = {
+        s->power, s->mode, s->target_temp_cool, s->target_temp_heat, s->room_temp,
+        s->outdoor_temp, s->fan_mode_cool, s->fan_mode_heat, (int32_t)s->operation_hours,
+        (int32_t)s->packet_count, s->data_valid,
+    };
+    in->checksum = fnv(in->checksum, (const uint8_t *)v, sizeof(v));
+}
+
+/* ================================================================
+ * Thread pool
+ * ================================================================ */
+
+typedef struct {
+    pthread_t thread;
+    size_t    index;
+    size_t    threads;
+    size_t    instances;
+    uint32_t  passes;
+    int64_t   cpu_ns;
+} worker_t;
+
+static int64_t clock_ns(clockid_t id)
+{
+    struct timespec ts;
+    clock_gettime(id, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void *worker_main(void *arg)
+{
+    worker_t *w = arg;
+    int64_t t0 = clock_ns(CLOCK_THREAD_CPUTIME_ID);
+
+    for (uint32_t pass = 0; pass < w->passes; pass++) {
+        for (size_t i = w->index; i < w->instances; i += w->threads) {
+            instance_pass(instance(i), i % FLEET_SETPOINTS, pass);
+        }
+    }
+    for (size_t i = w->index; i < w->instances; i += w->threads) {
+        instance_finish(instance(i));
+    }
+
+    w->cpu_ns = clock_ns(CLOCK_THREAD_CPUTIME_ID) - t0;
+    return NULL;
+}
+
+/* ================================================================
+ * Report
+ * ================================================================ */
+
+typedef struct {
+    size_t   instances;
+    size_t   threads;
+    uint32_t passes;
+    uint64_t packets;               /* all engines */
+    uint64_t responses;
+    double   wall_s;
+    double   cpu_s;
+    double   ns_per_packet;         /* CPU */
+    double   cpu_us_per_bus_s;      /* CPU per engine per second of bus traffic */
+    double   buses_per_core;
+    double   budget_ns;
+    size_t   mismatches;
+    bool     pass;
+} fleet_result_t;
+
+static void print_table(const fleet_result_t *r, const char *source)
+{
+    printf("traffic:        %s, %zu packets, %.1f s of bus time per pass\n",
+           source, trace_len, trace_ms / 1000.0);
+    printf("engines:        %zu on %zu threads, %u passes, %zu bytes per context\n",
+           r->instances, r->threads, r->passes, sizeof(p1p2_protocol_t));
+    printf("packets:        %llu (%llu responses)\n",
+           (unsigned long long)r->packets, (unsigned long long)r->responses);
+    printf("wall / CPU:     %.3f s / %.3f s\n", r->wall_s, r->cpu_s);
+    printf("CPU per packet: %.1f ns (budget %.0f)\n", r->ns_per_packet, r->budget_ns);
+    printf("CPU per bus:    %.1f us per bus-second (%.4f %% of a core)\n",
+           r->cpu_us_per_bus_s, r->cpu_us_per_bus_s / 1e4);
+    printf("buses per core: %.0f\n", r->buses_per_core);
+    printf("isolation:      %s\n", r->mismatches ? "ENGINES DISAGREE" : "ok");
+    printf("result:         %s\n", r->pass ? "ok" : "FAIL");
+}
+
+static void print_json(const fleet_result_t *r, const char *source)
+{
+    printf("{\n  \"traffic\": {\"source\": \"%s\", \"packets\": %zu, \"bus_ms\": %lld},\n",
+           source, trace_len, (long long)trace_ms);
+    printf("  \"instances\": %zu,\n  \"threads\": %zu,\n  \"passes\": %u,\n",
+           r->instances, r->threads, r->passes);
+    printf("  \"context_bytes\": %zu,\n", sizeof(p1p2_protocol_t));
+    printf("  \"packets\": %llu,\n  \"responses\": %llu,\n",
+           (unsigned long long)r->packets, (unsigned long long)r->responses);
+    printf("  \"wall_s\": %.3f,\n  \"cpu_s\": %.3f,\n", r->wall_s, r->cpu_s);
+    printf("  \"ns_per_packet\": %.1f,\n  \"budget_ns\": %.0f,\n", r->ns_per_packet, r->budget_ns);
+    printf("  \"cpu_us_per_bus_s\": %.2f,\n  \"buses_per_core\": %.0f,\n",
+           r->cpu_us_per_bus_s, r->buses_per_core);
+    printf("  \"mismatches\": %zu,\n  \"pass\": %s\n}\n", r->mismatches, r->pass ? "true" : "false");
+}
+
+static int usage(const char *prog)
+{
+    fprintf(stderr, "Usage: %s [--json] [--instances N] [--threads T] [--passes P]\n"
+                    "       [--trace FILE] [--budget-scale X] [--no-check]\n", prog);
+    return 2;
+}
+
+int main(int argc, char **argv)
+{
+    bool json = false;
+    bool check = true;
+    long n_instances = 256;
+    long n_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    long passes = 20;
+    double scale = 1.0;
+    const char *trace_path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0) {
+            json = true;
+        } else if (strcmp(argv[i], "--no-check") == 0) {
+            check = false;
+        } else if (strcmp(argv[i], "--instances") == 0 && i + 1 < argc) {
+            n_instances = strtol(argv[++i], NULL, 10);
+            if (n_instances <= 0) return usage(argv[0]);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            n_threads = strtol(argv[++i], NULL, 10);
+            if (n_threads <= 0) return usage(argv[0]);
+        } else if (strcmp(argv[i], "--passes") == 0 && i + 1 < argc) {
+            passes = strtol(argv[++i], NULL, 10);
+            if (passes <= 0) return usage(argv[0]);
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else if (strcmp(argv[i], "--budget-scale") == 0 && i + 1 < argc) {
+            scale = strtod(argv[++i], NULL);
+            if (scale <= 0) return usage(argv[0]);
+        } else {
+            return usage(argv[0]);
+        }
+    }
+    if (n_threads < 1) n_threads = 1;
+    if (n_threads > n_instances) n_threads = n_instances;
+
+    /* Shared, read-only once built: must precede every engine */
+    p1p2_decode_select_family(P1P2_FAMILY_F);
+
+    if ((trace_path ? trace_load(trace_path) : trace_builtin()) != 0) return 2;
+    if (trace_ms <= 0) trace_ms = 1;
+
+    instance_stride = (sizeof(instance_t) + FLEET_CTX_ALIGN - 1) & ~(size_t)(FLEET_CTX_ALIGN - 1);
+    void *mem;
+    if (posix_memalign(&mem, FLEET_CTX_ALIGN, instance_stride * (size_t)n_instances) != 0) {
+        fprintf(stderr, "Out of memory for %ld engines\n", n_instances);
+        return 2;
+    }
+    instances = mem;
+
+    /* Single-threaded reference per setpoint class */
+    static instance_t reference[FLEET_SETPOINTS];
+    for (size_t c = 0; c < FLEET_SETPOINTS; c++) {
+        instance_init(&reference[c]);
+        for (uint32_t p = 0; p < (uint32_t)passes; p++) instance_pass(&reference[c], c, p);
+        instance_finish(&reference[c]);
+    }
+
+    for (size_t i = 0; i < (size_t)n_instances; i++) instance_init(instance(i));
+
+    worker_t *workers = calloc((size_t)n_threads, sizeof(*workers));
+    if (!workers) return 2;
+
+    int64_t wall0 = clock_ns(CLOCK_MONOTONIC);
+    for (size_t t = 0; t < (size_t)n_threads; t++) {
+        workers[t] = (worker_t){
+            .index = t, .threads = (size_t)n_threads,
+            .instances = (size_t)n_instances, .passes = (uint32_t)passes,
+        };
+        if (pthread_create(&workers[t].thread, NULL, worker_main, &workers[t]) != 0) {
+            fprintf(stderr, "pthread_create failed\n");
+            return 2;
+        }
+    }
+    int64_t cpu_ns = 0;
+    for (size_t t = 0; t < (size_t)n_threads; t++) {
+        pthread_join(workers[t].thread, NULL);
+        cpu_ns += workers[t].cpu_ns;
+    }
+    int64_t wall_ns = clock_ns(CLOCK_MONOTONIC) - wall0;
+
+    fleet_result_t r = {
+        .instances = (size_t)n_instances,
+        .threads = (size_t)n_threads,
+        .passes = (uint32_t)passes,
+        .packets = (uint64_t)n_instances * (uint64_t)passes * trace_len,
+        .wall_s = wall_ns / 1e9,
+        .cpu_s = cpu_ns / 1e9,
+        .budget_ns = FLEET_BUDGET_NS * scale,
+    };
+    for (size_t i = 0; i < r.instances; i++) {
+        const instance_t *in = instance(i);
+        const instance_t *ref = &reference[i % FLEET_SETPOINTS];
+        r.responses += in->responses;
+        if (in->checksum != ref->checksum || in->responses != ref->responses) r.mismatches++;
+    }
+    r.ns_per_packet = (double)cpu_ns / (double)r.packets;
+    double bus_s = (double)r.instances * (double)passes * (double)trace_ms / 1000.0;
+    r.cpu_us_per_bus_s = cpu_ns / 1000.0 / bus_s;
+    r.buses_per_core = r.cpu_us_per_bus_s > 0 ? 1e6 / r.cpu_us_per_bus_s : 0;
+    r.pass = r.mismatches == 0 && r.ns_per_packet <= r.budget_ns;
+
+    const char *source = trace_path ? trace_path : "built-in";
+    if (json) {
+        print_json(&r, source);
+    } else {
+        print_table(&r, source);
+    }
+
+    free(workers);
+    free(instances);
+    free(trace);
+
+    if (r.mismatches) return 1;
+    return (check && !r.pass) ? 1 : 0;
+}
@@ -0,0 +1,17 @@
+/*
+ * Host stub of esp_timer.h — monotonic clock in µs.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int64_t esp_timer_get_time(void);
+
+#ifdef __cplusplus
+}
+#endif
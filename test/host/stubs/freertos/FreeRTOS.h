@@ -0,0 +1,26 @@
+/*
+ * Host stub of FreeRTOS.h — types and critical sections. Critical sections
+ * are empty: the host programs only run engine code, which takes none
+ * (p1p2_fleet's threads each own their engines).
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+typedef int          BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t     TickType_t;
+
+#define pdTRUE              1
+#define pdFALSE             0
+#define pdPASS              1
+#define pdMS_TO_TICKS(ms)   ((TickType_t)(ms))
+#define portMAX_DELAY       0xFFFFFFFFu
+
+typedef struct { int unused; } portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED  { 0 }
+#define portENTER_CRITICAL(mux)       ((void)(mux))
+#define portEXIT_CRITICAL(mux)        ((void)(mux))
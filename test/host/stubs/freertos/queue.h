@@ -0,0 +1,10 @@
+/*
+ * Host stub of queue.h — handle type only; the benchmarked code does not
+ * touch queues.
+ */
+
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef void *QueueHandle_t;
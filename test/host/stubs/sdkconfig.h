@@ -0,0 +1,9 @@
+/*
+ * Host stub of sdkconfig.h — the Kconfig defaults the benchmarks build with.
+ */
+
+#pragma once
+
+#define CONFIG_P1P2_F_SERIES        1
+#define CONFIG_P1P2_F_MODEL_ID      0
+#define CONFIG_P1P2_CONTROL_LEVEL   1
@@ -10,32 +10,53 @@
 
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include "unity.h"
 #include "p1p2_protocol.h"
+#include "p1p2_protocol_engine.h"
 #include "p1p2_fseries.h"
+#include "p1p2_bus.h"
 #include "p1p2_bus_types.h"
+#include "p1p2_crc.h"
+#include "p1p2_fixed.h"
+#include "p1p2_hist.h"
+#include "p1p2_traffic_stats.h"
+#include "p1p2_bus_load.h"
+#include "p1p2_bus_schedule.h"
+#include "esp_timer.h"
 
 /* External decode function from p1p2_fseries_decode.c */
 extern void p1p2_fseries_decode_packet(const p1p2_packet_t *pkt, p1p2_hvac_state_t *state);
 extern void p1p2_log_packet(const p1p2_packet_t *pkt, const char *prefix);
 
-/* External control functions from p1p2_fseries_control.c */
-extern void    p1p2_fseries_control_init(int model);
-extern uint8_t p1p2_fseries_build_response_38(const uint8_t *rb, uint8_t rb_len,
-                                               uint8_t *wb, uint8_t wb_max);
-extern uint8_t p1p2_fseries_build_response_3b(const uint8_t *rb, uint8_t rb_len,
-                                               uint8_t *wb, uint8_t wb_max);
-extern uint8_t p1p2_fseries_build_response_39(const uint8_t *rb, uint8_t rb_len,
-                                               uint8_t *wb, uint8_t wb_max);
-extern uint8_t p1p2_fseries_build_response_3a(const uint8_t *rb, uint8_t rb_len,
-                                               uint8_t *wb, uint8_t wb_max);
-extern uint8_t p1p2_fseries_build_response_3c(const uint8_t *rb, uint8_t rb_len,
-                                               uint8_t *wb, uint8_t wb_max);
-extern uint8_t p1p2_fseries_build_response_empty(const uint8_t *rb, uint8_t rb_len,
-                                                  uint8_t *wb, uint8_t wb_max);
-extern esp_err_t p1p2_fseries_queue_write(uint8_t packet_type, uint8_t payload_offset,
-                                           uint8_t value, uint8_t mask, uint8_t count);
-extern esp_err_t p1p2_fseries_apply_command(const p1p2_control_cmd_t *cmd);
+/* Unit map from p1p2_unit_map.c (used by the protocol task) */
+extern void p1p2_unit_map_reset(void);
+extern p1p2_hvac_state_t *p1p2_unit_map_begin(const p1p2_packet_t *pkt, p1p2_hvac_state_t *primary,
+                                              p1p2_decode_memo_t *memo);
+extern void p1p2_unit_map_end(void);
+
+/* Raw payload store from p1p2_payload_store.c */
+extern void p1p2_decode_select_family(int family);
+extern void p1p2_payload_store_init(void);
+extern void p1p2_payload_store_update(const p1p2_packet_t *pkt);
+
+/* Engine parts under test: decode memo and F-series control (p1p2_protocol_engine.h) */
+static p1p2_decode_memo_t  test_memo;
+static p1p2_fseries_ctrl_t test_ctrl;
+
+/* Protocol task services: pairing, bus clock, counter polling, byte diff */
+extern void      p1p2_pair_stats_record(const uint8_t *hdr, uint8_t length,
+                                        int64_t start_us, int64_t eop_us);
+extern void      p1p2_bus_clock_observe(const uint8_t *data, uint8_t length, int64_t start_us);
+extern void      p1p2_counter_poll_reset(void);
+extern void      p1p2_counter_poll_tick(int64_t now_us);
+extern bool      p1p2_counter_poll_due(int64_t now_us);
+extern void      p1p2_counter_poll_queued(int64_t now_us, esp_err_t ret);
+extern void      p1p2_counter_poll_observe(const p1p2_packet_t *pkt);
+extern void      p1p2_counter_poll_confirmed(const p1p2_tx_confirm_t *conf);
+extern void      p1p2_byte_diff_reset(void);
+extern void      p1p2_byte_diff_observe(const p1p2_packet_t *pkt);
+extern void      p1p2_byte_diff_tick(int64_t now_us);
 
 /* ================================================================
  * Helper: build a test packet
@@ -530,13 +551,375 @@ TEST_CASE("decode: unhandled packet type is safe", "[decode]")
     TEST_ASSERT_EQUAL(1, state.packet_count);
 }
 
+TEST_CASE("decode: 0x3B control request — shared status fields and zones", "[decode]")
+{
+    p1p2_hvac_state_t state;
+    memset(&state, 0, sizeof(state));
+
+    /* 0x3B payload: status fields as in 0x10, zones at payload[17] */
+    uint8_t raw[3 + 18 + 1] = {0x00, 0x40, 0x3B};
+    raw[3 + 0] = 0x01;   /* power on */
+    raw[3 + 2] = 0x01;   /* heat */
+    raw[3 + 8] = 21;     /* heat target */
+    raw[3 + 10] = 0x51;  /* heat fan high */
+    raw[3 + 17] = 0x05;  /* zones 0 and 2 */
+    p1p2_packet_t pkt = make_packet(raw, sizeof(raw));
+
+    p1p2_fseries_decode_packet(&pkt, &state);
+
+    TEST_ASSERT_TRUE(state.power);
+    TEST_ASSERT_EQUAL(P1P2_MODE_HEAT, state.mode);
+    TEST_ASSERT_EQUAL(210, state.target_temp_heat);
+    TEST_ASSERT_EQUAL(P1P2_FAN_HIGH, state.fan_mode_heat);
+    TEST_ASSERT_EQUAL_HEX8(0x05, state.active_zones);
+    TEST_ASSERT_TRUE(state.data_valid);
+    TEST_ASSERT_TRUE(state.changed & CHANGED_ZONES);
+    /* 0x3B does not derive running state (only 0x10 does) */
+    TEST_ASSERT_EQUAL(P1P2_RUNNING_IDLE, state.running);
+
+    /* Short 0x3B: zones byte absent, left unchanged */
+    state.changed = 0;
+    p1p2_packet_t short_pkt = make_packet(raw, 3 + 11 + 1);
+    p1p2_fseries_decode_packet(&short_pkt, &state);
+    TEST_ASSERT_EQUAL_HEX8(0x05, state.active_zones);
+    TEST_ASSERT_EQUAL(0, state.changed);
+}
+
+TEST_CASE("decode: memo skips repeats but not after another type changed state", "[decode]")
+{
+    p1p2_hvac_state_t state;
+    memset(&state, 0, sizeof(state));
+    p1p2_decode_memo_reset(&test_memo);
+
+    uint8_t raw10[] = {0x00, 0x80, 0x10, 0x01, 0x00, 0x02, 0x00, 24, 0x00,
+                       0x31, 0x00, 22, 0x00, 0x11, 0xAA};
+    uint8_t raw38[] = {0x00, 0x40, 0x38, 0x00, 0x00, 0x02, 0x00, 24, 0x00,
+                       0x31, 0x00, 22, 0x00, 0x11, 0xAA};
+    p1p2_packet_t p10 = make_packet(raw10, sizeof(raw10));
+    p1p2_packet_t p38 = make_packet(raw38, sizeof(raw38));
+
+    p1p2_decode_memo_packet(&test_memo, &p10, &state);
+    p1p2_decode_memo_packet(&test_memo, &p10, &state);
+    TEST_ASSERT_EQUAL(1, test_memo.skipped);
+    TEST_ASSERT_EQUAL(1, test_memo.decoded);
+    TEST_ASSERT_EQUAL(2, state.packet_count);
+    TEST_ASSERT_TRUE(state.power);
+
+    /* 0x38 turns power off; the unchanged 0x10 must turn it back on */
+    p1p2_decode_memo_packet(&test_memo, &p38, &state);
+    TEST_ASSERT_FALSE(state.power);
+    state.changed = 0;
+    p1p2_decode_memo_packet(&test_memo, &p10, &state);
+    TEST_ASSERT_TRUE(state.power);
+    TEST_ASSERT_TRUE(state.changed & CHANGED_POWER);
+
+    /* Changed byte: only that field is decoded, the rest stays */
+    raw10[7] = 25;
+    p10 = make_packet(raw10, sizeof(raw10));
+    state.changed = 0;
+    p1p2_decode_memo_packet(&test_memo, &p10, &state);
+    TEST_ASSERT_EQUAL(250, state.target_temp_cool);
+    TEST_ASSERT_EQUAL(CHANGED_TEMP_COOL, state.changed);
+}
+
+static void unit_decode(const uint8_t *raw, size_t len, p1p2_hvac_state_t *primary)
+{
+    p1p2_packet_t pkt = make_packet(raw, len);
+    p1p2_hvac_state_t *st = p1p2_unit_map_begin(&pkt, primary, &test_memo);
+    if (st) p1p2_decode_memo_packet(&test_memo, &pkt, st);
+    p1p2_unit_map_end();
+    if (st == primary) p1p2_payload_store_update(&pkt);  /* as the protocol task */
+}
+
+TEST_CASE("units: each bus address decodes into its own state", "[decode]")
+{
+    p1p2_hvac_state_t primary, unit;
+    memset(&primary, 0, sizeof(primary));
+    p1p2_decode_memo_reset(&test_memo);
+    p1p2_unit_map_reset();
+
+    uint8_t raw_a[] = {0x00, 0x80, 0x10, 0x01, 0x00, 0x02, 0x00, 24, 0x00,
+                       0x31, 0x00, 22, 0x00, 0x11, 0xAA};
+    uint8_t raw_b[] = {0x01, 0x80, 0x10, 0x00, 0x00, 0x02, 0x00, 20, 0x00,
+                       0x31, 0x00, 22, 0x00, 0x11, 0xAA};
+    unit_decode(raw_a, sizeof(raw_a), &primary);
+    unit_decode(raw_b, sizeof(raw_b), &primary);
+    unit_decode(raw_a, sizeof(raw_a), &primary);
+
+    TEST_ASSERT_TRUE(primary.power);
+    TEST_ASSERT_EQUAL(240, primary.target_temp_cool);
+    TEST_ASSERT_EQUAL(2, primary.packet_count);
+    TEST_ASSERT_EQUAL(ESP_OK, p1p2_protocol_get_unit_state(0x01, &unit));
+    TEST_ASSERT_FALSE(unit.power);
+    TEST_ASSERT_EQUAL(200, unit.target_temp_cool);
+
+    p1p2_unit_info_t info[4];
+    TEST_ASSERT_EQUAL(2, p1p2_protocol_get_units(info, 4));
+    TEST_ASSERT_TRUE(info[0].primary);
+    TEST_ASSERT_EQUAL_HEX8(0x00, info[0].addr);
+    TEST_ASSERT_EQUAL_HEX8(0x01, info[1].addr);
+    TEST_ASSERT_EQUAL(1, info[1].packets);
+
+    /* Aux replies go to the addressed unit, but the F tables do not describe them */
+    uint8_t raw38[] = {0x40, 0x00, 0x38, 0x01, 0x00, 0x02, 0x00, 24, 0x00,
+                       0x31, 0x00, 22, 0x00, 0x11, 0xAA};
+    unit_decode(raw38, sizeof(raw38), &primary);
+    raw38[1] = 0x01;
+    unit_decode(raw38, sizeof(raw38), &primary);
+    TEST_ASSERT_EQUAL(3, primary.packet_count);
+    TEST_ASSERT_EQUAL(ESP_OK, p1p2_protocol_get_unit_state(0x01, &unit));
+    TEST_ASSERT_FALSE(unit.power);
+    TEST_ASSERT_EQUAL(2, unit.packet_count);
+
+    /* Table full: further units are counted, not decoded */
+    for (uint8_t addr = 0x02; addr <= 0x09; addr++) {
+        raw_b[0] = addr;
+        unit_decode(raw_b, sizeof(raw_b), &primary);
+    }
+    TEST_ASSERT_EQUAL(1, p1p2_protocol_get_units_dropped());
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, p1p2_protocol_get_unit_state(0x09, &unit));
+    TEST_ASSERT_EQUAL(ESP_OK, p1p2_protocol_get_unit_state(0x08, &unit));
+}
+
+TEST_CASE("units: a second unit does not change the parameter store", "[decode]")
+{
+    p1p2_hvac_state_t primary;
+    memset(&primary, 0, sizeof(primary));
+    p1p2_decode_memo_reset(&test_memo);
+    p1p2_unit_map_reset();
+    p1p2_payload_store_init();
+
+    int id = p1p2_protocol_find_param(0x10, "target_temp_cool");
+    TEST_ASSERT_TRUE(id >= 0);
+    uint8_t raw_a[] = {0x00, 0x80, 0x10, 0x01, 0x00, 0x02, 0x00, 24, 0x00,
+                       0x31, 0x00, 22, 0x00, 0x11, 0xAA};
+    uint8_t raw_b[] = {0x01, 0x80, 0x10, 0x00, 0x00, 0x02, 0x00, 20, 0x00,
+                       0x31, 0x00, 22, 0x00, 0x11, 0xAA};
+    unit_decode(raw_a, sizeof(raw_a), &primary);
+    uint32_t gen = p1p2_protocol_get_param_generation();
+
+    int64_t v;
+    unit_decode(raw_b, sizeof(raw_b), &primary);
+    TEST_ASSERT_EQUAL(ESP_OK, p1p2_protocol_get_param(id, &v));
+    TEST_ASSERT_EQUAL(240, v);
+    TEST_ASSERT_EQUAL(gen, p1p2_protocol_get_param_generation());
+
+    /* The primary unit's own change still comes through */
+    raw_a[7] = 23;
+    unit_decode(raw_a, sizeof(raw_a), &primary);
+    TEST_ASSERT_EQUAL(ESP_OK, p1p2_protocol_get_param(id, &v));
+    TEST_ASSERT_EQUAL(230, v);
+}
+
+TEST_CASE("decode: E-series tables — f8.8 temperatures, request and reply layouts", "[decode]")
+{
+    p1p2_hvac_state_t state;
+    memset(&state, 0, sizeof(state));
+    p1p2_decode_select_family(P1P2_FAMILY_E);
+    p1p2_payload_store_init();
+
+    /* Heat pump reply: LWT 35.5, DHW 48.25, RWT 30.0, room 21.0, outside -2.5 */
+    uint8_t rsp11[] = {0x40, 0x00, 0x11, 0x23, 0x80, 0x30, 0x40, 0x05, 0x00, 0x1E, 0x00,
+                       0x00, 0x00, 0x00, 0x00, 0x15, 0x00, 0xFD, 0x80, 0xAA};
+    p1p2_packet_t pkt = make_packet(rsp11, sizeof(rsp11));
+    p1p2_fseries_decode_packet(&pkt, &state);
+    TEST_ASSERT_EQUAL(355, state.leaving_water_temp);
+    TEST_ASSERT_EQUAL(483, state.dhw_temp);
+    TEST_ASSERT_EQUAL(300, state.return_water_temp);
+    TEST_ASSERT_EQUAL(210, state.room_temp);
+    TEST_ASSERT_EQUAL(-25, state.outdoor_temp);     /* full-res value wins */
+
+    /* The low-res value is only a fallback: a repeat does not flip the outside temperature */
+    state.changed = 0;
+    p1p2_fseries_decode_packet(&pkt, &state);
+    TEST_ASSERT_EQUAL(0, state.changed & CHANGED_OUTDOOR_TEMP);
+
+    /* Reply too short for outside_temp: low-res value (5.0) */
+    pkt = make_packet(rsp11, 12);
+    p1p2_fseries_decode_packet(&pkt, &state);
+    TEST_ASSERT_EQUAL(50, state.outdoor_temp);
+
+    /* Controller request of the same type has its own layout */
+    uint8_t req11[] = {0x00, 0x00, 0x11, 0x15, 0x80, 0xAA};
+    pkt = make_packet(req11, sizeof(req11));
+    p1p2_fseries_decode_packet(&pkt, &state);
+    TEST_ASSERT_EQUAL(210, state.room_temp);
+    p1p2_payload_store_update(&pkt);
+    int64_t v;
+    TEST_ASSERT_EQUAL(ESP_OK, p1p2_protocol_get_param(
+        p1p2_protocol_find_param(0x11, "room_temp_controller"), &v));
+    TEST_ASSERT_EQUAL(215, v);
+
+    uint8_t rsp10[] = {0x40, 0x00, 0x10, 0x01, 0x00, 0x02, 0xAA};
+    pkt = make_packet(rsp10, sizeof(rsp10));
+    p1p2_fseries_decode_packet(&pkt, &state);
+    TEST_ASSERT_TRUE(state.power);
+    TEST_ASSERT_TRUE(state.dhw_active);
+    TEST_ASSERT_TRUE(state.data_valid);
+
+    p1p2_decode_select_family(P1P2_FAMILY_F);
+    p1p2_payload_store_init();
+}
+
+TEST_CASE("params: on-demand decode follows the latest payload", "[decode]")
+{
+    p1p2_payload_store_init();
+
+    int id = p1p2_protocol_find_param(0xA3, "compressor_starts");
+    TEST_ASSERT_TRUE(id >= 0);
+    TEST_ASSERT_EQUAL(-1, p1p2_protocol_find_param(0, "no_such_param"));
+
+    int64_t v;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, p1p2_protocol_get_param(id, &v));
+
+    uint8_t raw[] = {0x00, 0x80, 0xA3, 0, 0, 0x10, 0x00, 0, 0, 0x01, 0x2C, 0xAA};
+    p1p2_packet_t pkt = make_packet(raw, sizeof(raw));
+    p1p2_payload_store_update(&pkt);
+    TEST_ASSERT_EQUAL(ESP_OK, p1p2_protocol_get_param(id, &v));
+    TEST_ASSERT_EQUAL(300, v);
+    TEST_ASSERT_EQUAL(ESP_OK, p1p2_protocol_get_param(id, &v));  /* cached */
+    TEST_ASSERT_EQUAL(300, v);
+
+    raw[10] = 0x2D;
+    pkt = make_packet(raw, sizeof(raw));
+    p1p2_payload_store_update(&pkt);
+    TEST_ASSERT_EQUAL(ESP_OK, p1p2_protocol_get_param(id, &v));
+    TEST_ASSERT_EQUAL(301, v);
+
+    /* A reply of the same type from the aux address leaves the request's payload */
+    uint8_t rsp[] = {0x40, 0x00, 0xA3, 0, 0, 0x20, 0x00, 0, 0, 0x00, 0x01, 0xAA};
+    pkt = make_packet(rsp, sizeof(rsp));
+    p1p2_payload_store_update(&pkt);
+    TEST_ASSERT_EQUAL(ESP_OK, p1p2_protocol_get_param(id, &v));
+    TEST_ASSERT_EQUAL(301, v);
+
+    /* Short payload no longer holds the field */
+    pkt = make_packet(raw, 8);
+    p1p2_payload_store_update(&pkt);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE, p1p2_protocol_get_param(id, &v));
+}
+
+TEST_CASE("params: changes since a generation, via journal and fallback", "[decode]")
+{
+    p1p2_payload_store_init();
+
+    int hours = p1p2_protocol_find_param(0xA3, "operation_hours");
+    int starts = p1p2_protocol_find_param(0xA3, "compressor_starts");
+    uint8_t raw[] = {0x00, 0x80, 0xA3, 0, 0, 0x10, 0x00, 0, 0, 0x01, 0x2C, 0xAA};
+    p1p2_packet_t pkt = make_packet(raw, sizeof(raw));
+    p1p2_payload_store_update(&pkt);
+
+    uint32_t g0 = p1p2_protocol_get_param_generation();
+    TEST_ASSERT_EQUAL(2, g0);  /* both counters got their first value */
+
+    /* One changed counter: exactly that id */
+    uint16_t ids[4];
+    uint32_t g1;
+    raw[10]++;
+    pkt = make_packet(raw, sizeof(raw));
+    p1p2_payload_store_update(&pkt);
+    TEST_ASSERT_EQUAL(1, p1p2_protocol_params_changed_since(g0, ids, 4, &g1));
+    TEST_ASSERT_EQUAL(starts, ids[0]);
+    TEST_ASSERT_EQUAL(0, p1p2_protocol_params_changed_since(g1, ids, 4, NULL));
+
+    /* Many changes wrap the journal; the fallback still finds them once */
+    for (int i = 0; i < 100; i++) {
+        raw[10]++;
+        pkt = make_packet(raw, sizeof(raw));
+        p1p2_payload_store_update(&pkt);
+    }
+    TEST_ASSERT_EQUAL(1, p1p2_protocol_params_changed_since(g1, ids, 4, NULL));
+    TEST_ASSERT_EQUAL(starts, ids[0]);
+    TEST_ASSERT_EQUAL(2, p1p2_protocol_params_changed_since(0, ids, 4, NULL));
+
+    TEST_ASSERT_TRUE(p1p2_protocol_param_changed(hours, true));
+    TEST_ASSERT_FALSE(p1p2_protocol_param_changed(hours, false));
+
+    int64_t v;
+    TEST_ASSERT_EQUAL(ESP_OK, p1p2_protocol_get_param(starts, &v));
+    TEST_ASSERT_EQUAL(0x012C + 101, v);
+}
+
+TEST_CASE("diff: byte changes of unknown types become events, repeats fold", "[decode]")
+{
+    p1p2_diff_event_t ev[8];
+    uint32_t lost = 0;
+
+    p1p2_byte_diff_reset();
+    uint32_t cursor = p1p2_protocol_diff_seq();
+
+    /* Known types are left to the decoder */
+    uint8_t known[] = {0x00, 0x40, 0x10, 0x01, 0x02, 0x03, 0x00};
+    p1p2_packet_t pkt = make_packet(known, sizeof(known));
+    p1p2_byte_diff_observe(&pkt);
+    TEST_ASSERT_EQUAL(0, p1p2_protocol_diff_read(&cursor, ev, 8, &lost));
+
+    uint8_t raw[] = {0x00, 0x80, 0x17, 0x11, 0x22, 0xA0, 0x44, 0x00};
+    static const uint8_t byte2[] = {0xA0, 0xA0, 0xA0, 0xB0, 0xC0, 0xD0, 0xD0};
+    static const uint32_t at_ms[] = {1000, 1100, 1200, 1300, 1400, 1500, 6400};
+    for (int i = 0; i < 7; i++) {
+        raw[5] = byte2[i];
+        pkt = make_packet(raw, sizeof(raw));
+        pkt.start_us = (int64_t)at_ms[i] * 1000;
+        p1p2_byte_diff_observe(&pkt);
+    }
+    pkt.has_error = true;       /* damaged packets are not compared */
+    pkt.data[3] = 0x99;
+    p1p2_byte_diff_observe(&pkt);
+
+    /* New type, the first change at once, two more folded into one event */
+    TEST_ASSERT_EQUAL(3, p1p2_protocol_diff_read(&cursor, ev, 8, &lost));
+    TEST_ASSERT_EQUAL(0, lost);
+    TEST_ASSERT_EQUAL_HEX8(P1P2_DIFF_NEW_TYPE, ev[0].offset);
+    TEST_ASSERT_EQUAL(4, ev[0].to);
+    TEST_ASSERT_EQUAL(2, ev[1].offset);
+    TEST_ASSERT_EQUAL_HEX8(0xA0, ev[1].from);
+    TEST_ASSERT_EQUAL_HEX8(0xB0, ev[1].to);
+    TEST_ASSERT_EQUAL(1300, ev[1].time_ms);
+    TEST_ASSERT_EQUAL(2, ev[2].offset);
+    TEST_ASSERT_EQUAL_HEX8(0xB0, ev[2].from);
+    TEST_ASSERT_EQUAL_HEX8(0xD0, ev[2].to);
+    TEST_ASSERT_EQUAL(2, ev[2].changes);
+    TEST_ASSERT_EQUAL(6400, ev[2].time_ms);
+
+    /* Per-byte statistics, most frequent value first */
+    p1p2_diff_byte_t bytes[P1P2_MAX_PACKET_SIZE];
+    uint8_t len = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, p1p2_protocol_diff_bytes(0x00, 0x80, 0x17, bytes,
+                                                       P1P2_MAX_PACKET_SIZE, &len));
+    TEST_ASSERT_EQUAL(4, len);
+    TEST_ASSERT_EQUAL(0, bytes[0].changes);
+    TEST_ASSERT_EQUAL(7, bytes[0].top_count[0]);
+    TEST_ASSERT_EQUAL(3, bytes[2].changes);
+    TEST_ASSERT_EQUAL_HEX8(0xD0, bytes[2].value);
+    TEST_ASSERT_EQUAL_HEX8(0xA0, bytes[2].top_value[0]);
+    TEST_ASSERT_EQUAL(3, bytes[2].top_count[0]);
+    TEST_ASSERT_EQUAL_HEX8(0xD0, bytes[2].top_value[1]);
+    TEST_ASSERT_EQUAL(2, bytes[2].top_count[1]);
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, p1p2_protocol_diff_bytes(0x80, 0x00, 0x17, bytes,
+                                                                  P1P2_MAX_PACKET_SIZE, &len));
+
+    /* A change within the holdoff, then the type goes quiet: the tick reports it */
+    raw[5] = 0xE0;
+    pkt = make_packet(raw, sizeof(raw));
+    pkt.start_us = 6500000;
+    p1p2_byte_diff_observe(&pkt);
+    p1p2_byte_diff_tick(11300000);
+    TEST_ASSERT_EQUAL(0, p1p2_protocol_diff_read(&cursor, ev, 8, &lost));
+    p1p2_byte_diff_tick(11400000);
+    TEST_ASSERT_EQUAL(1, p1p2_protocol_diff_read(&cursor, ev, 8, &lost));
+    TEST_ASSERT_EQUAL_HEX8(0xD0, ev[0].from);
+    TEST_ASSERT_EQUAL_HEX8(0xE0, ev[0].to);
+    TEST_ASSERT_EQUAL(11400, ev[0].time_ms);
+}
+
 /* ================================================================
  * CONTROL RESPONSE TESTS — Original
  * ================================================================ */
 
 TEST_CASE("control: BCL 0x38 response — echo back state", "[control]")
 {
-    p1p2_fseries_control_init(F_MODEL_BCL);
+    p1p2_fseries_control_init(&test_ctrl, F_MODEL_BCL);
 
     /* Simulated 0x38 request from indoor unit (18+ bytes) */
     uint8_t rb[24] = {0};
@@ -553,7 +936,7 @@ TEST_CASE("control: BCL 0x38 response — echo back state", "[control]")
     rb[18] = 0x03;  /* fan mode */
 
     uint8_t wb[24] = {0};
-    uint8_t len = p1p2_fseries_build_response_38(rb, 20, wb, sizeof(wb));
+    uint8_t len = p1p2_fseries_build_response_38(&test_ctrl, rb, 20, wb, sizeof(wb));
 
     TEST_ASSERT_EQUAL(18, len);
     TEST_ASSERT_EQUAL(P1P2_ADDR_AUX_CTRL, wb[0]);  /* src = aux */
@@ -566,7 +949,7 @@ TEST_CASE("control: BCL 0x38 response — echo back state", "[control]")
 
 TEST_CASE("control: P model 0x38 response is 20 bytes", "[control]")
 {
-    p1p2_fseries_control_init(F_MODEL_P);
+    p1p2_fseries_control_init(&test_ctrl, F_MODEL_P);
 
     uint8_t rb[24] = {0};
     rb[0] = 0x00; rb[1] = 0x40; rb[2] = 0x38;
@@ -576,15 +959,61 @@ TEST_CASE("control: P model 0x38 response is 20 bytes", "[control]")
     rb[14] = 0x00; rb[18] = 0x00;
 
     uint8_t wb[24] = {0};
-    uint8_t len = p1p2_fseries_build_response_38(rb, 20, wb, sizeof(wb));
+    uint8_t len = p1p2_fseries_build_response_38(&test_ctrl, rb, 20, wb, sizeof(wb));
 
     TEST_ASSERT_EQUAL(20, len);
     TEST_ASSERT_EQUAL(P1P2_ADDR_AUX_CTRL, wb[0]);
 }
 
+TEST_CASE("control: model detected from 0x38/0x3A/0x3B requests", "[control]")
+{
+    uint8_t rb[24] = {0};
+    rb[0] = 0x00; rb[1] = 0x40;
+    uint8_t wb[24] = {0};
+    p1p2_packet_t pkt;
+
+    /* Unknown model: no 0x38 answer, commands refused */
+    p1p2_fseries_control_init(&test_ctrl, F_MODEL_AUTO);
+    p1p2_fseries_model_detect_start(&test_ctrl);
+    rb[2] = 0x38;
+    TEST_ASSERT_EQUAL(0, p1p2_fseries_build_response_38(&test_ctrl, rb, 20, wb, sizeof(wb)));
+    p1p2_control_cmd_t cmd = { .type = P1P2_CMD_SET_POWER, .value = 1 };
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, p1p2_fseries_apply_command(&test_ctrl, &cmd));
+
+    /* 0x3A seen, then 0x38: model P */
+    rb[2] = 0x3A;
+    pkt = make_packet(rb, 12);
+    TEST_ASSERT_EQUAL(F_MODEL_AUTO, p1p2_fseries_model_observe(&test_ctrl, &pkt));
+    rb[2] = 0x38;
+    pkt = make_packet(rb, 20);
+    TEST_ASSERT_EQUAL(F_MODEL_P, p1p2_fseries_model_observe(&test_ctrl, &pkt));
+    TEST_ASSERT_EQUAL(20, p1p2_fseries_build_response_38(&test_ctrl, rb, 20, wb, sizeof(wb)));
+
+    /* Saved model confirmed: nothing new to persist */
+    p1p2_fseries_control_init(&test_ctrl, F_MODEL_M);
+    p1p2_fseries_model_detect_start(&test_ctrl);
+    rb[2] = 0x3B;
+    pkt = make_packet(rb, 22);
+    TEST_ASSERT_EQUAL(F_MODEL_AUTO, p1p2_fseries_model_observe(&test_ctrl, &pkt));
+    TEST_ASSERT_EQUAL(F_MODEL_M, p1p2_fseries_control_get_model(&test_ctrl));
+
+    /* Only 0x38, and a short request that no model can answer: BCL after a rotation */
+    p1p2_fseries_control_init(&test_ctrl, F_MODEL_AUTO);
+    p1p2_fseries_model_detect_start(&test_ctrl);
+    rb[2] = 0x38;
+    pkt = make_packet(rb, 10);
+    TEST_ASSERT_EQUAL(F_MODEL_AUTO, p1p2_fseries_model_observe(&test_ctrl, &pkt));
+    pkt = make_packet(rb, 20);
+    for (int i = 0; i < 15; i++) {
+        TEST_ASSERT_EQUAL(F_MODEL_AUTO, p1p2_fseries_model_observe(&test_ctrl, &pkt));
+    }
+    TEST_ASSERT_EQUAL(F_MODEL_BCL, p1p2_fseries_model_observe(&test_ctrl, &pkt));
+    TEST_ASSERT_EQUAL(F_MODEL_AUTO, p1p2_fseries_model_observe(&test_ctrl, &pkt));  /* done */
+}
+
 TEST_CASE("control: M model uses 0x3B, 22-byte response", "[control]")
 {
-    p1p2_fseries_control_init(F_MODEL_M);
+    p1p2_fseries_control_init(&test_ctrl, F_MODEL_M);
 
     uint8_t rb[24] = {0};
     rb[0] = 0x00; rb[1] = 0x40; rb[2] = 0x3B;
@@ -595,7 +1024,7 @@ TEST_CASE("control: M model uses 0x3B, 22-byte response", "[control]")
     rb[21] = 0x01; /* fan mode */
 
     uint8_t wb[24] = {0};
-    uint8_t len = p1p2_fseries_build_response_3b(rb, 22, wb, sizeof(wb));
+    uint8_t len = p1p2_fseries_build_response_3b(&test_ctrl, rb, 22, wb, sizeof(wb));
 
     TEST_ASSERT_EQUAL(22, len);
     TEST_ASSERT_EQUAL(0x07, wb[19]); /* zones echoed */
@@ -604,39 +1033,39 @@ TEST_CASE("control: M model uses 0x3B, 22-byte response", "[control]")
 
 TEST_CASE("control: M model rejects 0x38", "[control]")
 {
-    p1p2_fseries_control_init(F_MODEL_M);
+    p1p2_fseries_control_init(&test_ctrl, F_MODEL_M);
 
     uint8_t rb[24] = {0};
     rb[0] = 0x00; rb[1] = 0x40; rb[2] = 0x38;
     rb[3] = 0x01;
 
     uint8_t wb[24] = {0};
-    uint8_t len = p1p2_fseries_build_response_38(rb, 20, wb, sizeof(wb));
+    uint8_t len = p1p2_fseries_build_response_38(&test_ctrl, rb, 20, wb, sizeof(wb));
 
     TEST_ASSERT_EQUAL(0, len); /* model M doesn't use 0x38 */
 }
 
 TEST_CASE("control: BCL model rejects 0x3B", "[control]")
 {
-    p1p2_fseries_control_init(F_MODEL_BCL);
+    p1p2_fseries_control_init(&test_ctrl, F_MODEL_BCL);
 
     uint8_t rb[24] = {0};
     rb[0] = 0x00; rb[1] = 0x40; rb[2] = 0x3B;
     rb[3] = 0x01;
 
     uint8_t wb[24] = {0};
-    uint8_t len = p1p2_fseries_build_response_3b(rb, 22, wb, sizeof(wb));
+    uint8_t len = p1p2_fseries_build_response_3b(&test_ctrl, rb, 22, wb, sizeof(wb));
 
     TEST_ASSERT_EQUAL(0, len);
 }
 
 TEST_CASE("control: empty response (0x35/0x36/0x37)", "[control]")
 {
-    p1p2_fseries_control_init(F_MODEL_BCL);
+    p1p2_fseries_control_init(&test_ctrl, F_MODEL_BCL);
 
     uint8_t rb[] = {0x00, 0x40, 0x35, 0xAA};
     uint8_t wb[24] = {0};
-    uint8_t len = p1p2_fseries_build_response_empty(rb, sizeof(rb), wb, sizeof(wb));
+    uint8_t len = p1p2_fseries_build_response_empty(&test_ctrl, rb, sizeof(rb), wb, sizeof(wb));
 
     TEST_ASSERT_EQUAL(3, len);
     TEST_ASSERT_EQUAL(P1P2_ADDR_AUX_CTRL, wb[0]);
@@ -649,14 +1078,14 @@ TEST_CASE("control: empty response (0x35/0x36/0x37)", "[control]")
 
 TEST_CASE("control: pending write applies to response", "[control][write]")
 {
-    p1p2_fseries_control_init(F_MODEL_BCL);
+    p1p2_fseries_control_init(&test_ctrl, F_MODEL_BCL);
 
     /* Queue a temperature change: cool temp = 26C */
     p1p2_control_cmd_t cmd = {
         .type = P1P2_CMD_SET_TEMP_COOL,
         .value = 260, /* 26.0C × 10 */
     };
-    esp_err_t ret = p1p2_fseries_apply_command(&cmd);
+    esp_err_t ret = p1p2_fseries_apply_command(&test_ctrl, &cmd);
     TEST_ASSERT_EQUAL(ESP_OK, ret);
 
     /* Build response */
@@ -668,7 +1097,7 @@ TEST_CASE("control: pending write applies to response", "[control][write]")
     rb[14] = 0x00; rb[18] = 0x00;
 
     uint8_t wb[24] = {0};
-    uint8_t len = p1p2_fseries_build_response_38(rb, 20, wb, sizeof(wb));
+    uint8_t len = p1p2_fseries_build_response_38(&test_ctrl, rb, 20, wb, sizeof(wb));
 
     TEST_ASSERT_EQUAL(18, len);
     TEST_ASSERT_EQUAL(26, wb[5]); /* temperature overridden to 26C */
@@ -676,13 +1105,13 @@ TEST_CASE("control: pending write applies to response", "[control][write]")
 
 TEST_CASE("control: apply power command", "[control][write]")
 {
-    p1p2_fseries_control_init(F_MODEL_BCL);
+    p1p2_fseries_control_init(&test_ctrl, F_MODEL_BCL);
 
     p1p2_control_cmd_t cmd = {
         .type = P1P2_CMD_SET_POWER,
         .value = 0, /* power OFF */
     };
-    esp_err_t ret = p1p2_fseries_apply_command(&cmd);
+    esp_err_t ret = p1p2_fseries_apply_command(&test_ctrl, &cmd);
     TEST_ASSERT_EQUAL(ESP_OK, ret);
 
     uint8_t rb[24] = {0};
@@ -693,7 +1122,7 @@ TEST_CASE("control: apply power command", "[control][write]")
     rb[14] = 0x00; rb[18] = 0x00;
 
     uint8_t wb[24] = {0};
-    p1p2_fseries_build_response_38(rb, 20, wb, sizeof(wb));
+    p1p2_fseries_build_response_38(&test_ctrl, rb, 20, wb, sizeof(wb));
 
     TEST_ASSERT_EQUAL(0x00, wb[3]); /* power overridden to OFF */
 }
@@ -704,13 +1133,13 @@ TEST_CASE("control: apply power command", "[control][write]")
 
 TEST_CASE("control: DHW power command", "[control][write]")
 {
-    p1p2_fseries_control_init(F_MODEL_BCL);
+    p1p2_fseries_control_init(&test_ctrl, F_MODEL_BCL);
 
     p1p2_control_cmd_t cmd = {
         .type = P1P2_CMD_SET_DHW_POWER,
         .value = 1,
     };
-    esp_err_t ret = p1p2_fseries_apply_command(&cmd);
+    esp_err_t ret = p1p2_fseries_apply_command(&test_ctrl, &cmd);
     TEST_ASSERT_EQUAL(ESP_OK, ret);
 
     /* Build response and verify DHW power offset is written */
@@ -721,7 +1150,7 @@ TEST_CASE("control: DHW power command", "[control][write]")
     rb[14] = 0x00; rb[18] = 0x00;
 
     uint8_t wb[24] = {0};
-    p1p2_fseries_build_response_38(rb, 20, wb, sizeof(wb));
+    p1p2_fseries_build_response_38(&test_ctrl, rb, 20, wb, sizeof(wb));
 
     /* DHW power is at payload offset F38_RSP_DHW_POWER (10), so wb[3+10] = wb[13] */
     TEST_ASSERT_EQUAL(0x01, wb[3 + F38_RSP_DHW_POWER]);
@@ -729,13 +1158,13 @@ TEST_CASE("control: DHW power command", "[control][write]")
 
 TEST_CASE("control: DHW temperature command", "[control][write]")
 {
-    p1p2_fseries_control_init(F_MODEL_BCL);
+    p1p2_fseries_control_init(&test_ctrl, F_MODEL_BCL);
 
     p1p2_control_cmd_t cmd = {
         .type = P1P2_CMD_SET_DHW_TEMP,
         .value = 550, /* 55.0C × 10 */
     };
-    esp_err_t ret = p1p2_fseries_apply_command(&cmd);
+    esp_err_t ret = p1p2_fseries_apply_command(&test_ctrl, &cmd);
     TEST_ASSERT_EQUAL(ESP_OK, ret);
 
     uint8_t rb[24] = {0};
@@ -745,7 +1174,7 @@ TEST_CASE("control: DHW temperature command", "[control][write]")
     rb[14] = 0x00; rb[18] = 0x00;
 
     uint8_t wb[24] = {0};
-    p1p2_fseries_build_response_38(rb, 20, wb, sizeof(wb));
+    p1p2_fseries_build_response_38(&test_ctrl, rb, 20, wb, sizeof(wb));
 
     /* DHW temp at payload offset F38_RSP_DHW_TEMP (11), so wb[3+11] = wb[14] */
     TEST_ASSERT_EQUAL(55, wb[3 + F38_RSP_DHW_TEMP]);
@@ -753,25 +1182,25 @@ TEST_CASE("control: DHW temperature command", "[control][write]")
 
 TEST_CASE("control: pending write buffer full returns ESP_ERR_NO_MEM", "[control][write]")
 {
-    p1p2_fseries_control_init(F_MODEL_BCL);
+    p1p2_fseries_control_init(&test_ctrl, F_MODEL_BCL);
 
     /* Fill all 8 pending write slots */
     for (int i = 0; i < 8; i++) {
-        esp_err_t ret = p1p2_fseries_queue_write(PKT_TYPE_CTRL_38, i, 0x42, 0x00, 3);
+        esp_err_t ret = p1p2_fseries_queue_write(&test_ctrl, PKT_TYPE_CTRL_38, i, 0x42, 0x00, 3);
         TEST_ASSERT_EQUAL(ESP_OK, ret);
     }
 
     /* 9th write should fail */
-    esp_err_t ret = p1p2_fseries_queue_write(PKT_TYPE_CTRL_38, 0, 0x99, 0x00, 3);
+    esp_err_t ret = p1p2_fseries_queue_write(&test_ctrl, PKT_TYPE_CTRL_38, 0, 0x99, 0x00, 3);
     TEST_ASSERT_EQUAL(ESP_ERR_NO_MEM, ret);
 }
 
 TEST_CASE("control: pending write retry count exhaustion", "[control][write]")
 {
-    p1p2_fseries_control_init(F_MODEL_BCL);
+    p1p2_fseries_control_init(&test_ctrl, F_MODEL_BCL);
 
     /* Queue a write with count=1 (single attempt) */
-    esp_err_t ret = p1p2_fseries_queue_write(PKT_TYPE_CTRL_38, F38_RSP_COOL_TEMP, 28, 0x00, 1);
+    esp_err_t ret = p1p2_fseries_queue_write(&test_ctrl, PKT_TYPE_CTRL_38, F38_RSP_COOL_TEMP, 28, 0x00, 1);
     TEST_ASSERT_EQUAL(ESP_OK, ret);
 
     uint8_t rb[24] = {0};
@@ -783,27 +1212,27 @@ TEST_CASE("control: pending write retry count exhaustion", "[control][write]")
     uint8_t wb[24] = {0};
 
     /* First response: write should apply */
-    p1p2_fseries_build_response_38(rb, 20, wb, sizeof(wb));
+    p1p2_fseries_build_response_38(&test_ctrl, rb, 20, wb, sizeof(wb));
     TEST_ASSERT_EQUAL(28, wb[5]); /* temp overridden */
 
     /* Second response: write should be exhausted, original value echoed */
     memset(wb, 0, sizeof(wb));
-    p1p2_fseries_build_response_38(rb, 20, wb, sizeof(wb));
+    p1p2_fseries_build_response_38(&test_ctrl, rb, 20, wb, sizeof(wb));
     TEST_ASSERT_EQUAL(24, wb[5]); /* back to original */
 }
 
 TEST_CASE("control: multiple simultaneous pending writes", "[control][write]")
 {
-    p1p2_fseries_control_init(F_MODEL_BCL);
+    p1p2_fseries_control_init(&test_ctrl, F_MODEL_BCL);
 
     /* Queue power OFF + temp change + fan change simultaneously */
     p1p2_control_cmd_t cmd_power = { .type = P1P2_CMD_SET_POWER, .value = 0 };
     p1p2_control_cmd_t cmd_temp  = { .type = P1P2_CMD_SET_TEMP_COOL, .value = 280 };
     p1p2_control_cmd_t cmd_fan   = { .type = P1P2_CMD_SET_FAN_COOL, .value = P1P2_FAN_HIGH };
 
-    TEST_ASSERT_EQUAL(ESP_OK, p1p2_fseries_apply_command(&cmd_power));
-    TEST_ASSERT_EQUAL(ESP_OK, p1p2_fseries_apply_command(&cmd_temp));
-    TEST_ASSERT_EQUAL(ESP_OK, p1p2_fseries_apply_command(&cmd_fan));
+    TEST_ASSERT_EQUAL(ESP_OK, p1p2_fseries_apply_command(&test_ctrl, &cmd_power));
+    TEST_ASSERT_EQUAL(ESP_OK, p1p2_fseries_apply_command(&test_ctrl, &cmd_temp));
+    TEST_ASSERT_EQUAL(ESP_OK, p1p2_fseries_apply_command(&test_ctrl, &cmd_fan));
 
     uint8_t rb[24] = {0};
     rb[0] = 0x00; rb[1] = 0x40; rb[2] = 0x38;
@@ -812,13 +1241,186 @@ TEST_CASE("control: multiple simultaneous pending writes", "[control][write]")
     rb[14] = 0x00; rb[18] = 0x00;
 
     uint8_t wb[24] = {0};
-    p1p2_fseries_build_response_38(rb, 20, wb, sizeof(wb));
+    p1p2_fseries_build_response_38(&test_ctrl, rb, 20, wb, sizeof(wb));
 
     TEST_ASSERT_EQUAL(0x00, wb[3]);       /* power OFF */
     TEST_ASSERT_EQUAL(28, wb[5]);         /* temp = 28C */
     TEST_ASSERT_EQUAL(F_FAN_HIGH, wb[7]); /* fan = high */
 }
 
+TEST_CASE("control: failed TX confirmation retries the write", "[control][write]")
+{
+    p1p2_fseries_control_init(&test_ctrl, F_MODEL_BCL);
+
+    esp_err_t ret = p1p2_fseries_queue_write(&test_ctrl, PKT_TYPE_CTRL_38, F38_RSP_COOL_TEMP, 28, 0x00, 1);
+    TEST_ASSERT_EQUAL(ESP_OK, ret);
+
+    uint8_t rb[24] = {0};
+    rb[0] = 0x00; rb[1] = 0x40; rb[2] = 0x38;
+    rb[3] = 0x01; rb[5] = F_MODE_COOL;
+    rb[7] = 24; rb[9] = F_FAN_LOW; rb[11] = 22; rb[13] = F_FAN_LOW;
+
+    uint8_t wb[24] = {0};
+    uint8_t len = p1p2_fseries_build_response_38(&test_ctrl, rb, 20, wb, sizeof(wb));
+    TEST_ASSERT_EQUAL(28, wb[5]);
+
+    /* Read-back of that response failed on one byte */
+    p1p2_tx_confirm_t conf;
+    memset(&conf, 0, sizeof(conf));
+    memcpy(conf.data, wb, len);
+    conf.length = len;
+    conf.errors[5] = P1P2_ERROR_BE;
+    conf.ok = false;
+    p1p2_fseries_tx_confirmed(&test_ctrl, &conf);
+
+    /* Attempt given back: the next response carries the write again */
+    memset(wb, 0, sizeof(wb));
+    p1p2_fseries_build_response_38(&test_ctrl, rb, 20, wb, sizeof(wb));
+    TEST_ASSERT_EQUAL(28, wb[5]);
+
+    /* Successful confirmation: write is done */
+    conf.ok = true;
+    conf.errors[5] = 0;
+    p1p2_fseries_tx_confirmed(&test_ctrl, &conf);
+    memset(wb, 0, sizeof(wb));
+    p1p2_fseries_build_response_38(&test_ctrl, rb, 20, wb, sizeof(wb));
+    TEST_ASSERT_EQUAL(24, wb[5]);
+}
+
+TEST_CASE("engine: contexts keep their own state, model and writes", "[control]")
+{
+    static p1p2_protocol_t a, b;
+    p1p2_engine_init(&a, F_MODEL_BCL, P1P2_CONTROL_AUX, true);
+    p1p2_engine_init(&b, F_MODEL_M, P1P2_CONTROL_OFF, true);
+
+    p1p2_control_cmd_t cmd = { .type = P1P2_CMD_SET_TEMP_COOL, .value = 270 };
+    TEST_ASSERT_EQUAL(ESP_OK, p1p2_fseries_apply_command(&a.ctrl, &cmd));
+
+    uint8_t raw[24] = {0x00, 0x40, 0x38, 0x01, 0x00, F_MODE_COOL | F_MODE_ACTIVE_MASK, 0x00,
+                       24, 0x00, F_FAN_MED, 0x00, 22, 0x00, F_FAN_LOW};
+    p1p2_packet_t pkt = make_packet(raw, 21);
+    uint8_t wb[P1P2_MAX_PACKET_SIZE];
+
+    TEST_ASSERT_EQUAL(18, p1p2_engine_process(&a, &pkt, wb, sizeof(wb)));
+    TEST_ASSERT_EQUAL(27, wb[3 + F38_RSP_COOL_TEMP]);
+    TEST_ASSERT_EQUAL(0, p1p2_engine_process(&b, &pkt, wb, sizeof(wb)));  /* not AUX */
+
+    /* Both decoded the request, each into its own state */
+    TEST_ASSERT_TRUE(a.state.power);
+    TEST_ASSERT_TRUE(b.state.power);
+    TEST_ASSERT_EQUAL(1, a.memo.decoded);
+    TEST_ASSERT_EQUAL(1, b.memo.decoded);
+    TEST_ASSERT_EQUAL(F_MODEL_BCL, p1p2_fseries_control_get_model(&a.ctrl));
+    TEST_ASSERT_EQUAL(F_MODEL_M, p1p2_fseries_control_get_model(&b.ctrl));
+    TEST_ASSERT_EQUAL(0, b.ctrl.pending_writes[0].count);
+}
+
+/* Read-back of our counter request ending at eop_us */
+static void counter_readback(int64_t eop_us, bool ok)
+{
+    p1p2_tx_confirm_t conf;
+    memset(&conf, 0, sizeof(conf));
+    conf.data[0] = 0x00;
+    conf.data[1] = 0x00;
+    conf.data[2] = 0xA3;
+    conf.length = 5;
+    conf.start_us = eop_us - 5000;
+    conf.eop_us = eop_us;
+    conf.ok = ok;
+    p1p2_counter_poll_confirmed(&conf);
+}
+
+TEST_CASE("counters: requests held back at most once per cycle, stray replies ignored", "[control]")
+{
+    p1p2_counter_poll_stats_t cs;
+
+    p1p2_protocol_reset_pair_stats();       /* no cycle measured: 1 s default */
+    p1p2_counter_poll_reset();
+    p1p2_protocol_set_counter_poll(60, 1000);
+
+    /* Nothing at start: the first request is one interval away */
+    p1p2_counter_poll_tick(10000000);
+    TEST_ASSERT_FALSE(p1p2_counter_poll_due(69900000));
+
+    /* Bus not started: the request cannot be queued and is retried a cycle later */
+    p1p2_counter_poll_tick(70000000);
+    p1p2_counter_poll_tick(70500000);
+    p1p2_protocol_get_counter_poll_stats(&cs);
+    TEST_ASSERT_EQUAL(0, cs.requests);
+    TEST_ASSERT_EQUAL(1, cs.deferred);
+    p1p2_counter_poll_tick(71000000);
+    p1p2_protocol_get_counter_poll_stats(&cs);
+    TEST_ASSERT_EQUAL(2, cs.deferred);
+
+    /* A reply nobody asked for does not count */
+    uint8_t raw[] = {0x80, 0x00, 0xA3, 0, 0, 0x12, 0x34, 0, 0, 0, 0x56};
+    p1p2_packet_t pkt = make_packet(raw, sizeof(raw));
+    pkt.start_us = 71500000;
+    p1p2_counter_poll_observe(&pkt);
+    p1p2_protocol_get_counter_poll_stats(&cs);
+    TEST_ASSERT_EQUAL(0, cs.replies);
+
+    /* Queued at 72 s, waits for its window: no timeout before the read-back */
+    TEST_ASSERT_TRUE(p1p2_counter_poll_due(72000000));
+    p1p2_counter_poll_queued(72000000, ESP_OK);
+    pkt.start_us = 72500000;                /* not ours yet: still waiting */
+    p1p2_counter_poll_observe(&pkt);
+    TEST_ASSERT_FALSE(p1p2_counter_poll_due(77900000));
+    p1p2_protocol_get_counter_poll_stats(&cs);
+    TEST_ASSERT_EQUAL(1, cs.requests);
+    TEST_ASSERT_EQUAL(0, cs.replies);
+    TEST_ASSERT_EQUAL(0, cs.timeouts);
+
+    /* On the bus at 77 s, answered: next request one interval after the reply */
+    counter_readback(77000000, true);
+    pkt.start_us = 77100000;
+    p1p2_counter_poll_observe(&pkt);
+    p1p2_protocol_get_counter_poll_stats(&cs);
+    TEST_ASSERT_EQUAL(1, cs.replies);
+    TEST_ASSERT_EQUAL(0, cs.backoff);
+    TEST_ASSERT_EQUAL(77100000, (int)cs.last_reply_us);
+    TEST_ASSERT_FALSE(p1p2_counter_poll_due(137000000));
+
+    /* No reply within 4 cycles of the read-back: timeout, retry 2 cycles later */
+    TEST_ASSERT_TRUE(p1p2_counter_poll_due(137100000));
+    p1p2_counter_poll_queued(137100000, ESP_OK);
+    counter_readback(138000000, true);
+    TEST_ASSERT_FALSE(p1p2_counter_poll_due(141900000));
+    TEST_ASSERT_FALSE(p1p2_counter_poll_due(142000000));
+    p1p2_protocol_get_counter_poll_stats(&cs);
+    TEST_ASSERT_EQUAL(1, cs.timeouts);
+    TEST_ASSERT_EQUAL(1, cs.backoff);
+    TEST_ASSERT_FALSE(p1p2_counter_poll_due(143900000));
+    TEST_ASSERT_TRUE(p1p2_counter_poll_due(144000000));
+
+    /* Our request collided: a late reply does not count, retry 4 cycles later */
+    p1p2_counter_poll_queued(144000000, ESP_OK);
+    counter_readback(145000000, false);
+    pkt.start_us = 145500000;
+    p1p2_counter_poll_observe(&pkt);
+    p1p2_protocol_get_counter_poll_stats(&cs);
+    TEST_ASSERT_EQUAL(1, cs.readback_errors);
+    TEST_ASSERT_EQUAL(1, cs.replies);
+    TEST_ASSERT_EQUAL(2, cs.backoff);
+    TEST_ASSERT_FALSE(p1p2_counter_poll_due(148900000));
+    TEST_ASSERT_TRUE(p1p2_counter_poll_due(149000000));
+
+    /* Never read back: the bus found no window and dropped it */
+    p1p2_counter_poll_queued(149000000, ESP_OK);
+    TEST_ASSERT_FALSE(p1p2_counter_poll_due(155000000));
+    p1p2_protocol_get_counter_poll_stats(&cs);
+    TEST_ASSERT_EQUAL(1, cs.unsent);
+    TEST_ASSERT_EQUAL(3, cs.backoff);
+    TEST_ASSERT_EQUAL(4, cs.requests);
+
+    /* Off: no attempts at all */
+    p1p2_protocol_set_counter_poll(0, 1000);
+    p1p2_counter_poll_tick(200000000);
+    p1p2_protocol_get_counter_poll_stats(&cs);
+    TEST_ASSERT_EQUAL(2, cs.deferred);
+    TEST_ASSERT_EQUAL(0, cs.interval_s);
+}
+
 /* ================================================================
  * CHANGE DETECTION TESTS
  * ================================================================ */
@@ -942,6 +1544,85 @@ TEST_CASE("change: counter fields set changed bits", "[change]")
     TEST_ASSERT_BITS(CHANGED_COMP_STARTS, CHANGED_COMP_STARTS, state.changed);
 }
 
+TEST_CASE("change: cursors see each change independently of each other", "[change]")
+{
+    static p1p2_protocol_t eng;
+    p1p2_engine_init(&eng, F_MODEL_BCL, P1P2_CONTROL_OFF, true);
+    p1p2_change_cursor_t a, b;
+    p1p2_hvac_state_t out;
+
+    eng.state.power = true;
+    eng.state.changed = CHANGED_POWER;
+    p1p2_engine_state_publish(&eng);
+    TEST_ASSERT_EQUAL(0, eng.state.changed);
+
+    /* from_now skips what was published before; from the start reports it */
+    p1p2_engine_cursor_init(&eng, &a, true);
+    p1p2_engine_cursor_init(&eng, &b, false);
+    TEST_ASSERT_EQUAL(0, p1p2_engine_read_changes(&eng, &a, &out));
+    TEST_ASSERT_EQUAL(CHANGED_POWER, p1p2_engine_read_changes(&eng, &b, &out));
+    TEST_ASSERT_TRUE(out.power);
+    TEST_ASSERT_EQUAL(CHANGED_POWER, out.changed);
+
+    /* One change, seen once by each cursor; a's read does not clear b's */
+    eng.state.target_temp_cool = 235;
+    eng.state.changed = CHANGED_TEMP_COOL;
+    p1p2_engine_state_publish(&eng);
+    TEST_ASSERT_EQUAL(CHANGED_TEMP_COOL, p1p2_engine_read_changes(&eng, &a, &out));
+    TEST_ASSERT_EQUAL(235, out.target_temp_cool);
+    TEST_ASSERT_EQUAL(0, p1p2_engine_read_changes(&eng, &a, &out));
+    TEST_ASSERT_EQUAL(CHANGED_TEMP_COOL, p1p2_engine_read_changes(&eng, &b, &out));
+    TEST_ASSERT_EQUAL(0, p1p2_engine_read_changes(&eng, &b, &out));
+
+    /* Changes over several publishes add up for a cursor that fell behind */
+    eng.state.power = false;
+    eng.state.changed = CHANGED_POWER;
+    p1p2_engine_state_publish(&eng);
+    TEST_ASSERT_EQUAL(CHANGED_POWER, p1p2_engine_read_changes(&eng, &a, &out));
+    eng.state.mode = P1P2_MODE_HEAT;
+    eng.state.changed = CHANGED_MODE;
+    p1p2_engine_state_publish(&eng);
+    p1p2_engine_state_publish(&eng);   /* nothing changed: same generation */
+    TEST_ASSERT_EQUAL(CHANGED_MODE, p1p2_engine_read_changes(&eng, &a, &out));
+    TEST_ASSERT_EQUAL(CHANGED_POWER | CHANGED_MODE, p1p2_engine_read_changes(&eng, &b, &out));
+    TEST_ASSERT_FALSE(out.power);
+    TEST_ASSERT_EQUAL(P1P2_MODE_HEAT, out.mode);
+
+    /* The snapshot itself: published copy and even sequence */
+    p1p2_state_pub_t snap;
+    p1p2_engine_state_read(&eng, &snap);
+    TEST_ASSERT_EQUAL(0, snap.state.changed);
+    TEST_ASSERT_EQUAL(snap.gen, snap.field_gen[__builtin_ctz(CHANGED_MODE)]);
+    TEST_ASSERT_EQUAL(0, (int)(atomic_load(&eng.state_seq) & 1));
+}
+
+/* ================================================================
+ * FIXED POINT TEST
+ * ================================================================ */
+
+TEST_CASE("fixed: integer scaling rounds half away from zero, formats sign", "[fixed]")
+{
+    TEST_ASSERT_EQUAL_INT(-50, (int)p1p2_scale_round(-5, 10, 1));
+    TEST_ASSERT_EQUAL_INT(235, (int)p1p2_scale_round(0x1780, 10, 256));   /* 23.5 °C in f8.8 */
+    TEST_ASSERT_EQUAL_INT(1, (int)p1p2_scale_round(128, 1, 256));          /* 0.5 up */
+    TEST_ASSERT_EQUAL_INT(-1, (int)p1p2_scale_round(-128, 1, 256));        /* -0.5 down */
+    TEST_ASSERT_EQUAL_INT(0, (int)p1p2_scale_round(-127, 1, 256));
+
+    char buf[32];
+    int16_t t = -5;
+    snprintf(buf, sizeof(buf), P1P2_FMT_X10, P1P2_X10(t));
+    TEST_ASSERT_EQUAL_STRING("-0.5", buf);
+    t = 235;
+    snprintf(buf, sizeof(buf), P1P2_FMT_X10, P1P2_X10(t));
+    TEST_ASSERT_EQUAL_STRING("23.5", buf);
+    t = -1205;
+    snprintf(buf, sizeof(buf), P1P2_FMT_X100, P1P2_X100(t));
+    TEST_ASSERT_EQUAL_STRING("-12.05", buf);
+
+    char col[P1P2_FMT_X10_LEN];
+    TEST_ASSERT_EQUAL_STRING("-3276.8", p1p2_fmt_x10(col, INT16_MIN));
+}
+
 /* ================================================================
  * PACKET LOGGING TEST
  * ================================================================ */
@@ -966,32 +1647,17 @@ TEST_CASE("log: hex dump does not crash", "[log]")
  * CRC TESTS — Original
  * ================================================================ */
 
-/* CRC calculation — duplicated here for testing (same as p1p2_bus.c) */
-static uint8_t test_calc_crc(const uint8_t *data, uint8_t length,
-                              uint8_t crc_gen, uint8_t crc_feed)
-{
-    uint8_t crc = crc_feed;
-    for (uint8_t i = 0; i < length; i++) {
-        uint8_t c = data[i];
-        for (uint8_t j = 0; j < 8; j++) {
-            crc = ((crc ^ c) & 0x01) ? ((crc >> 1) ^ crc_gen) : (crc >> 1);
-            c >>= 1;
-        }
-    }
-    return crc;
-}
-
 TEST_CASE("CRC: Daikin F-series polynomial 0xD9", "[crc]")
 {
     /* Known test vector: a simple status packet header */
     uint8_t data[] = {0x00, 0x00, 0x10};
-    uint8_t crc = test_calc_crc(data, 3, F_SERIES_CRC_GEN, F_SERIES_CRC_FEED);
+    uint8_t crc = p1p2_crc_calc(data, 3, F_SERIES_CRC_GEN, F_SERIES_CRC_FEED);
 
     /* CRC should be non-zero and deterministic */
     TEST_ASSERT_NOT_EQUAL(0, crc);
 
     /* Same input should always produce same CRC */
-    uint8_t crc2 = test_calc_crc(data, 3, F_SERIES_CRC_GEN, F_SERIES_CRC_FEED);
+    uint8_t crc2 = p1p2_crc_calc(data, 3, F_SERIES_CRC_GEN, F_SERIES_CRC_FEED);
     TEST_ASSERT_EQUAL(crc, crc2);
 }
 
@@ -999,14 +1665,324 @@ TEST_CASE("CRC: full packet CRC should verify to 0", "[crc]")
 {
     /* Build a packet with valid CRC appended */
     uint8_t data[] = {0x00, 0x00, 0x10, 0x01, 0x00};
-    uint8_t crc = test_calc_crc(data, 4, F_SERIES_CRC_GEN, F_SERIES_CRC_FEED);
+    uint8_t crc = p1p2_crc_calc(data, 4, F_SERIES_CRC_GEN, F_SERIES_CRC_FEED);
     data[4] = crc;
 
     /* CRC over entire packet (including CRC byte) should be 0 for Daikin */
-    uint8_t verify = test_calc_crc(data, 5, F_SERIES_CRC_GEN, F_SERIES_CRC_FEED);
+    uint8_t verify = p1p2_crc_calc(data, 5, F_SERIES_CRC_GEN, F_SERIES_CRC_FEED);
     TEST_ASSERT_EQUAL(0, verify);
 }
 
+/* ================================================================
+ * QUEUE POLICY TESTS
+ * ================================================================ */
+
+TEST_CASE("queues: drop newest, drop oldest and block on a full queue", "[queue]")
+{
+    QueueHandle_t q = xQueueCreate(2, sizeof(uint32_t));
+    TEST_ASSERT_NOT_NULL(q);
+    uint32_t v, old = 0;
+    uint8_t evicted;
+
+    /* Room left: every policy queues without evicting */
+    v = 1;
+    TEST_ASSERT_EQUAL(ESP_OK, p1p2_queue_post(q, &v, P1P2_QUEUE_DROP_NEWEST, 0, &old, &evicted));
+    TEST_ASSERT_EQUAL(0, evicted);
+    v = 2;
+    TEST_ASSERT_EQUAL(ESP_OK, p1p2_queue_post(q, &v, P1P2_QUEUE_DROP_OLDEST, 0, &old, &evicted));
+    TEST_ASSERT_EQUAL(0, evicted);
+
+    /* Full: drop newest and block (after its timeout) refuse the new item */
+    v = 3;
+    TEST_ASSERT_EQUAL(ESP_ERR_TIMEOUT, p1p2_queue_post(q, &v, P1P2_QUEUE_DROP_NEWEST, 0, &old, &evicted));
+    TEST_ASSERT_EQUAL(0, evicted);
+    TEST_ASSERT_EQUAL(ESP_ERR_TIMEOUT, p1p2_queue_post(q, &v, P1P2_QUEUE_BLOCK, 1, &old, &evicted));
+    TEST_ASSERT_EQUAL(0, evicted);
+
+    /* Full: drop oldest hands back the oldest item and keeps the order */
+    TEST_ASSERT_EQUAL(ESP_OK, p1p2_queue_post(q, &v, P1P2_QUEUE_DROP_OLDEST, 0, &old, &evicted));
+    TEST_ASSERT_EQUAL(1, evicted);
+    TEST_ASSERT_EQUAL(1, old);
+    TEST_ASSERT_EQUAL(pdTRUE, xQueueReceive(q, &v, 0));
+    TEST_ASSERT_EQUAL(2, v);
+    TEST_ASSERT_EQUAL(pdTRUE, xQueueReceive(q, &v, 0));
+    TEST_ASSERT_EQUAL(3, v);
+
+    /* Block queues once there is room */
+    TEST_ASSERT_EQUAL(ESP_OK, p1p2_queue_post(q, &v, P1P2_QUEUE_BLOCK, 1, &old, &evicted));
+    TEST_ASSERT_EQUAL(1, uxQueueMessagesWaiting(q));
+    vQueueDelete(q);
+}
+
+/* ================================================================
+ * TRAFFIC STATISTICS TESTS
+ * ================================================================ */
+
+TEST_CASE("hist: log2 buckets and percentiles", "[stats]")
+{
+    p1p2_hist_t h;
+    p1p2_hist_reset(&h);
+    TEST_ASSERT_EQUAL(0, p1p2_hist_percentile(&h, 50));
+
+    TEST_ASSERT_EQUAL(0, p1p2_hist_bucket(0));
+    TEST_ASSERT_EQUAL(1, p1p2_hist_bucket(1));
+    TEST_ASSERT_EQUAL(11, p1p2_hist_bucket(1024));
+    TEST_ASSERT_EQUAL(P1P2_HIST_BUCKETS - 1, p1p2_hist_bucket(0xFFFFFFFF));
+
+    /* 9 samples around 25 ms, one outlier around 1 s */
+    for (int i = 0; i < 9; i++) p1p2_hist_add(&h, 25000);
+    p1p2_hist_add(&h, 1000000);
+    TEST_ASSERT_EQUAL(10, p1p2_hist_count(&h));
+    TEST_ASSERT_EQUAL(32767, p1p2_hist_percentile(&h, 50));   /* [16384, 32768) */
+    TEST_ASSERT_EQUAL(1048575, p1p2_hist_percentile(&h, 99));
+}
+
+TEST_CASE("traffic: per-key counts, lengths and gaps", "[stats]")
+{
+    TEST_ASSERT_EQUAL(ESP_OK, p1p2_traffic_stats_init());
+
+    uint8_t req[] = {0x00, 0x40, 0x38, 0x01, 0x02};
+    uint8_t rsp[] = {0x40, 0x00, 0x38, 0x01, 0x02, 0x03};
+    int64_t t = 1000000;
+
+    for (int i = 0; i < 3; i++) {
+        p1p2_packet_t p = make_packet(req, sizeof(req));
+        p.start_us = t;
+        p.eop_us = t + 6000;
+        p1p2_traffic_stats_record(&p);
+
+        p1p2_packet_t r = make_packet(rsp, sizeof(rsp));
+        r.start_us = t + 31000;         /* 25 ms after request EOP */
+        r.eop_us = t + 38000;
+        r.has_error = (i == 2);
+        p1p2_traffic_stats_record(&r);
+
+        t += 1000000;                   /* 1 s cycle */
+    }
+
+    p1p2_traffic_entry_t e;
+    int found = 0;
+    for (int i = 0; p1p2_traffic_stats_get(i, &e); i++) {
+        if (e.src == 0x40 && e.type == 0x38) {
+            found++;
+            TEST_ASSERT_EQUAL(3, e.count);
+            TEST_ASSERT_EQUAL(1, e.errors);
+            TEST_ASSERT_EQUAL(6, e.len_min);
+            TEST_ASSERT_EQUAL(6, e.len_max);
+            TEST_ASSERT_EQUAL(3, p1p2_hist_count(&e.gap_us));
+            TEST_ASSERT_EQUAL(p1p2_hist_bucket(25000), p1p2_hist_bucket(p1p2_hist_percentile(&e.gap_us, 50)));
+            TEST_ASSERT_EQUAL(2, p1p2_hist_count(&e.period_us));
+            TEST_ASSERT_EQUAL(p1p2_hist_bucket(1000000), p1p2_hist_bucket(p1p2_hist_percentile(&e.period_us, 50)));
+        } else if (e.src == 0x00 && e.type == 0x38) {
+            found++;
+            TEST_ASSERT_EQUAL(3, e.count);
+            TEST_ASSERT_EQUAL(0, e.errors);
+            TEST_ASSERT_EQUAL(15, e.len_sum);
+        }
+    }
+    TEST_ASSERT_EQUAL(2, found);
+
+    p1p2_traffic_stats_reset();
+    TEST_ASSERT_FALSE(p1p2_traffic_stats_get(0, &e));
+}
+
+TEST_CASE("pairs: latency per request stream and cycle period", "[stats]")
+{
+    p1p2_protocol_reset_pair_stats();
+
+    uint8_t req10[] = {0x00, 0x80, 0x10};
+    uint8_t rsp10[] = {0x80, 0x00, 0x10};
+    uint8_t req38[] = {0x00, 0x40, 0x38};
+    uint8_t rsp38[] = {0x40, 0x00, 0x38};
+    int64_t t = 1000000;
+
+    for (int i = 0; i < 4; i++) {
+        /* Indoor unit answers 0x10 after 30 ms */
+        p1p2_pair_stats_record(req10, 3, t, t + 5000);
+        p1p2_pair_stats_record(rsp10, 3, t + 35000, t + 40000);
+        /* 0x38 answered after 5 ms, except the last one */
+        p1p2_pair_stats_record(req38, 3, t + 100000, t + 105000);
+        if (i < 3) p1p2_pair_stats_record(rsp38, 3, t + 110000, t + 115000);
+        t += 800000;                    /* 800 ms cycle */
+    }
+
+    p1p2_pair_stats_t ps;
+    int found = 0;
+    for (int i = 0; p1p2_protocol_get_pair_stats(i, &ps); i++) {
+        if (ps.type == 0x10) {
+            found++;
+            TEST_ASSERT_EQUAL_HEX8(0x80, ps.responder);
+            TEST_ASSERT_EQUAL(4, ps.requests);
+            TEST_ASSERT_EQUAL(4, ps.answered);
+            TEST_ASSERT_EQUAL(p1p2_hist_bucket(30000),
+                              p1p2_hist_bucket(p1p2_hist_percentile(&ps.latency_us, 50)));
+        } else if (ps.type == 0x38) {
+            found++;
+            TEST_ASSERT_EQUAL_HEX8(0x40, ps.responder);
+            TEST_ASSERT_EQUAL(4, ps.requests);
+            TEST_ASSERT_EQUAL(3, ps.answered);
+            TEST_ASSERT_EQUAL(p1p2_hist_bucket(5000),
+                              p1p2_hist_bucket(p1p2_hist_percentile(&ps.latency_us, 99)));
+        }
+    }
+    TEST_ASSERT_EQUAL(2, found);
+
+    /* The last 0x38 counts as unanswered once the next request arrives */
+    p1p2_pair_stats_record(req10, 3, t, t + 5000);
+    for (int i = 0; p1p2_protocol_get_pair_stats(i, &ps); i++) {
+        if (ps.type == 0x38) TEST_ASSERT_EQUAL(1, ps.unanswered);
+    }
+
+    /* Cycle anchored on 0x10: four 800 ms periods */
+    p1p2_hist_t cycle;
+    uint8_t anchor;
+    TEST_ASSERT_EQUAL(4, p1p2_protocol_get_cycle_stats(&cycle, &anchor));
+    TEST_ASSERT_EQUAL_HEX8(0x10, anchor);
+    TEST_ASSERT_EQUAL(p1p2_hist_bucket(800000), p1p2_hist_bucket(p1p2_hist_percentile(&cycle, 50)));
+
+    p1p2_protocol_reset_pair_stats();
+    TEST_ASSERT_FALSE(p1p2_protocol_get_pair_stats(0, &ps));
+}
+
+TEST_CASE("clock: 0x12 date/time anchored on the minute rollover", "[stats]")
+{
+    /* 2026-10-18 (Sunday) 14:03, then 14:04 */
+    uint8_t pkt[] = {0x00, 0x00, 0x12, 0x00, 0x06, 14, 3, 26, 10, 18};
+    const int64_t t14_04 = 1792332240LL * 1000000;
+    p1p2_clock_info_t ci;
+    int64_t unix_us;
+
+    p1p2_protocol_reset_clock();
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, p1p2_protocol_clock_to_unix(0, &unix_us));
+
+    /* Only the main controller's packet counts */
+    pkt[0] = 0x80;
+    p1p2_bus_clock_observe(pkt, sizeof(pkt), 1000000);
+    p1p2_protocol_get_clock_info(&ci);
+    TEST_ASSERT_EQUAL(P1P2_CLOCK_NONE, ci.sync);
+    pkt[0] = 0x00;
+
+    /* First packet: coarse, placed mid-minute */
+    p1p2_bus_clock_observe(pkt, sizeof(pkt), 1000000);
+    p1p2_protocol_get_clock_info(&ci);
+    TEST_ASSERT_EQUAL(P1P2_CLOCK_COARSE, ci.sync);
+    TEST_ASSERT_EQUAL(6, ci.day_of_week);
+    TEST_ASSERT_EQUAL(ESP_OK, p1p2_protocol_clock_to_unix(1000000, &unix_us));
+    TEST_ASSERT_TRUE(unix_us == t14_04 - 30000000);
+
+    /* One packet a second; the minute changes between 21.5 s and 22.5 s */
+    for (int i = 1; i <= 20; i++) {
+        p1p2_bus_clock_observe(pkt, sizeof(pkt), 1500000 + (int64_t)i * 1000000);
+    }
+    pkt[6] = 4;
+    p1p2_bus_clock_observe(pkt, sizeof(pkt), 22500000);
+    p1p2_protocol_get_clock_info(&ci);
+    TEST_ASSERT_EQUAL(P1P2_CLOCK_SYNCED, ci.sync);
+    TEST_ASSERT_EQUAL(1, ci.rollovers);
+    TEST_ASSERT_EQUAL(500000, ci.error_us);
+    p1p2_protocol_clock_to_unix(22000000, &unix_us);
+    TEST_ASSERT_TRUE(unix_us == t14_04);
+
+    /* Same minute keeps the mapping; a clock change restarts it */
+    p1p2_bus_clock_observe(pkt, sizeof(pkt), 23500000);
+    p1p2_protocol_get_clock_info(&ci);
+    TEST_ASSERT_EQUAL(P1P2_CLOCK_SYNCED, ci.sync);
+    pkt[5] = 15;
+    p1p2_bus_clock_observe(pkt, sizeof(pkt), 24500000);
+    p1p2_protocol_get_clock_info(&ci);
+    TEST_ASSERT_EQUAL(P1P2_CLOCK_COARSE, ci.sync);
+    TEST_ASSERT_EQUAL(1, ci.jumps);
+
+    /* Out-of-range fields are counted and ignored */
+    pkt[8] = 13;
+    p1p2_bus_clock_observe(pkt, sizeof(pkt), 25500000);
+    p1p2_protocol_get_clock_info(&ci);
+    TEST_ASSERT_EQUAL(1, ci.invalid);
+    TEST_ASSERT_EQUAL(24, ci.packets);
+}
+
+TEST_CASE("schedule: idle windows predicted from the learned cycle", "[stats]")
+{
+    TEST_ASSERT_EQUAL(ESP_OK, p1p2_bus_schedule_init());
+
+    /* Cycle: 10 ms request, 20 ms gap, 12 ms reply, 20 ms gap, 8 ms packet, 400 ms gap */
+    uint8_t a[] = {0x00, 0x80, 0x10};
+    uint8_t b[] = {0x80, 0x00, 0x10};
+    uint8_t c[] = {0x00, 0x40, 0x38};
+    const uint32_t dur[3] = {10000, 12000, 8000};
+    const uint32_t gap[3] = {20000, 20000, 400000};
+    uint8_t *hdr[3] = {a, b, c};
+
+    /* Five cycles, then packet a, ending 1 ms ago */
+    int64_t now = esp_timer_get_time();
+    int64_t t = now - 1000 - 5 * 470000LL - 10000;
+    p1p2_idle_window_t w;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, p1p2_bus_next_idle_window(1000, &w));
+    for (int i = 0; i < 16; i++) {
+        p1p2_packet_t p = make_packet(hdr[i % 3], 3);
+        p.start_us = t;
+        p.eop_us = t + dur[i % 3];
+        p1p2_bus_schedule_record(&p);
+        t = p.eop_us + gap[i % 3];
+    }
+
+    /* Short write: fits in the gap after a, which is open now */
+    TEST_ASSERT_EQUAL(ESP_OK, p1p2_bus_next_idle_window(5000, &w));
+    TEST_ASSERT_EQUAL_HEX8(0x10, w.after_type);
+    TEST_ASSERT_EQUAL_HEX8(0x00, w.after_src);
+    TEST_ASSERT_TRUE(w.start_us - now < 5000);
+    TEST_ASSERT_TRUE(w.len_us >= 5000 && w.len_us <= 20000 - 2 * P1P2_SCHED_GUARD_US);
+
+    /* 50 ms write: only the end-of-cycle gap after c, 3 guard ms past its EOP */
+    TEST_ASSERT_EQUAL(ESP_OK, p1p2_bus_next_idle_window(50000, &w));
+    TEST_ASSERT_EQUAL_HEX8(0x38, w.after_type);
+    int64_t c_eop = now - 1000 + 20000 + 12000 + 20000 + 8000;
+    TEST_ASSERT_TRUE(llabs(w.start_us - (c_eop + P1P2_SCHED_GUARD_US)) < 1000);
+    TEST_ASSERT_EQUAL(400000 - 2 * P1P2_SCHED_GUARD_US, w.len_us);
+
+    /* Longer than any gap in the cycle */
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, p1p2_bus_next_idle_window(500000, &w));
+
+    p1p2_bus_schedule_reset();
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, p1p2_bus_next_idle_window(1000, &w));
+}
+
+TEST_CASE("load: busy time and TX share over the 1 min window", "[stats]")
+{
+    TEST_ASSERT_EQUAL(ESP_OK, p1p2_bus_load_init());
+
+    /* One 100 ms packet per second at 100..159 s, every other one ours */
+    uint8_t data[] = {0x00, 0x40, 0x38};
+    for (int i = 100; i < 160; i++) {
+        p1p2_packet_t p = make_packet(data, sizeof(data));
+        p.start_us = (int64_t)i * 1000000;
+        p.eop_us = p.start_us + 100000;
+        p1p2_bus_load_record(&p, (i & 1) != 0);
+    }
+
+    /* At 166 s the window holds the closed seconds 106..165 */
+    p1p2_bus_load_t load;
+    p1p2_bus_get_load_at(166LL * 1000000, &load);
+
+    TEST_ASSERT_EQUAL(0, load.load_1s);                     /* last second silent */
+    TEST_ASSERT_EQUAL(90, load.load_1m);                    /* 54 x 100 ms / 60 s */
+    TEST_ASSERT_EQUAL(500, load.tx_share_1m);
+    TEST_ASSERT_EQUAL(54, load.packets_1m);
+
+    /* A 500 ms packet of ours at 170 s, then ten minutes of silence */
+    p1p2_packet_t p = make_packet(data, sizeof(data));
+    p.start_us = 170LL * 1000000;
+    p.eop_us = p.start_us + 500000;
+    p1p2_bus_load_record(&p, true);
+    p1p2_bus_get_load_at(770LL * 1000000, &load);
+
+    /* The second in progress is closed into the 15 min window, not dropped */
+    TEST_ASSERT_EQUAL(0, load.load_1m);
+    TEST_ASSERT_EQUAL(0, load.packets_1m);
+    TEST_ASSERT_EQUAL(9, load.load_15m);                    /* 6.5 s / 11 min */
+    TEST_ASSERT_EQUAL(538, load.tx_share_15m);              /* 3.5 s of 6.5 s */
+}
+
 /* ================================================================
  * MAIN
  * ================================================================ */
@@ -1046,10 +2022,19 @@ void app_main(void)
     unity_run_test_by_name("decode: oversized packet handled safely");
     unity_run_test_by_name("decode: zero-length payload per type");
     unity_run_test_by_name("decode: unhandled packet type is safe");
+    unity_run_test_by_name("decode: 0x3B control request — shared status fields and zones");
+    unity_run_test_by_name("decode: memo skips repeats but not after another type changed state");
+    unity_run_test_by_name("units: each bus address decodes into its own state");
+    unity_run_test_by_name("units: a second unit does not change the parameter store");
+    unity_run_test_by_name("decode: E-series tables — f8.8 temperatures, request and reply layouts");
+    unity_run_test_by_name("params: on-demand decode follows the latest payload");
+    unity_run_test_by_name("params: changes since a generation, via journal and fallback");
+    unity_run_test_by_name("diff: byte changes of unknown types become events, repeats fold");
 
     /* Control response tests — original */
     unity_run_test_by_name("control: BCL 0x38 response — echo back state");
     unity_run_test_by_name("control: P model 0x38 response is 20 bytes");
+    unity_run_test_by_name("control: model detected from 0x38/0x3A/0x3B requests");
     unity_run_test_by_name("control: M model uses 0x3B, 22-byte response");
     unity_run_test_by_name("control: M model rejects 0x38");
     unity_run_test_by_name("control: BCL model rejects 0x3B");
@@ -1065,6 +2050,9 @@ void app_main(void)
     unity_run_test_by_name("control: pending write buffer full returns ESP_ERR_NO_MEM");
     unity_run_test_by_name("control: pending write retry count exhaustion");
     unity_run_test_by_name("control: multiple simultaneous pending writes");
+    unity_run_test_by_name("control: failed TX confirmation retries the write");
+    unity_run_test_by_name("engine: contexts keep their own state, model and writes");
+    unity_run_test_by_name("counters: requests held back at most once per cycle, stray replies ignored");
 
     /* Change detection tests */
     unity_run_test_by_name("change: bitmask set when value differs");
@@ -1072,10 +2060,25 @@ void app_main(void)
     unity_run_test_by_name("change: multiple fields changed in one packet");
     unity_run_test_by_name("change: bitmask cleared after read");
     unity_run_test_by_name("change: counter fields set changed bits");
+    unity_run_test_by_name("change: cursors see each change independently of each other");
+
+    /* Fixed point test */
+    unity_run_test_by_name("fixed: integer scaling rounds half away from zero, formats sign");
 
     /* Packet logging test */
     unity_run_test_by_name("log: hex dump does not crash");
 
+    /* Queue policy tests */
+    unity_run_test_by_name("queues: drop newest, drop oldest and block on a full queue");
+
+    /* Traffic statistics tests */
+    unity_run_test_by_name("hist: log2 buckets and percentiles");
+    unity_run_test_by_name("traffic: per-key counts, lengths and gaps");
+    unity_run_test_by_name("pairs: latency per request stream and cycle period");
+    unity_run_test_by_name("clock: 0x12 date/time anchored on the minute rollover");
+    unity_run_test_by_name("load: busy time and TX share over the 1 min window");
+    unity_run_test_by_name("schedule: idle windows predicted from the learned cycle");
+
     /* CRC tests */
     unity_run_test_by_name("CRC: Daikin F-series polynomial 0xD9");
     unity_run_test_by_name("CRC: full packet CRC should verify to 0");